@@ -0,0 +1,323 @@
+/*******************************************
+	MathBenchmark.cpp
+
+	Microbenchmarks for the math library -
+	measures the throughput of the matrix,
+	quaternion and vector operations used
+	by the entity update and render code
+
+	Standalone program, build with
+	GEN_HEADLESS defined from this file, the
+	Source/Math sources and the Source/Common
+	sources except CTimer.cpp and
+	MSDefines.cpp
+
+	Results are written to stdout as
+	"key: value" lines - the time per
+	operation in nanoseconds and operations
+	per second for each benchmark
+********************************************/
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+#include "BaseMath.h"
+#include "CVector3.h"
+#include "CVector4.h"
+#include "CMatrix3x3.h"
+#include "CMatrix4x4.h"
+#include "CQuaternion.h"
+#include "CQuatTransform.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Benchmark data
+//-----------------------------------------------------------------------------
+
+// Operations work through arrays of prepared inputs so results cannot be computed at compile
+// time. The arrays are small enough to stay in cache, so the benchmarks measure computation
+// rather than memory bandwidth. Must be a power of 2
+const TUInt32 kNumInputs = 1024;
+
+CMatrix4x4     AffineMatrices[kNumInputs];
+CMatrix4x4     GeneralMatrices[kNumInputs];
+CMatrix3x3     Matrices3x3[kNumInputs];
+CQuaternion    Quaternions[kNumInputs];
+CQuatTransform QuatTransforms[kNumInputs];
+CVector3       Vectors[kNumInputs];
+
+// Number of elements in each batch operation, and output arrays for them. Must be a power of 2
+const TUInt32 kBatchSize = 64;
+
+CVector3   BatchPoints[kBatchSize];
+CVector4   BatchVectors4[kBatchSize];
+CMatrix4x4 BatchMatrices[kBatchSize];
+
+// Results of each operation are combined into this value so the compiler cannot remove them
+volatile TFloat32 BenchmarkSink;
+
+
+// Fill the input arrays with random transforms and vectors. Uses a fixed seed so every run
+// uses the same inputs
+void SetupInputs()
+{
+	srand( 1 );
+	for (TUInt32 input = 0; input < kNumInputs; ++input)
+	{
+		CVector3 position( Random( -100.0f, 100.0f ), Random( -100.0f, 100.0f ), Random( -100.0f, 100.0f ) );
+		CVector3 angles( Random( -kfPi, kfPi ), Random( -kfPi, kfPi ), Random( -kfPi, kfPi ) );
+		CVector3 scale( Random( 0.5f, 2.0f ), Random( 0.5f, 2.0f ), Random( 0.5f, 2.0f ) );
+
+		AffineMatrices[input].MakeAffineEuler( position, angles, kZXY, scale );
+
+		// Perturb the final column so general (non-affine) code paths are measured
+		GeneralMatrices[input] = AffineMatrices[input];
+		GeneralMatrices[input].e03 = Random( -0.1f, 0.1f );
+		GeneralMatrices[input].e13 = Random( -0.1f, 0.1f );
+		GeneralMatrices[input].e23 = Random( -0.1f, 0.1f );
+
+		Matrices3x3[input].MakeTransformEuler( angles, kZXY, scale );
+		Quaternions[input] = CQuaternion( AffineMatrices[input] );
+		Quaternions[input].Normalise();
+		QuatTransforms[input] = CQuatTransform( Quaternions[input], position, scale );
+		Vectors[input] = position;
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Benchmark running
+//-----------------------------------------------------------------------------
+
+// Run the given operation the given number of times, repeating the whole run several times and
+// keeping the fastest to reduce noise. The operation is passed the index of the inputs to use.
+// Outputs the time per operation in nanoseconds and the operations per second
+template <class TOperation>
+void RunBenchmark( const string& name, TUInt32 numOps, TUInt32 numRepeats, TOperation operation )
+{
+	double bestSeconds = 0.0;
+	for (TUInt32 repeat = 0; repeat < numRepeats; ++repeat)
+	{
+		chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+		for (TUInt32 op = 0; op < numOps; ++op)
+		{
+			operation( op & (kNumInputs - 1) );
+		}
+		chrono::duration<double> runTime = chrono::steady_clock::now() - startTime;
+
+		if (repeat == 0 || runTime.count() < bestSeconds)
+		{
+			bestSeconds = runTime.count();
+		}
+	}
+
+	cout << name << "_ns_per_op: " << bestSeconds * 1.0e9 / numOps << endl;
+	cout << name << "_ops_per_second: " << (bestSeconds > 0.0 ? numOps / bestSeconds : 0.0) << endl;
+}
+
+
+// Run all the math benchmarks
+void RunMathBenchmarks( TUInt32 numOps, TUInt32 numRepeats )
+{
+	SetupInputs();
+
+	cout << "ops: " << numOps << endl;
+	cout << "repeats: " << numRepeats << endl;
+
+	// Matrix multiplication, as used to combine entity node matrices
+	RunBenchmark( "matrix4x4_multiply", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix4x4 m = GeneralMatrices[input] * GeneralMatrices[(input + 1) & (kNumInputs - 1)];
+		BenchmarkSink = m.e00;
+	});
+	RunBenchmark( "matrix4x4_multiply_affine", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix4x4 m = MultiplyAffine( AffineMatrices[input], AffineMatrices[(input + 1) & (kNumInputs - 1)] );
+		BenchmarkSink = m.e00;
+	});
+	RunBenchmark( "matrix4x4_transform_vector4", numOps, numRepeats, []( TUInt32 input )
+	{
+		CVector4 v = CVector4( Vectors[input], 1.0f ) * AffineMatrices[input];
+		BenchmarkSink = v.x;
+	});
+	RunBenchmark( "matrix4x4_transform_point", numOps, numRepeats, []( TUInt32 input )
+	{
+		CVector3 p = AffineMatrices[input].TransformPoint( Vectors[input] );
+		BenchmarkSink = p.x;
+	});
+	RunBenchmark( "matrix4x4_transform_vector", numOps, numRepeats, []( TUInt32 input )
+	{
+		CVector3 v = AffineMatrices[input].TransformVector( Vectors[input] );
+		BenchmarkSink = v.x;
+	});
+
+	// Batch transforms, each operation transforms kBatchSize points or matrices. The loop
+	// versions do the same work with the single transforms for comparison
+	RunBenchmark( "matrix4x4_transform_points_loop", numOps, numRepeats, []( TUInt32 input )
+	{
+		const CVector3* points = &Vectors[input & (kNumInputs - kBatchSize)];
+		for (TUInt32 point = 0; point < kBatchSize; ++point)
+		{
+			BatchPoints[point] = AffineMatrices[input].TransformPoint( points[point] );
+		}
+		BenchmarkSink = BatchPoints[0].x;
+	});
+	RunBenchmark( "matrix4x4_transform_points_batch", numOps, numRepeats, []( TUInt32 input )
+	{
+		TransformPoints( AffineMatrices[input], &Vectors[input & (kNumInputs - kBatchSize)], BatchPoints, kBatchSize );
+		BenchmarkSink = BatchPoints[0].x;
+	});
+	RunBenchmark( "matrix4x4_project_points_loop", numOps, numRepeats, []( TUInt32 input )
+	{
+		const CVector3* points = &Vectors[input & (kNumInputs - kBatchSize)];
+		for (TUInt32 point = 0; point < kBatchSize; ++point)
+		{
+			BatchVectors4[point] = CVector4( points[point], 1.0f ) * GeneralMatrices[input];
+		}
+		BenchmarkSink = BatchVectors4[0].w;
+	});
+	RunBenchmark( "matrix4x4_project_points_batch", numOps, numRepeats, []( TUInt32 input )
+	{
+		TransformPoints( GeneralMatrices[input], &Vectors[input & (kNumInputs - kBatchSize)], BatchVectors4, kBatchSize );
+		BenchmarkSink = BatchVectors4[0].w;
+	});
+	RunBenchmark( "matrix4x4_multiply_loop", numOps, numRepeats, []( TUInt32 input )
+	{
+		TUInt32 first = input & (kNumInputs - kBatchSize);
+		for (TUInt32 matrix = 0; matrix < kBatchSize; ++matrix)
+		{
+			BatchMatrices[matrix] = GeneralMatrices[first + matrix] * AffineMatrices[first + matrix];
+		}
+		BenchmarkSink = BatchMatrices[0].e00;
+	});
+	RunBenchmark( "matrix4x4_multiply_batch", numOps, numRepeats, []( TUInt32 input )
+	{
+		TUInt32 first = input & (kNumInputs - kBatchSize);
+		MultiplyMatrices( &GeneralMatrices[first], &AffineMatrices[first], BatchMatrices, kBatchSize );
+		BenchmarkSink = BatchMatrices[0].e00;
+	});
+	RunBenchmark( "vector3_expand_bounds", numOps, numRepeats, []( TUInt32 input )
+	{
+		CVector3 minBounds = CVector3::kZero, maxBounds = CVector3::kZero;
+		TFloat32 maxLength = 0.0f;
+		ExpandBounds( &Vectors[input & (kNumInputs - kBatchSize)], sizeof(CVector3), kBatchSize,
+		              &minBounds, &maxBounds, &maxLength );
+		BenchmarkSink = maxLength;
+	});
+
+	// Inverses
+	RunBenchmark( "matrix4x4_inverse", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix4x4 m = Inverse( GeneralMatrices[input] );
+		BenchmarkSink = m.e00;
+	});
+	RunBenchmark( "matrix4x4_inverse_affine", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix4x4 m = InverseAffine( AffineMatrices[input] );
+		BenchmarkSink = m.e00;
+	});
+
+	// Affine matrix construction and decomposition
+	RunBenchmark( "matrix4x4_face_target", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix4x4 m = AffineMatrices[input];
+		m.FaceTarget( Vectors[(input + 1) & (kNumInputs - 1)] );
+		BenchmarkSink = m.e00;
+	});
+	RunBenchmark( "matrix4x4_decompose_affine_euler", numOps, numRepeats, []( TUInt32 input )
+	{
+		CVector3 position, angles, scale;
+		AffineMatrices[input].DecomposeAffineEuler( &position, &angles, &scale );
+		BenchmarkSink = angles.x;
+	});
+
+	// 3x3 matrices
+	RunBenchmark( "matrix3x3_multiply", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix3x3 m = Matrices3x3[input] * Matrices3x3[(input + 1) & (kNumInputs - 1)];
+		BenchmarkSink = m.e00;
+	});
+	RunBenchmark( "matrix3x3_inverse", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix3x3 m = Inverse( Matrices3x3[input] );
+		BenchmarkSink = m.e00;
+	});
+
+	// Quaternions
+	RunBenchmark( "quaternion_multiply", numOps, numRepeats, []( TUInt32 input )
+	{
+		CQuaternion q = Quaternions[input] * Quaternions[(input + 1) & (kNumInputs - 1)];
+		BenchmarkSink = q.w;
+	});
+	RunBenchmark( "quaternion_slerp", numOps, numRepeats, []( TUInt32 input )
+	{
+		CQuaternion q;
+		Slerp( Quaternions[input], Quaternions[(input + 1) & (kNumInputs - 1)], 0.3f, q );
+		BenchmarkSink = q.w;
+	});
+	RunBenchmark( "quaternion_nlerp", numOps, numRepeats, []( TUInt32 input )
+	{
+		CQuaternion q;
+		NLerp( Quaternions[input], Quaternions[(input + 1) & (kNumInputs - 1)], 0.3f, q );
+		BenchmarkSink = q.w;
+	});
+
+	// Quaternion transforms
+	RunBenchmark( "quat_transform_slerp", numOps, numRepeats, []( TUInt32 input )
+	{
+		CQuatTransform qt;
+		Slerp( QuatTransforms[input], QuatTransforms[(input + 1) & (kNumInputs - 1)], 0.3f, qt );
+		BenchmarkSink = qt.quat.w;
+	});
+	RunBenchmark( "quat_transform_get_matrix", numOps, numRepeats, []( TUInt32 input )
+	{
+		CMatrix4x4 m;
+		QuatTransforms[input].GetMatrix( m );
+		BenchmarkSink = m.e00;
+	});
+
+	// Vectors
+	RunBenchmark( "vector3_normalise", numOps, numRepeats, []( TUInt32 input )
+	{
+		CVector3 v = Vectors[input];
+		v.Normalise();
+		BenchmarkSink = v.x;
+	});
+	RunBenchmark( "vector3_cross", numOps, numRepeats, []( TUInt32 input )
+	{
+		CVector3 v = Cross( Vectors[input], Vectors[(input + 1) & (kNumInputs - 1)] );
+		BenchmarkSink = v.x;
+	});
+}
+
+
+} // namespace gen
+
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+// Usage: MathBenchmark [ops per benchmark] [repeats]
+int main( int argc, char* argv[] )
+{
+	gen::TUInt32 numOps = 10000000;
+	gen::TUInt32 numRepeats = 5;
+
+	if (argc > 1) numOps = static_cast<gen::TUInt32>(strtoul( argv[1], 0, 10 ));
+	if (argc > 2) numRepeats = static_cast<gen::TUInt32>(strtoul( argv[2], 0, 10 ));
+	if (numOps == 0 || numRepeats == 0)
+	{
+		cerr << "Usage: " << argv[0] << " [ops per benchmark] [repeats]" << endl;
+		return EXIT_FAILURE;
+	}
+
+	gen::RunMathBenchmarks( numOps, numRepeats );
+	return EXIT_SUCCESS;
+}
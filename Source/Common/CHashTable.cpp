@@ -56,4 +56,29 @@ TUInt32 JOneAtATimeHash( const TUInt8* pKey, const TUInt32 iKeyLen )
 }
 
 
+// Integer hashing function for keys that are integers such as entity UIDs. Mixes the key a word
+// at a time rather than a byte at a time. When used with 4-byte keys the hash table calls the
+// inline version directly, avoiding the function call altogether
+TUInt32 IntegerHash( const TUInt8* pKey, const TUInt32 iKeyLen )
+{
+	TUInt32 iHash = 0;
+	TUInt32 iKeyIndex;
+
+	// Combine whole words, then any remaining bytes
+	for (iKeyIndex = 0; iKeyIndex + sizeof(TUInt32) <= iKeyLen; iKeyIndex += sizeof(TUInt32))
+	{
+		TUInt32 iWord;
+		memcpy( &iWord, pKey + iKeyIndex, sizeof(TUInt32) );
+		iHash = IntegerHashValue( iHash ^ iWord );
+	}
+	if (iKeyIndex < iKeyLen)
+	{
+		TUInt32 iWord = 0;
+		memcpy( &iWord, pKey + iKeyIndex, iKeyLen - iKeyIndex );
+		iHash = IntegerHashValue( iHash ^ iWord );
+	}
+	return iHash;
+}
+
+
 } // namespace gen
@@ -18,8 +18,9 @@
 #define GEN_C_HASH_TABLE_H_INCLUDED
 
 #include <math.h>
+#include <string.h>
 #include <iostream>
-#include <list>
+#include <utility>
 using namespace std;
 
 #include "Defines.h"
@@ -46,6 +47,23 @@ TUInt32 AddUpHash( const TUInt8* pKey, const TUInt32 iKeyLen );
 // distribution of indexes (few collisions)
 TUInt32 JOneAtATimeHash( const TUInt8* pKey, const TUInt32 iKeyLen );
 
+// Integer hashing function for keys that are integers such as entity UIDs. Mixes the key a word
+// at a time rather than a byte at a time. When used with 4-byte keys the hash table calls the
+// inline version below directly, avoiding the function call altogether
+TUInt32 IntegerHash( const TUInt8* pKey, const TUInt32 iKeyLen );
+
+// Inline integer hash of a single 4-byte value (the finalisation step of MurmurHash3). Every
+// bit of the input affects every bit of the result, so the low bits can be used as an index
+inline TUInt32 IntegerHashValue( TUInt32 iValue )
+{
+	iValue ^= iValue >> 16;
+	iValue *= 0x85ebca6b;
+	iValue ^= iValue >> 13;
+	iValue *= 0xc2b2ae35;
+	iValue ^= iValue >> 16;
+	return iValue;
+}
+
 
 /*---------------------------------------------------------------------------------------------
 	CHashTable class
@@ -58,14 +76,24 @@ TUInt32 JOneAtATimeHash( const TUInt8* pKey, const TUInt32 iKeyLen );
 //
 // Often a template class or function has restrictions on the types that can be used, these
 // must be documented. Here the key type (TKeyType here) must have operator== (comparison) and
-// operator= (assignment) defined and the value type must have operator= defined. This is no
-// problem for entity look-up (keys are UIDs (integers), values are pointers), or phonebooks
-// (keys and values are STL strings) - these are standard types have both == and = defined.
-// However, in other cases we may need to implement/overload the == and = operators or the
-// class would not compile.
+// operator= (assignment) defined and the value type must have operator= defined. Both must also
+// have a default constructor. This is no problem for entity look-up (keys are UIDs (integers),
+// values are pointers), or phonebooks (keys and values are STL strings) - these are standard
+// types have all of these defined. However, in other cases we may need to implement/overload
+// the == and = operators or the class would not compile.
 // A further restriction is that keys must not contain pointers (although values can). This is
 // because the hash function treats keys as a sequence of raw bytes, pointers are not followed
 // and the data pointed at will not be hashed
+//
+// The table uses "open addressing" - key/value pairs are stored directly in a single array of
+// slots rather than in a list for each bucket. A key is placed in the slot given by its hash if
+// that is free, otherwise in the next free slot after it. So a look-up reads neighbouring slots
+// in memory and never follows pointers, and adding keys does not allocate memory (except when
+// the table is resized). Each slot records how far it is from the slot its key hashed to (its
+// "probe distance"). When adding a key, if it has travelled further than the key in a slot it
+// takes the slot and the other key moves on instead - this is "Robin Hood" hashing. It keeps
+// probe distances short and even, and a look-up can stop as soon as it reaches a slot whose
+// key is closer to home than the key being searched for would be
 template <class TKeyType, class TValueType>
 class CHashTable
 {
@@ -85,10 +113,15 @@ public:
 	{
 		GEN_GUARD;
 
-		// Allocate initial hash table array
-		m_iSize = iInitialSize;
-		m_aBuckets = new TBucket[m_iSize];
-		GEN_ASSERT( m_aBuckets, "Fatal memory error reserving hash table memory" );
+		// Allocate initial hash table array. The size is rounded up to a power of 2 so a hash
+		// can be converted to a slot index with a bitwise operator instead of a modulus
+		m_iSize = 8;
+		while (m_iSize < iInitialSize)
+		{
+			m_iSize *= 2;
+		}
+		m_aSlots = new TSlot[m_iSize];
+		GEN_ASSERT( m_aSlots, "Fatal memory error reserving hash table memory" );
 
 		// Starting with no hash table entries
 		m_iNumEntries = 0;
@@ -108,7 +141,7 @@ public:
 	// Destructor to free hash table memory
 	~CHashTable()
 	{
-		delete[] m_aBuckets;
+		delete[] m_aSlots;
 	}
 
 
@@ -124,20 +157,17 @@ public:
 		TValueType*     pValue
 	)
 	{
-		// Find the index of the bucket associated with this key (will use hashing function)
-		TUInt32 iBucket = FindBucket( key );
-
-		// Search the bucket to find the the given key
-		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( iBucket, key );
+		// Search the table for the slot holding the given key
+		TUInt32 iSlot = FindSlot( key );
 
-		// Not found (reached end of list), return false
-		if (itKeyValuePair == m_aBuckets[iBucket].end())
+		// Not found, return false
+		if (iSlot == kNoSlot)
 		{
 			return false;
 		}
 
 		// Found key, copy its value out and return true
-		*pValue = itKeyValuePair->value;
+		*pValue = m_aSlots[iSlot].value;
 		return true;
 	}
 
@@ -149,30 +179,23 @@ public:
 		const TValueType& value
 	)
 	{
-		// Find the index of the bucket associated with this key (will use hashing function)
-		TUInt32 iBucket = FindBucket( key );
-
-		// See if given key already exists in the bucket 
-		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( iBucket, key );
-		if (itKeyValuePair != m_aBuckets[iBucket].end())
+		// See if given key already exists in the table
+		TUInt32 iSlot = FindSlot( key );
+		if (iSlot != kNoSlot)
 		{
 			// If key already exists, simply update the value associated with it
-			itKeyValuePair->value = value;
+			m_aSlots[iSlot].value = value;
 		}
-		else // otherwise a new key/value pair needs to be inserted in the bucket
+		else // otherwise a new key/value pair needs to be inserted
 		{
-			// Check loading of table - if too full, then double it in size
-			if (m_iNumEntries > m_iSize * m_kfMaxLoadFactor)
+			// Check loading of table - if too full, then double it in size. There must always be
+			// at least one free slot for the search loops to stop
+			if (m_iNumEntries > m_iSize * m_kfMaxLoadFactor || m_iNumEntries + 1 >= m_iSize)
 			{
 				Resize( m_iSize * 2 );
-				iBucket = FindBucket( key ); // Find new bucket for key after resizing
 			}
 
-			// Create a new key/value pair and add it to the list in this bucket
-			TKeyValuePair newPair;
-			newPair.key = key;
-			newPair.value = value;
-			m_aBuckets[iBucket].push_back( newPair );
+			InsertKeyValue( key, value );
 
 			// Increase total number of entries in hash table
 			++m_iNumEntries;
@@ -180,23 +203,73 @@ public:
 	}
 
 
+	// Add the given number of key-value pairs from two arrays to the table, updating the values of
+	// any keys that already exist. The table is resized at most once, before any are added
+	void SetKeyValues
+	(
+		const TKeyType*   aKeys,
+		const TValueType* aValues,
+		const TUInt32     iNumKeys
+	)
+	{
+		Reserve( m_iNumEntries + iNumKeys );
+		for (TUInt32 iKey = 0; iKey < iNumKeys; ++iKey)
+		{
+			TUInt32 iSlot = FindSlot( aKeys[iKey] );
+			if (iSlot != kNoSlot)
+			{
+				m_aSlots[iSlot].value = aValues[iKey];
+			}
+			else
+			{
+				InsertKeyValue( aKeys[iKey], aValues[iKey] );
+				++m_iNumEntries;
+			}
+		}
+	}
+
+
+	// Resize the table if necessary so it can hold the given number of entries without resizing
+	// again. The table is never made smaller
+	void Reserve( const TUInt32 iNumEntries )
+	{
+		// Double the size until the entries are within the load factor, leaving a free slot
+		TUInt32 iNewSize = m_iSize;
+		while (iNumEntries > iNewSize * m_kfMaxLoadFactor || iNumEntries + 1 >= iNewSize)
+		{
+			iNewSize *= 2;
+		}
+		if (iNewSize != m_iSize)
+		{
+			Resize( iNewSize );
+		}
+	}
+
+
 	// Remove the given key (and associated value) from the table, returns false if not found
 	bool RemoveKey(	const TKeyType& key )
 	{
-		// Find the index of the bucket associated with this key (will use hashing function)
-		TUInt32 iBucket = FindBucket( key );
-
-		// Search the bucket to find the the given key
-		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( iBucket, key );
+		// Search the table for the slot holding the given key
+		TUInt32 iSlot = FindSlot( key );
 
 		// If not found then nothing to do
-		if (itKeyValuePair == m_aBuckets[iBucket].end())
+		if (iSlot == kNoSlot)
 		{   
 			return false;
 		}
 
-		// Remove the found key from the bucket
-		m_aBuckets[iBucket].erase( itKeyValuePair );
+		// Remove the key by shifting back the following keys that are not in their home slot, this
+		// fills the gap so no later look-ups stop early at it
+		TUInt32 iNextSlot = (iSlot + 1) & (m_iSize - 1);
+		while (m_aSlots[iNextSlot].iDistance > 1)
+		{
+			m_aSlots[iSlot].key = m_aSlots[iNextSlot].key;
+			m_aSlots[iSlot].value = m_aSlots[iNextSlot].value;
+			m_aSlots[iSlot].iDistance = m_aSlots[iNextSlot].iDistance - 1;
+			iSlot = iNextSlot;
+			iNextSlot = (iSlot + 1) & (m_iSize - 1);
+		}
+		m_aSlots[iSlot].iDistance = 0;
 
 		// Decrease number of table entries - note that table is never resized downwards
 		--m_iNumEntries; 
@@ -208,10 +281,11 @@ public:
 	// Remove all keys and associated values
 	void RemoveAllKeys()
 	{
-		for (TUInt32 iBucket = 0; iBucket < m_iSize; ++iBucket)
+		for (TUInt32 iSlot = 0; iSlot < m_iSize; ++iSlot)
 		{
-			m_aBuckets[iBucket].clear();
+			m_aSlots[iSlot].iDistance = 0;
 		}
+		m_iNumEntries = 0;
 	}
 
 
@@ -222,9 +296,22 @@ public:
 	// hash table - we find the bucket associated with our key, if it has multiple entries, we
 	// must search through them all. So we aim for a hash function that minimises the number
 	// of such situations. This function will show up good / bad hash functions
+	// With open addressing the keys in a "bucket" are spread over the slots following it, so
+	// the bucket sizes are counted from the home slot of each key
 	void OutputDistribution() const
 	{
 		cout << "Hash Table Distribution:" << endl << endl;
+
+		// Count the keys whose home is each slot
+		TUInt32* aBucketSizes = new TUInt32[m_iSize];
+		memset( aBucketSizes, 0, m_iSize * sizeof(TUInt32) );
+		for (TUInt32 iSlot = 0; iSlot < m_iSize; ++iSlot)
+		{
+			if (m_aSlots[iSlot].iDistance)
+			{
+				++aBucketSizes[(iSlot - (m_aSlots[iSlot].iDistance - 1)) & (m_iSize - 1)];
+			}
+		}
 		
 		// Calculate the average size of those buckets that contain keys. This gives an idea of the
 		// efficiency to look up a key
@@ -235,7 +322,7 @@ public:
 		TUInt32 iBucket = 0;
 		while (iBucket != m_iSize)
 		{
-			TUInt32 iCollision = static_cast<TUInt32>(m_aBuckets[iBucket].size());
+			TUInt32 iCollision = aBucketSizes[iBucket];
 			// Output a digit if less than 10 entries in a bucket
 			if (iCollision < 10)
 			{
@@ -256,6 +343,8 @@ public:
 		cout << endl << "Average (used) bucket size: " 
 		     << static_cast<float>(iAverageBucketSize) / iUsedBuckets << endl;
 		cout << endl;
+
+		delete[] aBucketSizes;
 	}
 
 /*-----------------------------------------------------------------------------------------
@@ -267,66 +356,99 @@ private:
 		Types
 	---------------------------------------------------------------------------------------------*/
 
-	// A key/value pair held by the hash table
-	struct TKeyValuePair
+	// A slot in the table, holding a key/value pair and its probe distance. The distance is 1 if
+	// the key is in the slot given by its hash, 2 if it is in the following slot and so on. A
+	// distance of 0 marks an empty slot
+	struct TSlot
 	{
-		TKeyType         key;
-		TValueType       value;
+		TSlot() : iDistance( 0 ) {}
+
+		TUInt32    iDistance;
+		TKeyType   key;
+		TValueType value;
 	};
 
-	// A bucket is a list of key/value pairs that have the same hash index. The list only has
-	// more than one entry if there has been a collision from the hashing function
-	// Define a couple of types to make for better readability
-	typedef list<TKeyValuePair>        TBucket;
-	typedef typename TBucket::iterator TKeyValuePairIter;
-	// Use of templates is powerful, but can cause syntax headaches - the need for "typename"
-	// here is an example
+	// Slot index returned when a key is not found
+	static const TUInt32 kNoSlot = 0xffffffff;
 
 
 	/*---------------------------------------------------------------------------------------------
 		Support functions
 	---------------------------------------------------------------------------------------------*/
 
-	// Find the index of the bucket that should contain the given key
-	TUInt32 FindBucket(	const TKeyType& key	) const
+	// Find the index of the slot that the given key hashes to (its "home" slot)
+	TUInt32 FindHomeSlot( const TKeyType& key ) const
 	{
 		// Get a pointer to the key as raw bytes - this cast is OK for this kind of purpose
 		const TUInt8* pKeyData = reinterpret_cast<const TUInt8*>(&key);
 
-		// Use hashing function to convert key data to a single 4-byte integer
-		TUInt32 iIndex = m_kpfHashFunction( pKeyData, sizeof(TKeyType) );
+		// Use hashing function to convert key data to a single 4-byte integer. Use the inline
+		// integer hash directly for 4-byte integer keys, avoiding the function call
+		TUInt32 iIndex;
+		if (sizeof(TKeyType) == sizeof(TUInt32) && m_kpfHashFunction == IntegerHash)
+		{
+			TUInt32 iKeyValue;
+			memcpy( &iKeyValue, pKeyData, sizeof(TUInt32) );
+			iIndex = IntegerHashValue( iKeyValue );
+		}
+		else
+		{
+			iIndex = m_kpfHashFunction( pKeyData, sizeof(TKeyType) );
+		}
 		
-		// Convert this 4-byte hash value to a bucket index. We have m_iSize buckets, so just
-		// use the integer modulus operator. Could use faster bitwise operator if number of
-		// buckets was a power of 2, but will deal with the general case here
-		iIndex %= m_iSize;
+		// Convert this 4-byte hash value to a slot index. We have a power of 2 number of slots,
+		// so can use a bitwise and rather than the (slower) integer modulus operator
+		iIndex &= m_iSize - 1;
 
 		return iIndex;
 	}
 
 
-	// Find the key/value pair associated with the given key in the given bucket
-	// Returns the end of list iterator if not found
-	TKeyValuePairIter FindKeyValuePair
-	(
-		const int       iBucket,
-		const TKeyType& key
-	) const
+	// Find the slot holding the given key. Returns kNoSlot if not found
+	TUInt32 FindSlot( const TKeyType& key ) const
 	{
-		// Start at beginning of bucket and step through each key/value pair
-		TKeyValuePairIter itKeyValuePair = m_aBuckets[iBucket].begin();
-		while (itKeyValuePair != m_aBuckets[iBucket].end())
+		// Start at the key's home slot and step through the following slots. Stop if we reach a
+		// slot whose key is nearer to its home than the given key would be - Robin Hood insertion
+		// would have placed the given key there or earlier. Empty slots have distance 0 so also stop
+		TUInt32 iSlot = FindHomeSlot( key );
+		TUInt32 iDistance = 1;
+		while (m_aSlots[iSlot].iDistance >= iDistance)
 		{
-			// If we find a matching key, then quit loop
-			if (key == itKeyValuePair->key)
+			// If we find a matching key, then return it
+			if (key == m_aSlots[iSlot].key)
 			{
-				break;
+				return iSlot;
 			}
-			++itKeyValuePair;
+			iSlot = (iSlot + 1) & (m_iSize - 1);
+			++iDistance;
 		}
 
-		// Return found key/value pair, or end of list iterator if not found
-		return itKeyValuePair;
+		return kNoSlot;
+	}
+
+
+	// Insert a key/value pair that is known not to be in the table, there must be a free slot
+	void InsertKeyValue( TKeyType key, TValueType value )
+	{
+		// Step through slots from the key's home until finding a free slot. On the way, if the
+		// key being inserted has travelled further than a slot's key then swap them and continue
+		// with the key that was displaced
+		TUInt32 iSlot = FindHomeSlot( key );
+		TUInt32 iDistance = 1;
+		while (m_aSlots[iSlot].iDistance != 0)
+		{
+			if (m_aSlots[iSlot].iDistance < iDistance)
+			{
+				swap( iDistance, m_aSlots[iSlot].iDistance );
+				swap( key, m_aSlots[iSlot].key );
+				swap( value, m_aSlots[iSlot].value );
+			}
+			iSlot = (iSlot + 1) & (m_iSize - 1);
+			++iDistance;
+		}
+		m_aSlots[iSlot].iDistance = iDistance;
+		m_aSlots[iSlot].key = key;
+		m_aSlots[iSlot].value = value;
 	}
 
 	// Resize the hash table - reinserts all keys
@@ -334,27 +456,25 @@ private:
 	{
 		GEN_GUARD;
 
-		// Store old buckets and size
+		// Store old slots and size
 		TUInt32 iOldSize = m_iSize;
-		TBucket* aOldBuckets = m_aBuckets;
+		TSlot* aOldSlots = m_aSlots;
 
-		// Update size and create new set of buckets
+		// Update size and create new set of slots
 		m_iSize = iNewSize;
-		m_aBuckets = new TBucket[m_iSize];
-		GEN_ASSERT( m_aBuckets, "Fatal memory error reserving hash table memory" );
+		m_aSlots = new TSlot[m_iSize];
+		GEN_ASSERT( m_aSlots, "Fatal memory error reserving hash table memory" );
 
-		// Go through old buckets and set each key/value pair into new buckets
-		m_iNumEntries = 0;
-		for (TUInt32 iBucket = 0; iBucket < iOldSize; ++iBucket)
+		// Go through old slots and insert each key/value pair into new slots
+		for (TUInt32 iSlot = 0; iSlot < iOldSize; ++iSlot)
 		{
-			while (aOldBuckets[iBucket].size())
+			if (aOldSlots[iSlot].iDistance)
 			{
-				SetKeyValue( aOldBuckets[iBucket].front().key, aOldBuckets[iBucket].front().value );
-				aOldBuckets[iBucket].pop_front(); // Delete each old key/value pair after it is copied
+				InsertKeyValue( aOldSlots[iSlot].key, aOldSlots[iSlot].value );
 			}
 		}
 
-		delete[] aOldBuckets;
+		delete[] aOldSlots;
 
 		GEN_ENDGUARD;
 	}
@@ -364,8 +484,8 @@ private:
 		Data
 	---------------------------------------------------------------------------------------------*/
 
-	TBucket* m_aBuckets;    // Dynamically allocated array of buckets of key/value pairs
-	TUInt32  m_iSize;       // Size (capacity) of the table - number of buckets
+	TSlot*   m_aSlots;      // Dynamically allocated array of slots holding key/value pairs
+	TUInt32  m_iSize;       // Size (capacity) of the table - number of slots, a power of 2
 	TUInt32  m_iNumEntries; // Number of key/value pairs in the table
 
 	// Hash function to use is stored as a function pointer - converts a key given as a
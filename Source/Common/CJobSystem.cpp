@@ -0,0 +1,250 @@
+/**************************************************************************************************
+	Module:       CJobSystem.cpp
+
+	Job system running chunks of work on a pool of worker threads. Each thread has its own queue
+	of jobs, and threads that run out of work steal jobs from the other queues
+**************************************************************************************************/
+
+#include "CJobSystem.h"
+
+namespace gen
+{
+
+// Index of the current thread, threads not started by a job system use 0
+thread_local TUInt32 CJobSystem::s_ThreadIndex = 0;
+
+
+/*-----------------------------------------------------------------------------------------
+	Constructors/Destructors
+-----------------------------------------------------------------------------------------*/
+
+// Constructor - no threads are started
+CJobSystem::CJobSystem()
+{
+	// The thread that starts work always has a queue
+	m_Queues.push_back( new SJobQueue );
+	m_NumQueued = 0;
+	m_Quit = false;
+}
+
+// Destructor stops any worker threads
+CJobSystem::~CJobSystem()
+{
+	Stop();
+	delete m_Queues[0];
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+
+// Start worker threads so the given total number of threads (including the thread that starts
+// work) share it. Pass 0 to use one thread for each hardware thread. Any existing workers are
+// stopped first
+void CJobSystem::Start( TUInt32 numThreads /*= 0*/ )
+{
+	Stop();
+
+	if (numThreads == 0)
+	{
+		// May return 0 if the number is unknown
+		numThreads = thread::hardware_concurrency();
+		if (numThreads == 0)
+		{
+			numThreads = 1;
+		}
+	}
+
+	// Create all the queues before starting any threads, as threads steal from every queue
+	for (TUInt32 queue = 1; queue < numThreads; ++queue)
+	{
+		m_Queues.push_back( new SJobQueue );
+	}
+	for (TUInt32 worker = 1; worker < numThreads; ++worker)
+	{
+		m_Threads.push_back( thread( &CJobSystem::WorkerThread, this, worker ) );
+	}
+}
+
+// Stop the worker threads, work will run on the calling thread only
+void CJobSystem::Stop()
+{
+	{
+		lock_guard<mutex> lock( m_SleepLock );
+		m_Quit = true;
+	}
+	m_WorkAvailable.notify_all();
+
+	for (TUInt32 worker = 0; worker < m_Threads.size(); ++worker)
+	{
+		m_Threads[worker].join();
+	}
+	m_Threads.clear();
+
+	while (m_Queues.size() > 1)
+	{
+		delete m_Queues.back();
+		m_Queues.pop_back();
+	}
+	m_Quit = false;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Support functions
+-----------------------------------------------------------------------------------------*/
+
+// Share out and run the chunks for ParallelFor, returning when all are complete
+void CJobSystem::RunJobs( TUInt32 count, TUInt32 chunkSize, TJobFunction jobFunction, void* function )
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (chunkSize == 0)
+	{
+		chunkSize = 1;
+	}
+	TUInt32 numChunks = (count + chunkSize - 1) / chunkSize;
+
+	// No need for the queues if there are no workers or only one chunk
+	if (m_Threads.empty() || numChunks == 1)
+	{
+		for (TUInt32 begin = 0; begin < count; begin += chunkSize)
+		{
+			jobFunction( function, begin, (count - begin > chunkSize) ? begin + chunkSize : count );
+		}
+		return;
+	}
+
+	SJobGroup group;
+	group.jobFunction = jobFunction;
+	group.function = function;
+	group.numRemaining = numChunks;
+
+	// Count the jobs before queuing them, so the count never drops below zero when a worker takes
+	// a job before the rest are queued
+	m_NumQueued += numChunks;
+
+	// Give each queue a run of neighbouring chunks. Chunks are added in reverse, as threads
+	// take from the back of their own queue, so each thread works forwards through its run
+	TUInt32 numQueues = NumThreads();
+	for (TUInt32 queue = 0; queue < numQueues; ++queue)
+	{
+		TUInt32 firstChunk = static_cast<TUInt32>(static_cast<TUInt64>(numChunks) * queue / numQueues);
+		TUInt32 lastChunk = static_cast<TUInt32>(static_cast<TUInt64>(numChunks) * (queue + 1) / numQueues);
+
+		lock_guard<mutex> lock( m_Queues[queue]->lock );
+		for (TUInt32 chunk = lastChunk; chunk > firstChunk; --chunk)
+		{
+			SJob job;
+			job.group = &group;
+			job.begin = (chunk - 1) * chunkSize;
+			job.end = (count - job.begin > chunkSize) ? job.begin + chunkSize : count;
+			m_Queues[queue]->jobs.push_back( job );
+		}
+	}
+
+	// Wake the workers. The sleep lock is taken so a worker cannot miss the change in the count
+	// between checking it and going to sleep
+	{
+		lock_guard<mutex> lock( m_SleepLock );
+	}
+	m_WorkAvailable.notify_all();
+
+	// Run jobs on this thread too, until all jobs in the group are complete. Once there are none
+	// left to take, wait for the workers to finish the jobs they are running
+	while (group.numRemaining > 0)
+	{
+		SJob job;
+		if (FindJob( 0, &job ))
+		{
+			RunJob( job );
+		}
+		else
+		{
+			this_thread::yield();
+		}
+	}
+
+	if (group.exception)
+	{
+		rethrow_exception( group.exception );
+	}
+}
+
+// Find a job for the given thread, first from its own queue then stealing from the others.
+// Returns false if there are no jobs queued
+bool CJobSystem::FindJob( TUInt32 threadIndex, SJob* job )
+{
+	TUInt32 numQueues = NumThreads();
+	for (TUInt32 offset = 0; offset < numQueues; ++offset)
+	{
+		SJobQueue* queue = m_Queues[(threadIndex + offset) % numQueues];
+		lock_guard<mutex> lock( queue->lock );
+		if (!queue->jobs.empty())
+		{
+			// Take from the back of own queue, steal from the front of others
+			if (offset == 0)
+			{
+				*job = queue->jobs.back();
+				queue->jobs.pop_back();
+			}
+			else
+			{
+				*job = queue->jobs.front();
+				queue->jobs.pop_front();
+			}
+			--m_NumQueued;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Run a job, recording any exception in its group, then mark it complete
+void CJobSystem::RunJob( const SJob& job )
+{
+	SJobGroup* group = job.group;
+	try
+	{
+		group->jobFunction( group->function, job.begin, job.end );
+	}
+	catch (...)
+	{
+		lock_guard<mutex> lock( group->exceptionLock );
+		if (!group->exception)
+		{
+			group->exception = current_exception();
+		}
+	}
+
+	// The group may be destroyed as soon as the last job is marked complete
+	--group->numRemaining;
+}
+
+// Main function for worker threads
+void CJobSystem::WorkerThread( TUInt32 threadIndex )
+{
+	s_ThreadIndex = threadIndex;
+	while (true)
+	{
+		SJob job;
+		if (FindJob( threadIndex, &job ))
+		{
+			RunJob( job );
+			continue;
+		}
+
+		unique_lock<mutex> lock( m_SleepLock );
+		m_WorkAvailable.wait( lock, [this]() { return m_NumQueued > 0 || m_Quit; } );
+		if (m_Quit)
+		{
+			return;
+		}
+	}
+}
+
+
+} // namespace gen
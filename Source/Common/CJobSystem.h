@@ -0,0 +1,172 @@
+/**************************************************************************************************
+	Module:       CJobSystem.h
+
+	Job system running chunks of work on a pool of worker threads. Each thread has its own queue
+	of jobs, and threads that run out of work steal jobs from the other queues
+**************************************************************************************************/
+
+#ifndef GEN_C_JOB_SYSTEM_H_INCLUDED
+#define GEN_C_JOB_SYSTEM_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+// The job system splits a range of work (e.g. updating a list of entities) into chunks and runs
+// the chunks in parallel. The chunks are shared out evenly between the queues of the worker
+// threads and the thread that started the work, which also runs jobs while it waits. A thread
+// takes jobs from the back of its own queue and, once empty, steals from the front of the others,
+// so threads given quick chunks help out those given slow ones.
+// The system is created without threads, and runs all work on the calling thread until Start is
+// called. Work can only be started from one thread at a time, and not from inside a job
+class CJobSystem
+{
+/*-----------------------------------------------------------------------------------------
+	Constructors/Destructors
+-----------------------------------------------------------------------------------------*/
+public:
+	// Constructor - no threads are started
+	CJobSystem();
+
+	// Destructor stops any worker threads
+	~CJobSystem();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CJobSystem( const CJobSystem& );
+	CJobSystem& operator=( const CJobSystem& );
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+public:
+
+	// Start worker threads so the given total number of threads (including the thread that
+	// starts work) share it. Pass 0 to use one thread for each hardware thread. Any existing
+	// workers are stopped first
+	void Start( TUInt32 numThreads = 0 );
+
+	// Stop the worker threads, work will run on the calling thread only
+	void Stop();
+
+	// Return the total number of threads work is shared between, including the calling thread
+	TUInt32 NumThreads()
+	{
+		return static_cast<TUInt32>(m_Queues.size());
+	}
+
+	// Return the index of the current thread in this job system, from 0 to NumThreads()-1. The
+	// thread that starts work is always 0. Use to select per-thread data inside a job
+	static TUInt32 ThreadIndex()
+	{
+		return s_ThreadIndex;
+	}
+
+	// Split the range [0, count) into chunks of the given size and call the given function for
+	// each chunk in parallel, as function( begin, end ). Returns when all chunks are complete. If
+	// a chunk throws an exception then the first exception is rethrown here once the other
+	// chunks are complete
+	template <class TFunction>
+	void ParallelFor( TUInt32 count, TUInt32 chunkSize, TFunction function )
+	{
+		RunJobs( count, chunkSize, &CallFunction<TFunction>, &function );
+	}
+
+
+/*-----------------------------------------------------------------------------------------
+	Private interface
+-----------------------------------------------------------------------------------------*/
+private:
+
+	/////////////////////////////////////
+	// Types
+
+	// Pointer to a function that calls a ParallelFor function on a chunk, the function is passed
+	// as a void pointer so jobs do not depend on its type
+	typedef void (*TJobFunction)( void* function, TUInt32 begin, TUInt32 end );
+
+	// A group of jobs started by one call to ParallelFor, held on the stack of the caller
+	struct SJobGroup
+	{
+		TJobFunction     jobFunction;
+		void*            function;
+		atomic<TUInt32>  numRemaining;
+		mutex            exceptionLock;
+		exception_ptr    exception;
+	};
+
+	// A single chunk of work
+	struct SJob
+	{
+		SJobGroup* group;
+		TUInt32    begin;
+		TUInt32    end;
+	};
+
+	// Job queue belonging to one thread
+	struct SJobQueue
+	{
+		mutex       lock;
+		deque<SJob> jobs;
+	};
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Call the given ParallelFor function on a chunk
+	template <class TFunction>
+	static void CallFunction( void* function, TUInt32 begin, TUInt32 end )
+	{
+		(*static_cast<TFunction*>(function))( begin, end );
+	}
+
+	// Share out and run the chunks for ParallelFor, returning when all are complete
+	void RunJobs( TUInt32 count, TUInt32 chunkSize, TJobFunction jobFunction, void* function );
+
+	// Find a job for the given thread, first from its own queue then stealing from the others.
+	// Returns false if there are no jobs queued
+	bool FindJob( TUInt32 threadIndex, SJob* job );
+
+	// Run a job, recording any exception in its group, then mark it complete
+	void RunJob( const SJob& job );
+
+	// Main function for worker threads
+	void WorkerThread( TUInt32 threadIndex );
+
+
+	/////////////////////////////////////
+	// Data
+
+	// Job queue for each thread, the thread starting work uses the first
+	vector<SJobQueue*> m_Queues;
+
+	// Worker threads
+	vector<thread> m_Threads;
+
+	// Number of jobs in all queues. Idle workers sleep on the condition variable until this is
+	// non-zero or they are told to quit
+	atomic<TUInt32>    m_NumQueued;
+	mutex              m_SleepLock;
+	condition_variable m_WorkAvailable;
+	bool               m_Quit;
+
+	// Index of the current thread
+	static thread_local TUInt32 s_ThreadIndex;
+};
+
+
+} // namespace gen
+
+#endif // GEN_C_JOB_SYSTEM_H_INCLUDED
@@ -0,0 +1,122 @@
+/**************************************************************************************************
+	Module:       GNUDefines.cpp
+
+	Utility functions for GCC / Clang platforms (e.g. Linux headless builds)
+**************************************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Defines.h"
+#include "GNUDefines.h"
+
+namespace gen
+{
+
+/*------------------------------------------------------------------------------------------------
+	System message support
+ ------------------------------------------------------------------------------------------------*/
+
+// System message used to display errors or warnings. There is no GUI on these platforms so the
+// message is written to stderr. Yes/No requests cannot be answered and always return false
+bool SystemMessageBox
+(
+	const string& sMessage, // Main message to display
+	const string& sCaption, // Caption to display before message
+	const bool    bYesNo    // Request Yes and No buttons instead of OK
+)
+{
+	cerr << sCaption << ": " << sMessage << endl;
+	return !bYesNo;
+}
+
+
+/*------------------------------------------------------------------------------------------------
+	File support
+ ------------------------------------------------------------------------------------------------*/
+
+// Map a whole file into memory for reading. Returns a pointer to the file contents and its size
+// through the given pointer, or 0 if the file cannot be opened or is empty. Release with UnmapFile
+const void* MapFile
+(
+	const string& sFileName, // File to map
+	TUInt32*      pSize      // Returns size of file in bytes
+)
+{
+	int file = open( sFileName.c_str(), O_RDONLY );
+	if (file < 0)
+	{
+		return 0;
+	}
+	struct stat fileStat;
+	if (fstat( file, &fileStat ) != 0 || fileStat.st_size == 0 || fileStat.st_size > 0xffffffff)
+	{
+		close( file );
+		return 0;
+	}
+
+	// The mapping remains after the file is closed
+	void* pData = mmap( 0, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+	close( file );
+	if (pData == MAP_FAILED)
+	{
+		return 0;
+	}
+
+	*pSize = static_cast<TUInt32>(fileStat.st_size);
+	return pData;
+}
+
+// Release a file mapping returned by MapFile
+void UnmapFile
+(
+	const void*   pData, // Pointer returned by MapFile
+	const TUInt32 size   // Size returned by MapFile
+)
+{
+	munmap( const_cast<void*>(pData), size );
+}
+
+// Get the last modification time of a file, returns false if the file does not exist. Times are
+// only comparable with each other
+bool GetFileModifiedTime
+(
+	const string& sFileName, // File to check
+	TUInt64*      pTime      // Returns modification time
+)
+{
+	struct stat fileStat;
+	if (stat( sFileName.c_str(), &fileStat ) != 0)
+	{
+		return false;
+	}
+	*pTime = static_cast<TUInt64>(fileStat.st_mtime);
+	return true;
+}
+
+
+// Get the canonical name of a file - its full path with any "." and ".." removed, in a form that
+// is the same however the file is named. Returns false if the file does not exist. Symbolic
+// links are also resolved
+bool GetCanonicalFileName
+(
+	const string& sFileName,     // File to find
+	string*       pCanonicalName // Returns canonical name of file
+)
+{
+	char* fullName = realpath( sFileName.c_str(), NULL );
+	if (fullName == NULL)
+	{
+		return false;
+	}
+	pCanonicalName->assign( fullName );
+	free( fullName );
+	return true;
+}
+
+
+} // namespace gen
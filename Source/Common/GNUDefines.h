@@ -0,0 +1,124 @@
+/**************************************************************************************************
+	Module:       GNUDefines.h
+
+	Utility functions for GCC / Clang platforms (e.g. Linux headless builds)
+
+	Mirrors the definitions in MSDefines.h so that platform independent code compiles unchanged
+**************************************************************************************************/
+
+#ifndef GEN_GNU_DEFINES_H_INCLUDED
+#define GEN_GNU_DEFINES_H_INCLUDED
+
+#include <string>
+using namespace std;
+
+namespace gen
+{
+
+/*------------------------------------------------------------------------------------------------
+	Compiler settings
+ ------------------------------------------------------------------------------------------------*/
+
+// Check compiler options
+#if !defined(__EXCEPTIONS) && !defined(__cpp_exceptions)
+	#error "Bad compiler option: C++ exception handling must be enabled"
+#endif
+
+
+/*------------------------------------------------------------------------------------------------
+	Macros
+ ------------------------------------------------------------------------------------------------*/
+
+// Prefix to align a structure or class in memory to a multiple of the given amount
+#define GEN_ALIGN(a) __attribute__((aligned(a)))
+
+
+/*------------------------------------------------------------------------------------------------
+	Constants
+ ------------------------------------------------------------------------------------------------*/
+
+// Define compiler name
+#if defined(__clang__)
+	static const string ksCompiler = "Clang";
+#else
+	static const string ksCompiler = "GCC";
+#endif
+
+
+// String locale
+const string ksPathSeparator = "/";
+const string ksNewline = "\n";
+
+
+/*------------------------------------------------------------------------------------------------
+	Types
+ ------------------------------------------------------------------------------------------------*/
+
+// Typedefs for fixed size types
+typedef signed char        TInt8;
+typedef signed short       TInt16;
+typedef signed int         TInt32;
+typedef signed long long   TInt64;
+
+typedef unsigned char      TUInt8;
+typedef unsigned short     TUInt16;
+typedef unsigned int       TUInt32;
+typedef unsigned long long TUInt64;
+
+typedef float              TFloat32;
+typedef double             TFloat64;
+
+
+/*------------------------------------------------------------------------------------------------
+	System message support
+ ------------------------------------------------------------------------------------------------*/
+
+// System message used to display errors or warnings. There is no GUI on these platforms so the
+// message is written to stderr. Yes/No requests cannot be answered and always return false
+bool SystemMessageBox
+(
+	const string& sMessage,                       // Main message to display
+	const string& sCaption = "TL-Engine Extreme", // Caption to display before message
+	const bool    bYesNo = false                  // Request Yes and No buttons instead of OK
+);
+
+
+/*------------------------------------------------------------------------------------------------
+	File support
+ ------------------------------------------------------------------------------------------------*/
+
+// Map a whole file into memory for reading. Returns a pointer to the file contents and its size
+// through the given pointer, or 0 if the file cannot be opened or is empty. Release with UnmapFile
+const void* MapFile
+(
+	const string& sFileName, // File to map
+	TUInt32*      pSize      // Returns size of file in bytes
+);
+
+// Release a file mapping returned by MapFile
+void UnmapFile
+(
+	const void*   pData, // Pointer returned by MapFile
+	const TUInt32 size   // Size returned by MapFile
+);
+
+// Get the last modification time of a file, returns false if the file does not exist. Times are
+// only comparable with each other
+bool GetFileModifiedTime
+(
+	const string& sFileName, // File to check
+	TUInt64*      pTime      // Returns modification time
+);
+
+// Get the canonical name of a file - its full path with any "." and ".." removed, in a form that
+// is the same however the file is named. Returns false if the file does not exist
+bool GetCanonicalFileName
+(
+	const string& sFileName,     // File to find
+	string*       pCanonicalName // Returns canonical name of file
+);
+
+
+} // namespace gen
+
+#endif // GEN_GNU_DEFINES_H_INCLUDED
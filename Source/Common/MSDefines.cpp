@@ -71,4 +71,100 @@ bool SystemMessageBox
 }
 
 
+/*------------------------------------------------------------------------------------------------
+	File support
+ ------------------------------------------------------------------------------------------------*/
+
+// Map a whole file into memory for reading. Returns a pointer to the file contents and its size
+// through the given pointer, or 0 if the file cannot be opened or is empty. Release with UnmapFile
+const void* MapFile
+(
+	const string& sFileName, // File to map
+	TUInt32*      pSize      // Returns size of file in bytes
+)
+{
+	HANDLE file = ::CreateFileA( sFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+	                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return 0;
+	}
+	LARGE_INTEGER fileSize;
+	if (!::GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart == 0 ||
+	    fileSize.QuadPart > 0xffffffff)
+	{
+		::CloseHandle( file );
+		return 0;
+	}
+
+	// The view keeps the file mapped after the handles are closed
+	HANDLE mapping = ::CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	::CloseHandle( file );
+	if (mapping == NULL)
+	{
+		return 0;
+	}
+	const void* pData = ::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	::CloseHandle( mapping );
+	if (pData == NULL)
+	{
+		return 0;
+	}
+
+	*pSize = static_cast<TUInt32>(fileSize.QuadPart);
+	return pData;
+}
+
+// Release a file mapping returned by MapFile
+void UnmapFile
+(
+	const void*   pData, // Pointer returned by MapFile
+	const TUInt32 size   // Size returned by MapFile
+)
+{
+	GEN_UNREFERENCED_PARAMETER( size );
+	::UnmapViewOfFile( pData );
+}
+
+// Get the last modification time of a file, returns false if the file does not exist. Times are
+// only comparable with each other
+bool GetFileModifiedTime
+(
+	const string& sFileName, // File to check
+	TUInt64*      pTime      // Returns modification time
+)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!::GetFileAttributesExA( sFileName.c_str(), GetFileExInfoStandard, &attributes ))
+	{
+		return false;
+	}
+	*pTime = (static_cast<TUInt64>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+	         attributes.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+
+// Get the canonical name of a file - its full path with any "." and ".." removed, in a form that
+// is the same however the file is named. Returns false if the file does not exist. File names
+// are not case sensitive on these platforms, so the name is returned in lower case
+bool GetCanonicalFileName
+(
+	const string& sFileName,     // File to find
+	string*       pCanonicalName // Returns canonical name of file
+)
+{
+	char fullName[MAX_PATH];
+	DWORD length = ::GetFullPathNameA( sFileName.c_str(), MAX_PATH, fullName, NULL );
+	if (length == 0 || length >= MAX_PATH ||
+	    ::GetFileAttributesA( fullName ) == INVALID_FILE_ATTRIBUTES)
+	{
+		return false;
+	}
+	::CharLowerBuffA( fullName, length );
+	pCanonicalName->assign( fullName, length );
+	return true;
+}
+
+
 } // namespace gen
@@ -119,6 +119,42 @@ bool SystemMessageBox
 );
 
 
+/*------------------------------------------------------------------------------------------------
+	File support
+ ------------------------------------------------------------------------------------------------*/
+
+// Map a whole file into memory for reading. Returns a pointer to the file contents and its size
+// through the given pointer, or 0 if the file cannot be opened or is empty. Release with UnmapFile
+const void* MapFile
+(
+	const string& sFileName, // File to map
+	TUInt32*      pSize      // Returns size of file in bytes
+);
+
+// Release a file mapping returned by MapFile
+void UnmapFile
+(
+	const void*   pData, // Pointer returned by MapFile
+	const TUInt32 size   // Size returned by MapFile
+);
+
+// Get the last modification time of a file, returns false if the file does not exist. Times are
+// only comparable with each other
+bool GetFileModifiedTime
+(
+	const string& sFileName, // File to check
+	TUInt64*      pTime      // Returns modification time
+);
+
+// Get the canonical name of a file - its full path with any "." and ".." removed, in a form that
+// is the same however the file is named. Returns false if the file does not exist
+bool GetCanonicalFileName
+(
+	const string& sFileName,     // File to find
+	string*       pCanonicalName // Returns canonical name of file
+);
+
+
 } // namespace gen
 
 #endif // GEN_MS_DEFINES_H_INCLUDED
@@ -14,6 +14,23 @@ namespace gen
 		tinyxml2::XMLElement* element = xmlDoc.FirstChildElement();
 		if (element == nullptr)  return false;
 
+		// Loading is done in two phases. First read the templates in each "Level" tag at the root level
+		m_Templates.clear();
+		while (element != nullptr)
+		{
+			string elementName = element->Name();
+			if (elementName == "Level")
+			{
+				ParseLevelTemplates(element);
+			}
+
+			element = element->NextSiblingElement();
+		}
+
+		// Then load all the templates' meshes together and create the templates, which the entities need
+		if (!CreateTemplates())  return false;
+
+		element = xmlDoc.FirstChildElement();
 		while (element != nullptr)
 		{
 			// We found a "Level" tag at the root level, parse it
@@ -34,15 +51,26 @@ namespace gen
 		return true;
 	}
 
+	bool CParseLevel::ParseLevelTemplates(tinyxml2::XMLElement* rootElement)
+	{
+		tinyxml2::XMLElement* element = rootElement->FirstChildElement("Templates");
+		while (element != nullptr)
+		{
+			ParseTemplatesElement(element);
+			element = element->NextSiblingElement("Templates");
+		}
+
+		return true;
+	}
+
 	bool CParseLevel::ParseLevelElement(tinyxml2::XMLElement* rootElement)
 	{
 		tinyxml2::XMLElement* element = rootElement->FirstChildElement();
 		while (element != nullptr)
 		{
-			// Things expected in a "Level" tag
+			// Things expected in a "Level" tag, templates have already been read
 			string elementName = element->Name();
-			if (elementName == "Templates")  ParseTemplatesElement(element);
-			else if (elementName == "Entities")  ParseEntitiesElement(element);
+			if (elementName == "Entities")  ParseEntitiesElement(element);
 			else if (elementName == "Patrol") ParsePatrolPointsElement(element);
 			// You could add more tags within Level here (not needed for exercise, just saying)
 
@@ -70,6 +98,10 @@ namespace gen
 			if (attr == nullptr)  return false;
 			string mesh = attr->Value();
 
+			STemplateDesc templateDesc = {};
+			templateDesc.type = type;
+			templateDesc.name = name;
+			templateDesc.mesh = mesh;
 
 			if (type == "Tank")
 			{
@@ -98,20 +130,24 @@ namespace gen
 				int shellDamage = attr->IntValue();
 
 
-				m_EntityManager->CreateTankTemplate(type, name, mesh, maxSpeed, acceleration, turnSpeed, turretTurnSpeed, maxHP, shellDamage);
+				templateDesc.maxSpeed = maxSpeed;
+				templateDesc.acceleration = acceleration;
+				templateDesc.turnSpeed = turnSpeed;
+				templateDesc.turretTurnSpeed = turretTurnSpeed;
+				templateDesc.maxHP = maxHP;
+				templateDesc.shellDamage = shellDamage;
 			}
 			else if (type == "AmmoBox")
 			{
 				attr = element->FindAttribute("Gravity");
 				if (attr == nullptr)  return false;
 				float gravity = attr->FloatValue();
-				m_EntityManager->CreateAmmoBoxTemplate(type, name, mesh, gravity);
-			}
-			else
-			{
-				m_EntityManager->CreateTemplate(type, name, mesh);
+				templateDesc.gravity = gravity;
 			}
 
+			// The template is created once all the meshes are loaded
+			m_Templates.push_back(templateDesc);
+
 
 			// Find next entity template
 			element = element->NextSiblingElement("EntityTemplate");
@@ -120,6 +156,43 @@ namespace gen
 		return true;
 	}
 
+	// Load the meshes of all the templates read, then create the templates. The meshes are loaded
+	// together so the entity manager can import them in parallel. Returns false if any mesh cannot be loaded
+	// or any template cannot be created
+	bool CParseLevel::CreateTemplates()
+	{
+		vector<string> meshes;
+		for (TUInt32 i = 0; i < m_Templates.size(); ++i)
+		{
+			meshes.push_back(m_Templates[i].mesh);
+		}
+		if (!m_EntityManager->PreloadMeshes(meshes))  return false;
+
+		bool success = true;
+		for (TUInt32 i = 0; i < m_Templates.size() && success; ++i)
+		{
+			const STemplateDesc& desc = m_Templates[i];
+			if (desc.type == "Tank")
+			{
+				success = m_EntityManager->CreateTankTemplate(desc.type, desc.name, desc.mesh, desc.maxSpeed, desc.acceleration, desc.turnSpeed,
+				                                              desc.turretTurnSpeed, desc.maxHP, desc.shellDamage) != nullptr;
+			}
+			else if (desc.type == "AmmoBox")
+			{
+				success = m_EntityManager->CreateAmmoBoxTemplate(desc.type, desc.name, desc.mesh, desc.gravity) != nullptr;
+			}
+			else
+			{
+				success = m_EntityManager->CreateTemplate(desc.type, desc.name, desc.mesh) != nullptr;
+			}
+		}
+
+		// The templates now hold the meshes
+		m_EntityManager->ReleasePreloadedMeshes();
+		m_Templates.clear();
+		return success;
+	}
+
 	bool CParseLevel::ParseEntitiesElement(tinyxml2::XMLElement* rootElement)
 	{
 		tinyxml2::XMLElement* element = rootElement->FirstChildElement("Entity");
@@ -238,6 +311,19 @@ namespace gen
 
 	bool CParseLevel::ParsePatrolPointsElement(tinyxml2::XMLElement* rootElement)
 	{
+		CPatrolPoints& patrolPoints = m_EntityManager->PatrolPoints();
+
+		// Optional policy for choosing the next patrol point - "Random" (default), "Weighted" or "Nearest"
+		const char* policy = rootElement->Attribute("Policy");
+		if (policy != nullptr)
+		{
+			string policyName = policy;
+			if      (policyName == "Random")   patrolPoints.SetPolicy(Patrol_Random);
+			else if (policyName == "Weighted") patrolPoints.SetPolicy(Patrol_Weighted);
+			else if (policyName == "Nearest")  patrolPoints.SetPolicy(Patrol_NearestUnvisited);
+			else return false;
+		}
+
 		// Find team elements
 		tinyxml2::XMLElement* teamElement = rootElement->FirstChildElement("Team");
 		while (teamElement != nullptr)
@@ -262,11 +348,11 @@ namespace gen
 				if (attr == nullptr)  return false;
 				float Z = attr->FloatValue();
 
-				CEntityManager::SPatrolPoints point;
-				point.teamNum = team;
-				point.PatrolPoints = { X, 0.5f, Z };
+				// Zone and weight are optional
+				unsigned int zone = element->UnsignedAttribute("Zone", 0);
+				float weight = element->FloatAttribute("Weight", 1.0f);
 
-				m_EntityManager->PushPatrolPoints(point);
+				patrolPoints.AddPoint(team, { X, 0.5f, Z }, zone, weight);
 
 				// Next entity in this team
 				element = element->NextSiblingElement("Point");
@@ -277,6 +363,9 @@ namespace gen
 
 		}
 
+		// Index the points for selection
+		patrolPoints.Build();
+
 		return true;
 	}
 
@@ -301,15 +390,15 @@ namespace gen
 
 			attr = child->FindAttribute("X");
 			if (attr != nullptr)  random = attr->FloatValue() * 0.5f;
-			vector.x += Random(-random, random);
+			vector.x += m_Random->Random(-random, random);
 
 			attr = child->FindAttribute("Y");
 			if (attr != nullptr)  random = attr->FloatValue() * 0.5f;
-			vector.y += Random(-random, random);
+			vector.y += m_Random->Random(-random, random);
 
 			attr = child->FindAttribute("Z");
 			if (attr != nullptr)  random = attr->FloatValue() * 0.5f;
-			vector.z += Random(-random, random);
+			vector.z += m_Random->Random(-random, random);
 		}
 
 
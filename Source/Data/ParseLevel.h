@@ -1,8 +1,13 @@
 #pragma once
 
+#include <string>
+#include <vector>
+using namespace std;
+
 #include "TinyXML2/tinyxml2.h"
 #include "Defines.h"
 #include "CVector3.h"
+#include "CRandom.h"
 #include "EntityManager.h"
 
 namespace gen
@@ -11,7 +16,8 @@ namespace gen
 	class CParseLevel
 	{
 	public:
-		CParseLevel(CEntityManager* entityManager) : m_EntityManager(entityManager)
+		// The given random number generator is used for any randomised values in the level
+		CParseLevel(CEntityManager* entityManager, CRandom* random) : m_EntityManager(entityManager), m_Random(random)
 		{
 		}
 
@@ -19,14 +25,41 @@ namespace gen
 
 	private:
 
+		// Entity template read from the level. Levels are loaded in two phases: first all the
+		// templates are read, then their meshes are loaded together (in parallel) and the
+		// templates are created, followed by the entities
+		struct STemplateDesc
+		{
+			string type;
+			string name;
+			string mesh;
+
+			// Tank stats
+			float maxSpeed;
+			float acceleration;
+			float turnSpeed;
+			float turretTurnSpeed;
+			int maxHP;
+			int shellDamage;
+
+			// Ammo box stats
+			float gravity;
+		};
+
 		bool ParseLevelElement(tinyxml2::XMLElement* rootElement);
+		bool ParseLevelTemplates(tinyxml2::XMLElement* rootElement);
 		bool ParseTemplatesElement(tinyxml2::XMLElement* rootElement);
+		bool CreateTemplates();
 		bool ParseEntitiesElement(tinyxml2::XMLElement* rootElement);
 		bool ParsePatrolPointsElement(tinyxml2::XMLElement* rootElement);
 
 		CVector3 GetVector3FromElement(tinyxml2::XMLElement* rootElement);
 
 		CEntityManager* m_EntityManager;
+		CRandom* m_Random;
+
+		// Templates read in the first phase of loading
+		vector<STemplateDesc> m_Templates;
 	};
 }
 
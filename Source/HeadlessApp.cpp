@@ -0,0 +1,115 @@
+/*******************************************
+	HeadlessApp.cpp
+
+	Headless simulation entry point - runs the
+	tank battle without a window or DirectX
+	and reports simulation throughput
+
+	Build with GEN_HEADLESS defined, from all
+	sources except MainApp.cpp,
+	TankAssignment.cpp, CTimer.cpp and
+	MSDefines.cpp (and the standalone
+	programs in Source/Benchmark and
+	Source/Tools)
+********************************************/
+
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+#include "EntityManager.h"
+#include "Simulation.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// System Variables
+//-----------------------------------------------------------------------------
+
+// Resource folders
+extern const string MediaFolder;
+const string MediaFolder = "Media" + ksPathSeparator;
+
+// Entity manager from Simulation.cpp
+extern CEntityManager EntityManager;
+
+
+//-----------------------------------------------------------------------------
+// Simulation run
+//-----------------------------------------------------------------------------
+
+// Step the simulation by a fixed tick time until the tick count is reached or the game is won.
+// Results are written to stdout as "key: value" lines. A run can be repeated exactly by passing
+// the same seed
+bool RunHeadless( const string& levelFile, TUInt32 maxTicks, float tickTime, TUInt32 numThreads,
+                  TUInt64 seed )
+{
+	if (!SimulationSetup( levelFile, seed, numThreads ))
+	{
+		cerr << "Error loading level " << levelFile << endl;
+		return false;
+	}
+
+	// Equivalent of pressing the start key in the windowed application
+	StartTanks();
+
+	chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+	TUInt32 tick = 0;
+	while (tick < maxTicks && !IsGameOver())
+	{
+		UpdateSimulation( tickTime );
+		++tick;
+	}
+	chrono::duration<double> wallTime = chrono::steady_clock::now() - startTime;
+
+	cout << "seed: " << seed << endl;
+	cout << "ticks: " << tick << endl;
+	cout << "tick_time: " << tickTime << endl;
+	cout << "simulated_seconds: " << tick * tickTime << endl;
+	cout << "wall_seconds: " << wallTime.count() << endl;
+	cout << "ticks_per_second: " << (wallTime.count() > 0.0 ? tick / wallTime.count() : 0.0) << endl;
+	cout << "entities: " << EntityManager.NumEntities() << endl;
+	cout << "team_one_score: " << EntityManager.GetTeamOneScore() << endl;
+	cout << "team_two_score: " << EntityManager.GetTeamTwoScore() << endl;
+	cout << "winner: " << (IsGameOver() ? GetWinningTeam() : "None") << endl;
+
+	SimulationShutdown();
+	return true;
+}
+
+
+} // namespace gen
+
+
+//-----------------------------------------------------------------------------
+// Main function - outside of namespace
+//-----------------------------------------------------------------------------
+
+// Usage: TankHeadless [max ticks] [tick time in seconds] [level file] [threads, 0 for all] [seed]
+// The seed defaults to the current time, it is reported with the results
+int main( int argc, char* argv[] )
+{
+	gen::TUInt32 maxTicks = 100000;
+	float tickTime = 1.0f / 60.0f;
+	string levelFile = "Scene.xml";
+	gen::TUInt32 numThreads = 0;
+	gen::TUInt64 seed = static_cast<gen::TUInt64>(time( 0 ));
+
+	if (argc > 1) maxTicks = static_cast<gen::TUInt32>(strtoul( argv[1], 0, 10 ));
+	if (argc > 2) tickTime = static_cast<float>(atof( argv[2] ));
+	if (argc > 3) levelFile = argv[3];
+	if (argc > 4) numThreads = static_cast<gen::TUInt32>(strtoul( argv[4], 0, 10 ));
+	if (argc > 5) seed = strtoull( argv[5], 0, 10 );
+	if (maxTicks == 0 || tickTime <= 0.0f)
+	{
+		cerr << "Usage: " << argv[0] << " [max ticks] [tick time in seconds] [level file] [threads, 0 for all] [seed]" << endl;
+		return EXIT_FAILURE;
+	}
+
+	return gen::RunHeadless( levelFile, maxTicks, tickTime, numThreads, seed ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
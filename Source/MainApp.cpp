@@ -278,10 +278,11 @@ INT WINAPI WinMain( HINSTANCE hInst, HINSTANCE, LPSTR, INT )
                 }
                 else
 				{
-					// Render and update the scene - using variable timing
+					// Update and render the scene - the simulation runs in fixed steps within the
+					// frame time, and rendering interpolates between the steps
 					float updateTime = gen::Timer.GetLapTime();
-                    gen::RenderScene( updateTime );
 					gen::UpdateScene( updateTime );
+                    gen::RenderScene( updateTime );
 
 					// Toggle fullscreen / windowed
 					if (gen::KeyHit( gen::Key_F1 ))
@@ -76,7 +76,11 @@ enum ERoundingMethod
 // Many versions provided here to allow mixing of parameter types for these basic functions
 
 inline TUInt32 Abs( const TInt32 x ) { return abs( static_cast<int>(x) ); }
+#if defined(_MSC_VER)
 inline TUInt64 Abs( const TInt64 x ) { return _abs64( x ); }
+#else
+inline TUInt64 Abs( const TInt64 x ) { return llabs( x ); }
+#endif
 inline TFloat32 Abs( const TFloat32 x ) { return fabsf( x ); }
 inline TFloat64 Abs( const TFloat64 x ) { return fabs( x ); }
 
@@ -476,9 +480,10 @@ inline C Max( const C a, const C b ) { return (!(b < a) ? b : a); }
 inline TInt32 Random( const TInt32 a, const TInt32 b )
 {
 	// Could just use a + rand() % (b-a), but using a more complex form to allow range
-	// to exceed RAND_MAX and still return values spread across the range
-	TInt32 t = (b - a + 1) * rand();
-	return t == 0 ? a : a + (t - 1) / RAND_MAX;
+	// to exceed RAND_MAX and still return values spread across the range. Use 64-bit maths as
+	// the product overflows 32 bits where RAND_MAX is large (e.g. GCC)
+	TInt64 t = static_cast<TInt64>(b - a + 1) * rand();
+	return t == 0 ? a : a + static_cast<TInt32>((t - 1) / RAND_MAX);
 }
 
 // Return random 32-bit float from a to b (inclusive)
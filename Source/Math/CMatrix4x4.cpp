@@ -23,10 +23,161 @@
 #include "CMatrix2x2.h"
 #include "CMatrix3x3.h"
 #include "CQuaternion.h"
+#include "MathSIMD.h"
 
 namespace gen
 {
 
+#ifdef GEN_SSE
+/*-----------------------------------------------------------------------------------------
+	SIMD Support
+-----------------------------------------------------------------------------------------*/
+// See MathSIMD.h for the selection of these code paths
+
+// Load/store a row of a matrix to/from an SSE register
+static inline __m128 LoadRow( const CMatrix4x4& m, const TUInt32 row )
+{
+	return _mm_loadu_ps( &m.e00 + row * 4 );
+}
+static inline void StoreRow( CMatrix4x4& m, const TUInt32 row, const __m128 v )
+{
+	_mm_storeu_ps( &m.e00 + row * 4, v );
+}
+
+// Return an SSE register with all four elements set to element i of the given register
+#define GEN_SSE_SPLAT( v, i ) _mm_shuffle_ps( (v), (v), _MM_SHUFFLE( i, i, i, i ) )
+
+// Return row vector v multiplied by the matrix with rows r0-r3 (V' = V*M)
+static inline __m128 RowMultiply
+(
+	const __m128 v,
+	const __m128 r0, const __m128 r1, const __m128 r2, const __m128 r3
+)
+{
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( GEN_SSE_SPLAT( v, 0 ), r0 ),
+	                               _mm_mul_ps( GEN_SSE_SPLAT( v, 1 ), r1 ) ),
+	                   _mm_add_ps( _mm_mul_ps( GEN_SSE_SPLAT( v, 2 ), r2 ),
+	                               _mm_mul_ps( GEN_SSE_SPLAT( v, 3 ), r3 ) ) );
+}
+
+// As above but ignoring the final element of v (i.e. multiplying by the upper 3 rows only)
+static inline __m128 RowMultiply3
+(
+	const __m128 v,
+	const __m128 r0, const __m128 r1, const __m128 r2
+)
+{
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( GEN_SSE_SPLAT( v, 0 ), r0 ),
+	                               _mm_mul_ps( GEN_SSE_SPLAT( v, 1 ), r1 ) ),
+	                   _mm_mul_ps( GEN_SSE_SPLAT( v, 2 ), r2 ) );
+}
+
+// Mask selecting the first three elements of a register (the x, y & z of a row)
+static inline __m128 MaskXYZ()
+{
+	return _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+}
+
+// Return the given register with its final element replaced by the final element of another
+static inline __m128 SelectXYZ( const __m128 xyz, const __m128 w )
+{
+	return _mm_or_ps( _mm_and_ps( MaskXYZ(), xyz ), _mm_andnot_ps( MaskXYZ(), w ) );
+}
+
+// Return the cross product of the first three elements of two registers, final element is 0
+static inline __m128 Cross3( const __m128 a, const __m128 b )
+{
+	__m128 aYZX = _mm_shuffle_ps( a, a, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+	__m128 bYZX = _mm_shuffle_ps( b, b, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+	__m128 cZXY = _mm_sub_ps( _mm_mul_ps( a, bYZX ), _mm_mul_ps( aYZX, b ) );
+	return _mm_shuffle_ps( cZXY, cZXY, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+}
+
+// Return the sum of the four elements of a register in all four elements
+static inline __m128 HorizontalSum( const __m128 v )
+{
+	__m128 t = _mm_add_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_add_ps( t, _mm_shuffle_ps( t, t, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+}
+
+// 2x2 matrix operations for the general inverse. A 2x2 matrix is held in a register in row
+// order: (m00, m01, m10, m11). The adjugate (A#) of a 2x2 matrix is its inverse multiplied by
+// its determinant
+// Return A*B
+static inline __m128 Mat2Mul( const __m128 a, const __m128 b )
+{
+	return _mm_add_ps( _mm_mul_ps( a, _mm_shuffle_ps( b, b, _MM_SHUFFLE( 3, 0, 3, 0 ) ) ),
+	                   _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 3, 0, 1 ) ),
+	                               _mm_shuffle_ps( b, b, _MM_SHUFFLE( 1, 2, 1, 2 ) ) ) );
+}
+// Return A#*B
+static inline __m128 Mat2AdjMul( const __m128 a, const __m128 b )
+{
+	return _mm_sub_ps( _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 0, 0, 3, 3 ) ), b ),
+	                   _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 2, 1, 1 ) ),
+	                               _mm_shuffle_ps( b, b, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+}
+// Return A*B#
+static inline __m128 Mat2MulAdj( const __m128 a, const __m128 b )
+{
+	return _mm_sub_ps( _mm_mul_ps( a, _mm_shuffle_ps( b, b, _MM_SHUFFLE( 0, 3, 0, 3 ) ) ),
+	                   _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 3, 0, 1 ) ),
+	                               _mm_shuffle_ps( b, b, _MM_SHUFFLE( 1, 2, 1, 2 ) ) ) );
+}
+
+// Batch operations work on four points at a time with one register for each of the x, y & z
+// components of the four points (structure of arrays). Load four consecutive CVector3 (12
+// floats) into x, y & z registers
+static inline void LoadPoints3( const TFloat32* p, __m128& x, __m128& y, __m128& z )
+{
+	__m128 a = _mm_loadu_ps( p );     // x0 y0 z0 x1
+	__m128 b = _mm_loadu_ps( p + 4 ); // y1 z1 x2 y2
+	__m128 c = _mm_loadu_ps( p + 8 ); // z2 x3 y3 z3
+
+	__m128 xy23 = _mm_shuffle_ps( b, c, _MM_SHUFFLE( 2, 1, 3, 2 ) ); // x2 y2 x3 y3
+	x = _mm_shuffle_ps( a, xy23, _MM_SHUFFLE( 2, 0, 3, 0 ) );
+	y = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 0, 0, 1, 1 ) ), xy23, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+	z = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 1, 1, 2, 2 ) ),
+	                    _mm_shuffle_ps( c, c, _MM_SHUFFLE( 3, 3, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+}
+
+// Store x, y & z registers as four consecutive CVector3
+static inline void StorePoints3( TFloat32* p, const __m128 x, const __m128 y, const __m128 z )
+{
+	__m128 xy01 = _mm_unpacklo_ps( x, y ); // x0 y0 x1 y1
+	__m128 xy23 = _mm_unpackhi_ps( x, y ); // x2 y2 x3 y3
+	__m128 zx01 = _mm_shuffle_ps( z, x, _MM_SHUFFLE( 1, 1, 0, 0 ) ); // z0 z0 x1 x1
+	__m128 yz11 = _mm_shuffle_ps( y, z, _MM_SHUFFLE( 1, 1, 1, 1 ) ); // y1 y1 z1 z1
+	__m128 zx23 = _mm_shuffle_ps( z, x, _MM_SHUFFLE( 3, 3, 2, 2 ) ); // z2 z2 x3 x3
+	__m128 yz33 = _mm_shuffle_ps( y, z, _MM_SHUFFLE( 3, 3, 3, 3 ) ); // y3 y3 z3 z3
+
+	_mm_storeu_ps( p,     _mm_shuffle_ps( xy01, zx01, _MM_SHUFFLE( 2, 0, 1, 0 ) ) );
+	_mm_storeu_ps( p + 4, _mm_shuffle_ps( yz11, xy23, _MM_SHUFFLE( 1, 0, 2, 0 ) ) );
+	_mm_storeu_ps( p + 8, _mm_shuffle_ps( zx23, yz33, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+}
+
+// Set each of the 16 registers given to one element of a matrix (in row order), so the matrix
+// can be applied to four points at once
+static inline void SplatMatrix( const CMatrix4x4& m, __m128 s[16] )
+{
+	for (TUInt32 i = 0; i < 16; ++i)
+	{
+		s[i] = _mm_set1_ps( (&m.e00)[i] );
+	}
+}
+
+// Return element i of four points x, y & z multiplied by the upper 3 rows of a splatted matrix
+static inline __m128 SplatMultiply3
+(
+	const __m128 x, const __m128 y, const __m128 z,
+	const __m128 s[16], const TUInt32 i
+)
+{
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, s[i] ), _mm_mul_ps( y, s[4 + i] ) ),
+	                   _mm_mul_ps( z, s[8 + i] ) );
+}
+#endif // GEN_SSE
+
 /*-----------------------------------------------------------------------------------------
 	Constructors/Destructors
 -----------------------------------------------------------------------------------------*/
@@ -1880,6 +2031,35 @@ CMatrix4x4 InverseAffine( const CMatrix4x4& m )
 
 	CMatrix4x4 mOut;
 
+#ifdef GEN_SSE
+	// The inverse of the upper left 3x3 has columns formed from cross products of its rows,
+	// divided by the determinant
+	__m128 r0 = LoadRow( m, 0 );
+	__m128 r1 = LoadRow( m, 1 );
+	__m128 r2 = LoadRow( m, 2 );
+	__m128 inv0 = Cross3( r1, r2 );
+	__m128 inv1 = Cross3( r2, r0 );
+	__m128 inv2 = Cross3( r0, r1 );
+	__m128 inv3 = _mm_setzero_ps();
+	__m128 det = HorizontalSum( _mm_mul_ps( r0, inv0 ) );
+	GEN_ASSERT( !IsZero(_mm_cvtss_f32( det )), "Singular matrix" );
+
+	// Transpose columns into rows and divide by determinant, the final column becomes 0
+	_MM_TRANSPOSE4_PS( inv0, inv1, inv2, inv3 );
+	__m128 invDet = _mm_div_ps( _mm_set1_ps( 1.0f ), det );
+	inv0 = _mm_mul_ps( inv0, invDet );
+	inv1 = _mm_mul_ps( inv1, invDet );
+	inv2 = _mm_mul_ps( inv2, invDet );
+
+	// Transform negative translation by inverted 3x3 to get inverse, with 1 in final column
+	__m128 pos = RowMultiply3( LoadRow( m, 3 ), inv0, inv1, inv2 );
+	pos = _mm_sub_ps( _mm_setr_ps( 0.0f, 0.0f, 0.0f, 1.0f ), _mm_and_ps( MaskXYZ(), pos ) );
+
+	StoreRow( mOut, 0, inv0 );
+	StoreRow( mOut, 1, inv1 );
+	StoreRow( mOut, 2, inv2 );
+	StoreRow( mOut, 3, pos );
+#else
 	// Calculate determinant of upper left 3x3
 	TFloat32 det0 = m.e11*m.e22 - m.e12*m.e21;
 	TFloat32 det1 = m.e12*m.e20 - m.e10*m.e22;
@@ -1911,6 +2091,7 @@ CMatrix4x4 InverseAffine( const CMatrix4x4& m )
 	mOut.e13 = 0.0f;
 	mOut.e23 = 0.0f;
 	mOut.e33 = 1.0f;
+#endif
 
 	return mOut;
 
@@ -1975,6 +2156,58 @@ CMatrix4x4 Inverse( const CMatrix4x4& m )
 
 	CMatrix4x4 mOut;
 
+#ifdef GEN_SSE
+	// Treat the matrix as 2x2 blocks of 2x2 matrices:  | A B |
+	//                                                   | C D |
+	// and use the block formula for the inverse, which only needs 2x2 matrix operations
+	__m128 r0 = LoadRow( m, 0 );
+	__m128 r1 = LoadRow( m, 1 );
+	__m128 r2 = LoadRow( m, 2 );
+	__m128 r3 = LoadRow( m, 3 );
+	__m128 a = _mm_movelh_ps( r0, r1 );
+	__m128 b = _mm_movehl_ps( r1, r0 );
+	__m128 c = _mm_movelh_ps( r2, r3 );
+	__m128 d = _mm_movehl_ps( r3, r2 );
+
+	// Determinants of the blocks as (|A|, |B|, |C|, |D|)
+	__m128 detBlocks = _mm_sub_ps
+	(
+		_mm_mul_ps( _mm_shuffle_ps( r0, r2, _MM_SHUFFLE( 2, 0, 2, 0 ) ),
+		            _mm_shuffle_ps( r1, r3, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ),
+		_mm_mul_ps( _mm_shuffle_ps( r0, r2, _MM_SHUFFLE( 3, 1, 3, 1 ) ),
+		            _mm_shuffle_ps( r1, r3, _MM_SHUFFLE( 2, 0, 2, 0 ) ) )
+	);
+	__m128 detA = GEN_SSE_SPLAT( detBlocks, 0 );
+	__m128 detB = GEN_SSE_SPLAT( detBlocks, 1 );
+	__m128 detC = GEN_SSE_SPLAT( detBlocks, 2 );
+	__m128 detD = GEN_SSE_SPLAT( detBlocks, 3 );
+
+	// Adjugates of the blocks of the inverse (X Y / Z W), before dividing by the determinant
+	__m128 adjDC = Mat2AdjMul( d, c );
+	__m128 adjAB = Mat2AdjMul( a, b );
+	__m128 x = _mm_sub_ps( _mm_mul_ps( detD, a ), Mat2Mul( b, adjDC ) );
+	__m128 w = _mm_sub_ps( _mm_mul_ps( detA, d ), Mat2Mul( c, adjAB ) );
+	__m128 y = _mm_sub_ps( _mm_mul_ps( detB, c ), Mat2MulAdj( d, adjAB ) );
+	__m128 z = _mm_sub_ps( _mm_mul_ps( detC, b ), Mat2MulAdj( a, adjDC ) );
+
+	// Determinant is |A||D| + |B||C| - trace((A#B)(D#C))
+	__m128 trace = HorizontalSum( _mm_mul_ps( adjAB, _mm_shuffle_ps( adjDC, adjDC, _MM_SHUFFLE( 3, 1, 2, 0 ) ) ) );
+	__m128 det = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( detA, detD ), _mm_mul_ps( detB, detC ) ), trace );
+	GEN_ASSERT( !IsZero(_mm_cvtss_f32( det )), "Singular matrix" );
+
+	// Divide by determinant, including the signs needed to take the adjugates of the blocks
+	__m128 invDet = _mm_div_ps( _mm_setr_ps( 1.0f, -1.0f, -1.0f, 1.0f ), det );
+	x = _mm_mul_ps( x, invDet );
+	y = _mm_mul_ps( y, invDet );
+	z = _mm_mul_ps( z, invDet );
+	w = _mm_mul_ps( w, invDet );
+
+	// Take adjugates of blocks and rearrange into rows
+	StoreRow( mOut, 0, _mm_shuffle_ps( x, y, _MM_SHUFFLE( 1, 3, 1, 3 ) ) );
+	StoreRow( mOut, 1, _mm_shuffle_ps( x, y, _MM_SHUFFLE( 0, 2, 0, 2 ) ) );
+	StoreRow( mOut, 2, _mm_shuffle_ps( z, w, _MM_SHUFFLE( 1, 3, 1, 3 ) ) );
+	StoreRow( mOut, 3, _mm_shuffle_ps( z, w, _MM_SHUFFLE( 0, 2, 0, 2 ) ) );
+#else
 	// Calculate determinant
 	TFloat32 det = m.e00 * Cofactor( m, 0, 0 ) + m.e01 * Cofactor( m, 0, 1 ) + 
 	               m.e02 * Cofactor( m, 0, 2 ) + m.e03 * Cofactor( m, 0, 3 ); 
@@ -1989,6 +2222,7 @@ CMatrix4x4 Inverse( const CMatrix4x4& m )
 			mOut[i][j] = invDet * Cofactor( m, j, i );
 		}
 	}
+#endif
 
 	return mOut;
 
@@ -3115,6 +3349,9 @@ CVector4 operator*
 	const CMatrix4x4& m
 )
 {
+#ifdef GEN_SSE
+	return m.Transform( v );
+#else
     CVector4 vOut;
     vOut.x = v.x*m.e00 + v.y*m.e10 + v.z*m.e20 + v.w*m.e30;
     vOut.y = v.x*m.e01 + v.y*m.e11 + v.z*m.e21 + v.w*m.e31;
@@ -3122,6 +3359,7 @@ CVector4 operator*
     vOut.w = v.x*m.e03 + v.y*m.e13 + v.z*m.e23 + v.w*m.e33;
 
     return vOut;
+#endif
 }
 
 // Matrix-vector multiplication (order is important - this is an unusual order for matrices
@@ -3146,10 +3384,18 @@ CVector4 operator*
 CVector4 CMatrix4x4::Transform(	const CVector4& v ) const
 {
 	CVector4 vOut;
+#ifdef GEN_SSE
+	// Vectors are often just written element by element, so set the register from the elements
+	// rather than loading it - a wide load of recently written narrow elements is slow
+	__m128 vIn = _mm_setr_ps( v.x, v.y, v.z, v.w );
+	_mm_storeu_ps( &vOut.x, RowMultiply( vIn, LoadRow( *this, 0 ), LoadRow( *this, 1 ),
+	                                          LoadRow( *this, 2 ), LoadRow( *this, 3 ) ) );
+#else
 	vOut.x = v.x*e00 + v.y*e10 + v.z*e20 + v.w*e30;
 	vOut.y = v.x*e01 + v.y*e11 + v.z*e21 + v.w*e31;
 	vOut.z = v.x*e02 + v.y*e12 + v.z*e22 + v.w*e32;
 	vOut.w = v.x*e03 + v.y*e13 + v.z*e23 + v.w*e33;
+#endif
 
 	return vOut;
 }
@@ -3158,24 +3404,41 @@ CVector4 CMatrix4x4::Transform(	const CVector4& v ) const
 // Assuming it is a vector rather then a point, i.e. assume the vector's 4th element is 0
 CVector3 CMatrix4x4::TransformVector( const CVector3& v ) const
 {
+#ifdef GEN_SSE
+	// A CVector3 is too small for a 4-float load or store, so go through an array
+	__m128 vIn = _mm_setr_ps( v.x, v.y, v.z, 0.0f );
+	TFloat32 out[4];
+	_mm_storeu_ps( out, RowMultiply3( vIn, LoadRow( *this, 0 ), LoadRow( *this, 1 ), LoadRow( *this, 2 ) ) );
+	return CVector3( out );
+#else
 	CVector3 vOut;
 	vOut.x = v.x*e00 + v.y*e10 + v.z*e20;
 	vOut.y = v.x*e01 + v.y*e11 + v.z*e21;
 	vOut.z = v.x*e02 + v.y*e12 + v.z*e22;
 
 	return vOut;
+#endif
 }
 
 // Return the given CVector3 transformed by this matrix (pre-multiplication: V' = V*M)
 // Assuming it is a point rather then a vector, i.e. assume the vector's 4th element is 1
 CVector3 CMatrix4x4::TransformPoint( const CVector3& p ) const
 {
+#ifdef GEN_SSE
+	// A CVector3 is too small for a 4-float load or store, so go through an array
+	__m128 pIn = _mm_setr_ps( p.x, p.y, p.z, 0.0f );
+	TFloat32 out[4];
+	_mm_storeu_ps( out, _mm_add_ps( RowMultiply3( pIn, LoadRow( *this, 0 ), LoadRow( *this, 1 ), LoadRow( *this, 2 ) ),
+	                                LoadRow( *this, 3 ) ) );
+	return CVector3( out );
+#else
 	CVector3 pOut;
 	pOut.x = p.x*e00 + p.y*e10 + p.z*e20 + e30;
 	pOut.y = p.x*e01 + p.y*e11 + p.z*e21 + e31;
 	pOut.z = p.x*e02 + p.y*e12 + p.z*e22 + e32;
 
 	return pOut;
+#endif
 }
 
 
@@ -3185,6 +3448,10 @@ CVector3 CMatrix4x4::TransformPoint( const CVector3& p ) const
 // Post-multiply this matrix by the given one
 CMatrix4x4& CMatrix4x4::operator*=( const CMatrix4x4& m )
 {
+#ifdef GEN_SSE
+	// SIMD version reads all inputs before writing, so can use the binary version in all cases
+	*this = *this * m;
+#else
 	if ( this == &m )
 	{
 		// Special case of multiplying by self - no copy optimisations so use binary version
@@ -3226,6 +3493,7 @@ CMatrix4x4& CMatrix4x4::operator*=( const CMatrix4x4& m )
 		e31 = t1;
 		e32 = t2;
 	}
+#endif
 	return *this;
 }
 
@@ -3239,6 +3507,36 @@ CMatrix4x4 operator*
 {
 	CMatrix4x4 mOut;
 
+#if defined(GEN_AVX)
+	// Calculate two rows at once - each half of an AVX register holds a row of m1, and the rows of
+	// m2 are repeated in both halves
+	__m128 b0 = LoadRow( m2, 0 );
+	__m128 b1 = LoadRow( m2, 1 );
+	__m128 b2 = LoadRow( m2, 2 );
+	__m128 b3 = LoadRow( m2, 3 );
+	__m256 bb0 = _mm256_insertf128_ps( _mm256_castps128_ps256( b0 ), b0, 1 );
+	__m256 bb1 = _mm256_insertf128_ps( _mm256_castps128_ps256( b1 ), b1, 1 );
+	__m256 bb2 = _mm256_insertf128_ps( _mm256_castps128_ps256( b2 ), b2, 1 );
+	__m256 bb3 = _mm256_insertf128_ps( _mm256_castps128_ps256( b3 ), b3, 1 );
+	for (TUInt32 row = 0; row < 4; row += 2)
+	{
+		__m256 a = _mm256_loadu_ps( &m1.e00 + row * 4 );
+		__m256 r = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_permute_ps( a, 0x00 ), bb0 ),
+		                                         _mm256_mul_ps( _mm256_permute_ps( a, 0x55 ), bb1 ) ),
+		                          _mm256_add_ps( _mm256_mul_ps( _mm256_permute_ps( a, 0xaa ), bb2 ),
+		                                         _mm256_mul_ps( _mm256_permute_ps( a, 0xff ), bb3 ) ) );
+		_mm256_storeu_ps( &mOut.e00 + row * 4, r );
+	}
+#elif defined(GEN_SSE)
+	__m128 b0 = LoadRow( m2, 0 );
+	__m128 b1 = LoadRow( m2, 1 );
+	__m128 b2 = LoadRow( m2, 2 );
+	__m128 b3 = LoadRow( m2, 3 );
+	for (TUInt32 row = 0; row < 4; ++row)
+	{
+		StoreRow( mOut, row, RowMultiply( LoadRow( m1, row ), b0, b1, b2, b3 ) );
+	}
+#else
 	mOut.e00 = m1.e00*m2.e00 + m1.e01*m2.e10 + m1.e02*m2.e20 + m1.e03*m2.e30;
 	mOut.e01 = m1.e00*m2.e01 + m1.e01*m2.e11 + m1.e02*m2.e21 + m1.e03*m2.e31;
 	mOut.e02 = m1.e00*m2.e02 + m1.e01*m2.e12 + m1.e02*m2.e22 + m1.e03*m2.e32;
@@ -3258,6 +3556,7 @@ CMatrix4x4 operator*
 	mOut.e31 = m1.e30*m2.e01 + m1.e31*m2.e11 + m1.e32*m2.e21 + m1.e33*m2.e31;
 	mOut.e32 = m1.e30*m2.e02 + m1.e31*m2.e12 + m1.e32*m2.e22 + m1.e33*m2.e32;
 	mOut.e33 = m1.e30*m2.e03 + m1.e31*m2.e13 + m1.e32*m2.e23 + m1.e33*m2.e33;
+#endif
 
 	return mOut;
 }
@@ -3273,6 +3572,20 @@ CMatrix4x4& CMatrix4x4::MultiplyAffine( const CMatrix4x4& m )
 	}
 	else
 	{
+#ifdef GEN_SSE
+		// Multiply by the upper 3 rows, adding the final row for the position. Keep the existing
+		// right column, as in the scalar version
+		__m128 b0 = LoadRow( m, 0 );
+		__m128 b1 = LoadRow( m, 1 );
+		__m128 b2 = LoadRow( m, 2 );
+		for (TUInt32 row = 0; row < 3; ++row)
+		{
+			__m128 a = LoadRow( *this, row );
+			StoreRow( *this, row, SelectXYZ( RowMultiply3( a, b0, b1, b2 ), a ) );
+		}
+		__m128 a = LoadRow( *this, 3 );
+		StoreRow( *this, 3, SelectXYZ( _mm_add_ps( RowMultiply3( a, b0, b1, b2 ), LoadRow( m, 3 ) ), a ) );
+#else
 		TFloat32 t0, t1;
 
 		t0  = e00*m.e00 + e01*m.e10 + e02*m.e20;
@@ -3298,6 +3611,7 @@ CMatrix4x4& CMatrix4x4::MultiplyAffine( const CMatrix4x4& m )
 		e32 = e30*m.e02 + e31*m.e12 + e32*m.e22 + m.e32;
 		e30 = t0;
 		e31 = t1;
+#endif
 	}
 
 	return *this;
@@ -3312,6 +3626,19 @@ CMatrix4x4 MultiplyAffine
 {
 	CMatrix4x4 mOut;
 
+#ifdef GEN_SSE
+	// Multiply by the upper 3 rows, adding the final row for the position. Right column is set
+	// to 0 0 0 1
+	__m128 b0 = LoadRow( m2, 0 );
+	__m128 b1 = LoadRow( m2, 1 );
+	__m128 b2 = LoadRow( m2, 2 );
+	for (TUInt32 row = 0; row < 3; ++row)
+	{
+		StoreRow( mOut, row, _mm_and_ps( MaskXYZ(), RowMultiply3( LoadRow( m1, row ), b0, b1, b2 ) ) );
+	}
+	__m128 pos = _mm_add_ps( RowMultiply3( LoadRow( m1, 3 ), b0, b1, b2 ), LoadRow( m2, 3 ) );
+	StoreRow( mOut, 3, SelectXYZ( pos, _mm_set1_ps( 1.0f ) ) );
+#else
 	mOut.e00 = m1.e00*m2.e00 + m1.e01*m2.e10 + m1.e02*m2.e20;
 	mOut.e01 = m1.e00*m2.e01 + m1.e01*m2.e11 + m1.e02*m2.e21;
 	mOut.e02 = m1.e00*m2.e02 + m1.e01*m2.e12 + m1.e02*m2.e22;
@@ -3331,11 +3658,168 @@ CMatrix4x4 MultiplyAffine
 	mOut.e31 = m1.e30*m2.e01 + m1.e31*m2.e11 + m1.e32*m2.e21 + m2.e31;
 	mOut.e32 = m1.e30*m2.e02 + m1.e31*m2.e12 + m1.e32*m2.e22 + m2.e32;
 	mOut.e33 = 1.0f;
+#endif
 
 	return mOut;
 }
 
 
+/*-----------------------------------------------------------------------------------------
+	Non-Member Batch Operations
+-----------------------------------------------------------------------------------------*/
+// The SIMD versions of the point and vector transforms work on four elements at once, with the
+// x, y & z of the four in separate registers. Any remaining elements use the single versions
+
+// Transform an array of points by the given matrix, assuming it is affine
+void TransformPoints
+(
+	const CMatrix4x4& m,
+	const CVector3*   points,
+	CVector3*         results,
+	const TUInt32     numPoints
+)
+{
+	TUInt32 point = 0;
+#ifdef GEN_SSE
+	__m128 s[16];
+	SplatMatrix( m, s );
+	for (; point + 4 <= numPoints; point += 4)
+	{
+		__m128 x, y, z;
+		LoadPoints3( &points[point].x, x, y, z );
+		StorePoints3( &results[point].x, _mm_add_ps( SplatMultiply3( x, y, z, s, 0 ), s[12] ),
+		                                 _mm_add_ps( SplatMultiply3( x, y, z, s, 1 ), s[13] ),
+		                                 _mm_add_ps( SplatMultiply3( x, y, z, s, 2 ), s[14] ) );
+	}
+#endif
+	for (; point < numPoints; ++point)
+	{
+		results[point] = m.TransformPoint( points[point] );
+	}
+}
+
+// Transform an array of vectors by the given matrix, assuming it is affine and ignoring the
+// translation (i.e. transforming directions rather than points)
+void TransformVectors
+(
+	const CMatrix4x4& m,
+	const CVector3*   vectors,
+	CVector3*         results,
+	const TUInt32     numVectors
+)
+{
+	TUInt32 v = 0;
+#ifdef GEN_SSE
+	__m128 s[16];
+	SplatMatrix( m, s );
+	for (; v + 4 <= numVectors; v += 4)
+	{
+		__m128 x, y, z;
+		LoadPoints3( &vectors[v].x, x, y, z );
+		StorePoints3( &results[v].x, SplatMultiply3( x, y, z, s, 0 ),
+		                             SplatMultiply3( x, y, z, s, 1 ),
+		                             SplatMultiply3( x, y, z, s, 2 ) );
+	}
+#endif
+	for (; v < numVectors; ++v)
+	{
+		results[v] = m.TransformVector( vectors[v] );
+	}
+}
+
+// Transform an array of points by the given (general) matrix, returning 4D results with the w
+// value from the transform - e.g. for a projection matrix
+void TransformPoints
+(
+	const CMatrix4x4& m,
+	const CVector3*   points,
+	CVector4*         results,
+	const TUInt32     numPoints
+)
+{
+	TUInt32 point = 0;
+#ifdef GEN_SSE
+	__m128 s[16];
+	SplatMatrix( m, s );
+	for (; point + 4 <= numPoints; point += 4)
+	{
+		__m128 x, y, z;
+		LoadPoints3( &points[point].x, x, y, z );
+		__m128 r0 = _mm_add_ps( SplatMultiply3( x, y, z, s, 0 ), s[12] );
+		__m128 r1 = _mm_add_ps( SplatMultiply3( x, y, z, s, 1 ), s[13] );
+		__m128 r2 = _mm_add_ps( SplatMultiply3( x, y, z, s, 2 ), s[14] );
+		__m128 r3 = _mm_add_ps( SplatMultiply3( x, y, z, s, 3 ), s[15] );
+
+		// Convert back from separate x, y, z & w registers to one register per result
+		_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+		_mm_storeu_ps( &results[point].x,     r0 );
+		_mm_storeu_ps( &results[point + 1].x, r1 );
+		_mm_storeu_ps( &results[point + 2].x, r2 );
+		_mm_storeu_ps( &results[point + 3].x, r3 );
+	}
+#endif
+	for (; point < numPoints; ++point)
+	{
+		results[point] = CVector4( points[point], 1.0f ) * m;
+	}
+}
+
+// Transform an array of 4D vectors by the given matrix
+void Transform
+(
+	const CMatrix4x4& m,
+	const CVector4*   vectors,
+	CVector4*         results,
+	const TUInt32     numVectors
+)
+{
+#ifdef GEN_SSE
+	// A CVector4 fills a register, so only the matrix rows need loading outside the loop
+	__m128 r0 = LoadRow( m, 0 );
+	__m128 r1 = LoadRow( m, 1 );
+	__m128 r2 = LoadRow( m, 2 );
+	__m128 r3 = LoadRow( m, 3 );
+	for (TUInt32 v = 0; v < numVectors; ++v)
+	{
+		_mm_storeu_ps( &results[v].x, RowMultiply( _mm_loadu_ps( &vectors[v].x ), r0, r1, r2, r3 ) );
+	}
+#else
+	for (TUInt32 v = 0; v < numVectors; ++v)
+	{
+		results[v] = vectors[v] * m;
+	}
+#endif
+}
+
+// Multiply arrays of matrices pairwise: results[i] = m1[i] * m2[i]
+void MultiplyMatrices
+(
+	const CMatrix4x4* m1,
+	const CMatrix4x4* m2,
+	CMatrix4x4*       results,
+	const TUInt32     numMatrices
+)
+{
+	for (TUInt32 matrix = 0; matrix < numMatrices; ++matrix)
+	{
+#ifdef GEN_SSE
+		// Results are written directly, there is no temporary as in operator*. Each row of m1 is
+		// read before the same row of the result is written, so results may be the m1 array
+		__m128 b0 = LoadRow( m2[matrix], 0 );
+		__m128 b1 = LoadRow( m2[matrix], 1 );
+		__m128 b2 = LoadRow( m2[matrix], 2 );
+		__m128 b3 = LoadRow( m2[matrix], 3 );
+		for (TUInt32 row = 0; row < 4; ++row)
+		{
+			StoreRow( results[matrix], row, RowMultiply( LoadRow( m1[matrix], row ), b0, b1, b2, b3 ) );
+		}
+#else
+		results[matrix] = m1[matrix] * m2[matrix];
+#endif
+	}
+}
+
+
 /*---------------------------------------------------------------------------------------------
 	Static constants
 ---------------------------------------------------------------------------------------------*/
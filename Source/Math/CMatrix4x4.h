@@ -1300,6 +1300,62 @@ CMatrix4x4 MultiplyAffine
 );
 
 
+/*-----------------------------------------------------------------------------------------
+	Non-Member Batch Operations
+-----------------------------------------------------------------------------------------*/
+// Apply the same operation to arrays of points, vectors or matrices. Equivalent to looping
+// over the single versions but faster for large arrays - the SIMD versions work on several
+// elements at once. Results may be written over the inputs (same array), but the arrays must
+// not otherwise overlap
+
+// Transform an array of points by the given matrix, assuming it is affine
+void TransformPoints
+(
+	const CMatrix4x4& m,
+	const CVector3*   points,
+	CVector3*         results,
+	const TUInt32     numPoints
+);
+
+// Transform an array of vectors by the given matrix, assuming it is affine and ignoring the
+// translation (i.e. transforming directions rather than points)
+void TransformVectors
+(
+	const CMatrix4x4& m,
+	const CVector3*   vectors,
+	CVector3*         results,
+	const TUInt32     numVectors
+);
+
+// Transform an array of points by the given (general) matrix, returning 4D results with the w
+// value from the transform - e.g. for a projection matrix
+void TransformPoints
+(
+	const CMatrix4x4& m,
+	const CVector3*   points,
+	CVector4*         results,
+	const TUInt32     numPoints
+);
+
+// Transform an array of 4D vectors by the given matrix
+void Transform
+(
+	const CMatrix4x4& m,
+	const CVector4*   vectors,
+	CVector4*         results,
+	const TUInt32     numVectors
+);
+
+// Multiply arrays of matrices pairwise: results[i] = m1[i] * m2[i]
+void MultiplyMatrices
+(
+	const CMatrix4x4* m1,
+	const CMatrix4x4* m2,
+	CMatrix4x4*       results,
+	const TUInt32     numMatrices
+);
+
+
 /*-----------------------------------------------------------------------------------------
 	Non-Member Othogonality
 -----------------------------------------------------------------------------------------*/
@@ -0,0 +1,137 @@
+/**************************************************************************************************
+	Module:       CRandom.cpp
+
+	Seedable random number generator (xoshiro128**) with independent streams, to replace the
+	global rand() where results must be repeatable
+**************************************************************************************************/
+
+#include "MathSIMD.h"
+#include "CRandom.h"
+
+namespace gen
+{
+
+/*-----------------------------------------------------------------------------------------
+	Support functions
+-----------------------------------------------------------------------------------------*/
+
+// Step a splitmix64 generator and return its next value. Used to spread a seed across the
+// generator state, as xoshiro generators give poor results from similar or mostly zero states
+static TUInt64 SplitMix64( TUInt64& state )
+{
+	TUInt64 z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+
+// Restart the generator with the given seed and stream
+void CRandom::Seed( TUInt64 seed, TUInt64 stream /*= 0*/ )
+{
+	// Mix the stream into the seed first, so neighbouring streams (e.g. consecutive UIDs) start
+	// far apart in the splitmix sequence
+	TUInt64 mix = stream;
+	TUInt64 state = seed ^ SplitMix64( mix );
+	TUInt64 low = SplitMix64( state );
+	TUInt64 high = SplitMix64( state );
+	m_State[0] = static_cast<TUInt32>(low);
+	m_State[1] = static_cast<TUInt32>(low >> 32);
+	m_State[2] = static_cast<TUInt32>(high);
+	m_State[3] = static_cast<TUInt32>(high >> 32);
+	if ((m_State[0] | m_State[1] | m_State[2] | m_State[3]) == 0)
+	{
+		m_State[0] = 1;
+	}
+}
+
+// Fill an array with random 32-bit floats from a to b (excluding b). Generates four numbers at
+// once with SIMD code where available - use for bulk generation such as scattering many
+// entities. The results are the same with or without SIMD, but differ from calling the single
+// value function repeatedly
+void CRandom::Random( const TFloat32 a, const TFloat32 b, TFloat32* values, TUInt32 numValues )
+{
+	// Run four generators side by side, each seeded from this one. Stored as four state words
+	// for each lane, so each word of the four lanes is a single SSE register
+	TUInt32 lanes[4][4];
+	for (TUInt32 lane = 0; lane < 4; ++lane)
+	{
+		TUInt64 state = (static_cast<TUInt64>(Next()) << 32) | Next();
+		TUInt64 low = SplitMix64( state );
+		TUInt64 high = SplitMix64( state );
+		lanes[0][lane] = static_cast<TUInt32>(low) | 1; // Ensure state is not all zero
+		lanes[1][lane] = static_cast<TUInt32>(low >> 32);
+		lanes[2][lane] = static_cast<TUInt32>(high);
+		lanes[3][lane] = static_cast<TUInt32>(high >> 32);
+	}
+	TFloat32 range = b - a;
+	TFloat32 remainder[4];
+
+#ifdef GEN_SSE
+	__m128i s0 = _mm_loadu_si128( reinterpret_cast<__m128i*>(lanes[0]) );
+	__m128i s1 = _mm_loadu_si128( reinterpret_cast<__m128i*>(lanes[1]) );
+	__m128i s2 = _mm_loadu_si128( reinterpret_cast<__m128i*>(lanes[2]) );
+	__m128i s3 = _mm_loadu_si128( reinterpret_cast<__m128i*>(lanes[3]) );
+	__m128 scale = _mm_set1_ps( range * (1.0f / 16777216.0f) );
+	__m128 offset = _mm_set1_ps( a );
+	for (TUInt32 value = 0; value < numValues; value += 4)
+	{
+		// Same steps as Next, multiplications by 5 and 9 are done with shifts and adds as SSE2 has
+		// no 32-bit multiply
+		__m128i x = _mm_add_epi32( _mm_slli_epi32( s1, 2 ), s1 );
+		x = _mm_or_si128( _mm_slli_epi32( x, 7 ), _mm_srli_epi32( x, 25 ) );
+		__m128i result = _mm_add_epi32( _mm_slli_epi32( x, 3 ), x );
+		__m128i t = _mm_slli_epi32( s1, 9 );
+		s2 = _mm_xor_si128( s2, s0 );
+		s3 = _mm_xor_si128( s3, s1 );
+		s1 = _mm_xor_si128( s1, s2 );
+		s0 = _mm_xor_si128( s0, s3 );
+		s2 = _mm_xor_si128( s2, t );
+		s3 = _mm_or_si128( _mm_slli_epi32( s3, 11 ), _mm_srli_epi32( s3, 21 ) );
+
+		// Top 24 bits to float (fits in a signed int), then scale to the range
+		__m128 unit = _mm_cvtepi32_ps( _mm_srli_epi32( result, 8 ) );
+		__m128 floats = _mm_add_ps( _mm_mul_ps( unit, scale ), offset );
+		if (numValues - value >= 4)
+		{
+			_mm_storeu_ps( values + value, floats );
+		}
+		else
+		{
+			_mm_storeu_ps( remainder, floats );
+			for (TUInt32 lane = 0; value + lane < numValues; ++lane)
+			{
+				values[value + lane] = remainder[lane];
+			}
+		}
+	}
+#else
+	TFloat32 scale = range * (1.0f / 16777216.0f);
+	for (TUInt32 value = 0; value < numValues; value += 4)
+	{
+		for (TUInt32 lane = 0; lane < 4; ++lane)
+		{
+			TUInt32 result = RotateLeft( lanes[1][lane] * 5, 7 ) * 9;
+			TUInt32 t = lanes[1][lane] << 9;
+			lanes[2][lane] ^= lanes[0][lane];
+			lanes[3][lane] ^= lanes[1][lane];
+			lanes[1][lane] ^= lanes[2][lane];
+			lanes[0][lane] ^= lanes[3][lane];
+			lanes[2][lane] ^= t;
+			lanes[3][lane] = RotateLeft( lanes[3][lane], 11 );
+			remainder[lane] = static_cast<TFloat32>(result >> 8) * scale + a;
+		}
+		for (TUInt32 lane = 0; lane < 4 && value + lane < numValues; ++lane)
+		{
+			values[value + lane] = remainder[lane];
+		}
+	}
+#endif
+}
+
+
+} // namespace gen
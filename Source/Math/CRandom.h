@@ -0,0 +1,109 @@
+/**************************************************************************************************
+	Module:       CRandom.h
+
+	Seedable random number generator (xoshiro128**) with independent streams, to replace the
+	global rand() where results must be repeatable
+**************************************************************************************************/
+
+#ifndef GEN_C_RANDOM_H_INCLUDED
+#define GEN_C_RANDOM_H_INCLUDED
+
+#include "Defines.h"
+
+namespace gen
+{
+
+// A random number generator with its own state, so separate systems or entities can each have a
+// generator and draw numbers without sharing hidden global state (unlike rand()). A generator is
+// seeded with a seed value and a stream number - generators with the same seed and different
+// streams give unrelated sequences, so a whole simulation can be repeated from one seed, e.g:
+//     CRandom random( seed, entityUID );
+// The same seed and stream always give the same sequence on every platform and build
+class CRandom
+{
+/*-----------------------------------------------------------------------------------------
+	Constructors/Destructors
+-----------------------------------------------------------------------------------------*/
+public:
+	// Default constructor - seed 0, stream 0
+	CRandom()
+	{
+		Seed( 0 );
+	}
+
+	// Construct with the given seed and stream
+	CRandom( TUInt64 seed, TUInt64 stream = 0 )
+	{
+		Seed( seed, stream );
+	}
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+public:
+
+	// Restart the generator with the given seed and stream
+	void Seed( TUInt64 seed, TUInt64 stream = 0 );
+
+	// Return the next 32 random bits
+	TUInt32 Next()
+	{
+		TUInt32 result = RotateLeft( m_State[1] * 5, 7 ) * 9;
+		TUInt32 t = m_State[1] << 9;
+		m_State[2] ^= m_State[0];
+		m_State[3] ^= m_State[1];
+		m_State[1] ^= m_State[2];
+		m_State[0] ^= m_State[3];
+		m_State[2] ^= t;
+		m_State[3] = RotateLeft( m_State[3], 11 );
+		return result;
+	}
+
+	// Return random integer from a to b (inclusive)
+	TInt32 Random( const TInt32 a, const TInt32 b )
+	{
+		// Scale the 32 random bits to the range with 64-bit maths
+		TUInt64 range = static_cast<TUInt64>(static_cast<TInt64>(b) - a + 1);
+		return a + static_cast<TInt32>((Next() * range) >> 32);
+	}
+
+	// Return random 32-bit float from a to b (excluding b)
+	TFloat32 Random( const TFloat32 a, const TFloat32 b )
+	{
+		return a + (b - a) * ToUnitFloat( Next() );
+	}
+
+	// Fill an array with random 32-bit floats from a to b (excluding b). Generates four numbers
+	// at once with SIMD code where available - use for bulk generation such as scattering many
+	// entities. The results are the same with or without SIMD, but differ from calling the
+	// single value function repeatedly
+	void Random( const TFloat32 a, const TFloat32 b, TFloat32* values, TUInt32 numValues );
+
+
+/*-----------------------------------------------------------------------------------------
+	Private interface
+-----------------------------------------------------------------------------------------*/
+private:
+
+	// Rotate the bits of a 32-bit value left by the given amount (1-31)
+	static TUInt32 RotateLeft( TUInt32 x, TUInt32 shift )
+	{
+		return (x << shift) | (x >> (32 - shift));
+	}
+
+	// Convert 32 random bits to a float from 0 to 1 (excluding 1), using the top 24 bits - all
+	// a 32-bit float can hold
+	static TFloat32 ToUnitFloat( TUInt32 bits )
+	{
+		return static_cast<TFloat32>(bits >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// Generator state, never all zero
+	TUInt32 m_State[4];
+};
+
+
+} // namespace gen
+
+#endif // GEN_C_RANDOM_H_INCLUDED
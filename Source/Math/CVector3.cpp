@@ -14,10 +14,31 @@
 
 #include "CVector3.h"
 #include "CVector4.h"
+#include "MathSIMD.h"
 
 namespace gen
 {
 
+#ifdef GEN_SSE
+/*-----------------------------------------------------------------------------------------
+	SIMD Support
+-----------------------------------------------------------------------------------------*/
+// See MathSIMD.h for the selection of these code paths
+
+// Return the minimum/maximum of the four elements of a register in the first element
+static inline __m128 HorizontalMin( const __m128 v )
+{
+	__m128 t = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_min_ps( t, _mm_shuffle_ps( t, t, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+}
+static inline __m128 HorizontalMax( const __m128 v )
+{
+	__m128 t = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_max_ps( t, _mm_shuffle_ps( t, t, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+}
+#endif // GEN_SSE
+
+
 /*-----------------------------------------------------------------------------------------
 	Constructors/Destructors
 -----------------------------------------------------------------------------------------*/
@@ -127,6 +148,85 @@ TFloat32 DistanceSquared
 	return distX*distX + distY*distY + distZ*distZ;
 }
 
+// Expand the given bounding box to contain an array of points, and increase the given maximum
+// length to the greatest distance of any of the points from the origin. The points are found
+// every "stride" bytes from the given address, so can be the positions in an array of vertices
+void ExpandBounds
+(
+	const void*   points,
+	const TUInt32 stride,
+	const TUInt32 numPoints,
+	CVector3*     minBounds,
+	CVector3*     maxBounds,
+	TFloat32*     maxLength
+)
+{
+	const TUInt8* pPoint = static_cast<const TUInt8*>(points);
+	TFloat32 maxLengthSq = *maxLength * *maxLength;
+	TUInt32 point = 0;
+
+#ifdef GEN_SSE
+	// Work on four points at once. Each point is loaded as four floats then transposed so the
+	// registers hold the x, y & z of all four points. The load reads past the end of a point, so
+	// stop when the final load would read past the end of the array
+	__m128 minX = _mm_set1_ps( minBounds->x );
+	__m128 minY = _mm_set1_ps( minBounds->y );
+	__m128 minZ = _mm_set1_ps( minBounds->z );
+	__m128 maxX = _mm_set1_ps( maxBounds->x );
+	__m128 maxY = _mm_set1_ps( maxBounds->y );
+	__m128 maxZ = _mm_set1_ps( maxBounds->z );
+	__m128 maxLenSq = _mm_set1_ps( maxLengthSq );
+	for (; point + 4 <= numPoints && (point + 3) * stride + 16 <= numPoints * stride; point += 4)
+	{
+		__m128 x = _mm_loadu_ps( reinterpret_cast<const TFloat32*>(pPoint) );
+		__m128 y = _mm_loadu_ps( reinterpret_cast<const TFloat32*>(pPoint + stride) );
+		__m128 z = _mm_loadu_ps( reinterpret_cast<const TFloat32*>(pPoint + 2 * stride) );
+		__m128 w = _mm_loadu_ps( reinterpret_cast<const TFloat32*>(pPoint + 3 * stride) );
+		_MM_TRANSPOSE4_PS( x, y, z, w );
+
+		minX = _mm_min_ps( minX, x );
+		minY = _mm_min_ps( minY, y );
+		minZ = _mm_min_ps( minZ, z );
+		maxX = _mm_max_ps( maxX, x );
+		maxY = _mm_max_ps( maxY, y );
+		maxZ = _mm_max_ps( maxZ, z );
+		__m128 lenSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+		maxLenSq = _mm_max_ps( maxLenSq, lenSq );
+
+		pPoint += 4 * stride;
+	}
+
+	// Combine the four lanes of each register
+	minBounds->x = _mm_cvtss_f32( HorizontalMin( minX ) );
+	minBounds->y = _mm_cvtss_f32( HorizontalMin( minY ) );
+	minBounds->z = _mm_cvtss_f32( HorizontalMin( minZ ) );
+	maxBounds->x = _mm_cvtss_f32( HorizontalMax( maxX ) );
+	maxBounds->y = _mm_cvtss_f32( HorizontalMax( maxY ) );
+	maxBounds->z = _mm_cvtss_f32( HorizontalMax( maxZ ) );
+	maxLengthSq = _mm_cvtss_f32( HorizontalMax( maxLenSq ) );
+#endif
+
+	for (; point < numPoints; ++point)
+	{
+		CVector3 p( reinterpret_cast<const TFloat32*>(pPoint) );
+		minBounds->x = Min( minBounds->x, p.x );
+		minBounds->y = Min( minBounds->y, p.y );
+		minBounds->z = Min( minBounds->z, p.z );
+		maxBounds->x = Max( maxBounds->x, p.x );
+		maxBounds->y = Max( maxBounds->y, p.y );
+		maxBounds->z = Max( maxBounds->z, p.z );
+		maxLengthSq = Max( maxLengthSq, p.LengthSquared() );
+
+		pPoint += stride;
+	}
+
+	// Only take the square root if the length increased, so an unchanged length is exact
+	if (maxLengthSq > *maxLength * *maxLength)
+	{
+		*maxLength = Sqrt( maxLengthSq );
+	}
+}
+
 
 /*---------------------------------------------------------------------------------------------
 	Static constants
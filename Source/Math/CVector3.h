@@ -507,6 +507,19 @@ TFloat32 DistanceSquared
 	const CVector3& p2
 );
 
+// Expand the given bounding box to contain an array of points, and increase the given maximum
+// length to the greatest distance of any of the points from the origin. The points are found
+// every "stride" bytes from the given address, so can be the positions in an array of vertices
+void ExpandBounds
+(
+	const void*   points,
+	const TUInt32 stride,
+	const TUInt32 numPoints,
+	CVector3*     minBounds,
+	CVector3*     maxBounds,
+	TFloat32*     maxLength
+);
+
 
 } // namespace gen
 
@@ -0,0 +1,33 @@
+/**************************************************************************************************
+	Module:       MathSIMD.h
+
+	Compile-time selection of SIMD (SSE/AVX) code paths for the math classes
+**************************************************************************************************/
+
+// Some math operations have SIMD versions that work on four (SSE) or eight (AVX) floats at once.
+// The versions used are chosen at compile time from the instruction sets the compiler targets:
+// - GEN_SSE is defined if SSE2 is available - always for x64 builds, or x86 builds using
+//   /arch:SSE2 (Microsoft) or -msse2 (GCC)
+// - GEN_AVX is also defined if AVX is available - builds using /arch:AVX or -mavx
+// Otherwise the original scalar code is used. Define GEN_NO_SIMD to force the scalar code, e.g.
+// to compare results
+//
+// The math classes are not aligned, so SIMD code uses unaligned loads and stores throughout.
+// The rows of a CMatrix4x4 are contiguous so each row can be loaded as a single SSE register
+
+#ifndef GEN_MATH_SIMD_H_INCLUDED
+#define GEN_MATH_SIMD_H_INCLUDED
+
+#if !defined(GEN_NO_SIMD)
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define GEN_SSE
+		#include <emmintrin.h>
+
+		#if defined(__AVX__)
+			#define GEN_AVX
+			#include <immintrin.h>
+		#endif
+	#endif
+#endif
+
+#endif // GEN_MATH_SIMD_H_INCLUDED
@@ -15,11 +15,13 @@
 #include <numeric>
 using namespace std;
 
+#ifndef GEN_HEADLESS
 #define INITGUID
 #include <windows.h>
 #include <dxfile.h>
 #include <rmxfguid.h>
 #include <rmxftmpl.h>
+#endif
 
 #include "Error.h"
 #include "CImportXFile.h"
@@ -65,10 +67,12 @@ bool CImportXFile::IsXFile
 }
 
 	
-// Import a Microsoft X-File into a list of meshes and a frame hierarchy
+// Import a Microsoft X-File into a list of meshes and a frame hierarchy. Text X-Files are
+// parsed directly, binary and compressed X-Files use the X-File API, so they cannot be
+// imported in headless builds (GEN_HEADLESS)
 // Possible return values:
 //		kSuccess:			...
-//		kFileError:			Missing file or not an X-file
+//		kFileError:			Missing file or not an X-file (or not a text X-file if headless)
 //		kInvalidData:		The file could not be parsed correctly, or contains invalid data
 //		kOutOfSystemMemory:	...
 //		kSystemFailure:		X-file API failure
@@ -90,29 +94,42 @@ EImportError CImportXFile::ImportFile
 		return kFileError;
 	}
 
-	// Create X-File object
-	ID3DXFile* pXFile;
-	EImportError eError = PrepareXFileObject( &pXFile );
-	if (eError != kSuccess)
+	// Parse X file to create frame hierachy and meshes
+	EImportError eError;
+	if (IsTextXFile( sFileName ))
 	{
-		return eError;
+		eError = ParseTextXFile( sFileName );
 	}
-
-	// Get X-File enumerator
-	ID3DXFileEnumObject* pXFileEnumer;
-	eError = GetXFileEnumerator( sFileName, pXFile, &pXFileEnumer );
-	if (eError != kSuccess)
+	else
 	{
-		pXFile->Release();
-		return eError;
-	}
+#ifndef GEN_HEADLESS
+		// Create X-File object
+		ID3DXFile* pXFile;
+		eError = PrepareXFileObject( &pXFile );
+		if (eError != kSuccess)
+		{
+			return eError;
+		}
 
-	// Parse X file to create frame hierachy and meshes
-	eError = ParseXFile( pXFileEnumer );
+		// Get X-File enumerator
+		ID3DXFileEnumObject* pXFileEnumer;
+		eError = GetXFileEnumerator( sFileName, pXFile, &pXFileEnumer );
+		if (eError != kSuccess)
+		{
+			pXFile->Release();
+			return eError;
+		}
 
-	// Release X-File interfaces
-	pXFileEnumer->Release();
-	pXFile->Release();
+		eError = ParseXFile( pXFileEnumer );
+
+		// Release X-File interfaces
+		pXFileEnumer->Release();
+		pXFile->Release();
+#else
+		// No X-File API
+		return kFileError;
+#endif
+	}
 
 	// Check for errors
 	if (eError != kSuccess)
@@ -399,6 +416,8 @@ void CImportXFile::GetMaterial
 }
 
 
+#ifndef GEN_HEADLESS
+
 /*-----------------------------------------------------------------------------------------
 	X-File API support
 -----------------------------------------------------------------------------------------*/
@@ -1706,6 +1725,8 @@ void CImportXFile::ReadXFileLockedUInt16
 	GEN_ENDGUARD;
 }
 
+#endif // GEN_HEADLESS
+
 
 /*-----------------------------------------------------------------------------------------
 	X-file type support
@@ -1751,10 +1772,11 @@ void CImportXFile::MatchFaceLists
 
 	if (!mesh.normals.empty())
 	{
-		// Maximum vertices (and normals) possible is the total number of indices in the original
-		// face lists (if each index was different). Use std library accumulate from <numeric>
-		TUInt32 iMaxVertices = accumulate( mesh.origFaceEdges.begin(), 
-		                                   mesh.origFaceEdges.end(), 0 );
+		// Maximum vertices (and normals) possible is the original vertices plus the total number
+		// of indices in the original face lists (if each index needed a new copy of its vertex).
+		// Use std library accumulate from <numeric>
+		TUInt32 iMaxVertices = static_cast<TUInt32>(mesh.vertices.size()) +
+		                       accumulate( mesh.origFaceEdges.begin(), mesh.origFaceEdges.end(), 0 );
 
 		// Create empty vertex and normal maps - use max vertex value as unused marker
 		TXFileInts vertexMap( iMaxVertices, iMaxVertices );
@@ -1844,7 +1866,9 @@ void CImportXFile::MatchFaceLists
 		TXFileVectors newNormals( iNewNumVertices );
 		for (TUInt32 iNormal = 0; iNormal < iNewNumVertices; ++iNormal)
 		{
-			newNormals[iNormal] = mesh.normals[normalMap[iNormal]];
+			// Vertices not used by any face have no normal
+			newNormals[iNormal] = (normalMap[iNormal] != iMaxVertices) ? mesh.normals[normalMap[iNormal]] :
+			                                                              CVector3::kZero;
 		}
 		mesh.normals.swap( newNormals );
 	}
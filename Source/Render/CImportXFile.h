@@ -16,8 +16,10 @@
 
 #include <vector>
 using namespace std;
+#ifndef GEN_HEADLESS
 #include <d3d9.h>
 #include <d3dx9.h>
+#endif
 
 #include "CVector3.h"
 #include "CMatrix4x4.h"
@@ -71,10 +73,12 @@ public:
 		return m_bImported;
 	}
 
-	// Import a Microsoft X-File into a list of meshes and a frame hierarchy
+	// Import a Microsoft X-File into a list of meshes and a frame hierarchy. Text X-Files are
+	// parsed directly, binary and compressed X-Files use the X-File API, so they cannot be
+	// imported in headless builds (GEN_HEADLESS)
 	// Possible return values:
 	//		kSuccess:			...
-	//		kFileError:			Missing file or not an X-file
+	//		kFileError:			Missing file or not an X-file (or not a text X-file if headless)
 	//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
 	//		kOutOfSystemMemory:	...
 	//		kSystemFailure:		X-file API failure
@@ -115,7 +119,7 @@ public:
 	// Possible return values:
 	//		kSuccess:			...
 	//		kOutOfSystemMemory:	...
-	EImportError CImportXFile::GetSubMesh
+	EImportError GetSubMesh
 	(
 		const TUInt32 iSubMesh,
 		SSubMesh*     pSubMesh,
@@ -327,6 +331,8 @@ private:
 	typedef vector<SXFileMesh> TXFileMeshes;
 
 
+#ifndef GEN_HEADLESS
+
 	/////////////////////////////////////
 	// X-File API support
 
@@ -532,6 +538,77 @@ private:
 		TUInt16*       piDest
 	);
 
+#endif // GEN_HEADLESS
+
+
+	/////////////////////////////////////
+	// Text X-File parsing (CImportXFileText.cpp)
+
+	// Parsing state for a text X-File - the tokenizer and the named top-level materials
+	struct SXFileTextState;
+
+	// Tests if supplied filename is a text format X-File (rather than binary or compressed)
+	static bool IsTextXFile
+	(
+		const string& sXName
+	);
+
+	// Parse a text X-File without the X-File API. Creates the same root frame, frame hierarchy
+	// and meshes as ParseXFile
+	// Possible return values:
+	//		kSuccess:			...
+	//		kFileError:			Missing file
+	//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
+	EImportError ParseTextXFile
+	(
+		const string& sXName
+	);
+
+	// Read the header of the next data object in a text X-File: its template name, optional
+	// name and open brace. A reference to another data object ("{ name }") is returned with an
+	// empty template name. Returns false if the text is invalid
+	bool ReadTextObjectHeader
+	(
+		SXFileTextState& state,
+		string*          psTemplate,
+		string*          psName
+	);
+
+	// Create a new frame and parse its contents (frames, meshes and transform) from a text X-File
+	EImportError ParseTextFrame
+	(
+		SXFileTextState& state,
+		const string&    sName,
+		const TUInt32    iParentFrame
+	);
+
+	// Create a new mesh in the given frame and parse its contents from a text X-File
+	EImportError ParseTextMesh
+	(
+		SXFileTextState& state,
+		const TUInt32    iCurrFrame
+	);
+
+	// Read a normal data, texture coordinate, vertex colour, material list, vertex duplication,
+	// adjacency, skinning header or skinning weights object (including its close brace) from a
+	// text X-File, with the same validation as the matching Read...Data functions above
+	EImportError ReadTextNormalData( SXFileTextState& state, const TUInt32 iMesh );
+	EImportError ReadTextTextureUVData( SXFileTextState& state, const TUInt32 iMesh );
+	EImportError ReadTextVertexColourData( SXFileTextState& state, const TUInt32 iMesh );
+	EImportError ReadTextMaterialData( SXFileTextState& state, const TUInt32 iMesh );
+	EImportError ReadTextDuplicationData( SXFileTextState& state, const TUInt32 iMesh );
+	EImportError ReadTextAdjacencyData( SXFileTextState& state, const TUInt32 iMesh );
+	EImportError ReadTextSkinDefnData( SXFileTextState& state, const TUInt32 iMesh );
+	EImportError ReadTextSkinWeightsData( SXFileTextState& state, const TUInt32 iMesh,
+	                                      const TUInt32 iBone );
+
+	// Read a material object (including its close brace) from a text X-File
+	EImportError ReadTextMaterial
+	(
+		SXFileTextState& state,
+		SXFileMaterial*  pMaterial
+	);
+
 
 	/////////////////////////////////////
 	// Geometry processing
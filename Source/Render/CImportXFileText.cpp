@@ -0,0 +1,962 @@
+/**************************************************************************************************
+	Module:       CImportXFileText.cpp
+
+	Text X-File parsing for CImportXFile - imports text format .X files directly from a memory
+	mapped file, without the DirectX X-File API. Produces exactly the same frames and meshes as
+	parsing with the X-File API, the geometry processing that follows is shared
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+using namespace std;
+
+#include "Error.h"
+#include "CXFileTokenizer.h"
+#include "CImportXFile.h"
+
+namespace gen
+{
+
+/*-----------------------------------------------------------------------------------------
+	Text X-File types
+-----------------------------------------------------------------------------------------*/
+
+// Size of the header at the start of an X-File, e.g. "xof 0303txt 0032"
+const TUInt32 kiXFileHeaderSize = 16;
+
+// Parsing state for a text X-File
+struct CImportXFile::SXFileTextState
+{
+	SXFileTextState( const char* pText, const char* pTextEnd ) : tokens( pText, pTextEnd ) {}
+
+	// Tokenizer reading the mapped file
+	CXFileTokenizer tokens;
+
+	// Materials declared at the top level of the file, by name. Mesh material lists may refer to
+	// these rather than containing their own materials
+	map<string, SXFileMaterial> namedMaterials;
+
+	// Material list entries that refer to named materials. Resolved when the whole file has been
+	// read, as a reference may come before the material it names
+	struct SMaterialReference
+	{
+		TUInt32 iMesh;
+		TUInt32 iMaterial;
+		string  sName;
+	};
+	vector<SMaterialReference> materialReferences;
+};
+
+
+/*-----------------------------------------------------------------------------------------
+	Text X-File parsing
+-----------------------------------------------------------------------------------------*/
+
+// Tests if supplied filename is a text format X-File (rather than binary or compressed)
+bool CImportXFile::IsTextXFile
+(
+	const string& sFileName
+)
+{
+	GEN_GUARD;
+
+	FILE* pFile = fopen( sFileName.c_str(), "rb" );
+	if (!pFile)
+	{
+		return false;
+	}
+
+	char acHeader[kiXFileHeaderSize];
+	bool bTextXFile = (fread( acHeader, 1, kiXFileHeaderSize, pFile ) == kiXFileHeaderSize &&
+	                   memcmp( acHeader, "xof ", 4 ) == 0 && memcmp( acHeader + 8, "txt ", 4 ) == 0);
+	fclose( pFile );
+
+	return bTextXFile;
+
+	GEN_ENDGUARD;
+}
+
+
+// Parse a text X-File without the X-File API. Creates the same root frame, frame hierarchy
+// and meshes as ParseXFile
+// Possible return values:
+//		kSuccess:			...
+//		kFileError:			Missing file
+//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
+EImportError CImportXFile::ParseTextXFile
+(
+	const string& sFileName
+)
+{
+	GEN_GUARD;
+
+	// Map the file, the text is read in place
+	TUInt32 iFileSize;
+	const char* pFileData = static_cast<const char*>(MapFile( sFileName, &iFileSize ));
+	if (!pFileData)
+	{
+		return kFileError;
+	}
+	if (iFileSize < kiXFileHeaderSize)
+	{
+		UnmapFile( pFileData, iFileSize );
+		return kInvalidData;
+	}
+	SXFileTextState state( pFileData + kiXFileHeaderSize, pFileData + iFileSize );
+
+	// Create new root frame
+	m_Frames.push_back( SXFileFrame() );
+
+	// Set root frame values
+	m_Frames[0].sName = "Root";
+	m_Frames[0].iDepth = 0;
+	m_Frames[0].iParentIndex = 0;
+	m_Frames[0].iNumChildren = 0;
+	m_Frames[0].defaultMatrix = CMatrix4x4::kIdentity;
+	m_Frames[0].offsetMatrix = CMatrix4x4::kIdentity;
+
+	// For each top level object
+	EImportError eError = kSuccess;
+	while (eError == kSuccess && state.tokens.PeekToken() != CXFileTokenizer::Token_End)
+	{
+		string sTemplate, sName;
+		if (!ReadTextObjectHeader( state, &sTemplate, &sName ))
+		{
+			eError = kInvalidData;
+		}
+
+		// Found child frame
+		else if (sTemplate == "Frame")
+		{
+			++m_Frames[0].iNumChildren;
+			eError = ParseTextFrame( state, sName, 0 );
+		}
+
+		// Found child frame transformation matrix
+		else if (sTemplate == "FrameTransformMatrix")
+		{
+			if (!state.tokens.ReadFloats( &m_Frames[0].defaultMatrix.e00, 16 ) ||
+			    !state.tokens.ReadChar( '}' ))
+			{
+				eError = kInvalidData;
+			}
+		}
+
+		// Found child mesh
+		else if (sTemplate == "Mesh")
+		{
+			eError = ParseTextMesh( state, 0 );
+		}
+
+		// Found named material - only used through references in mesh material lists
+		else if (sTemplate == "Material")
+		{
+			SXFileMaterial material;
+			eError = ReadTextMaterial( state, &material );
+			material.sName = sName;
+			state.namedMaterials[sName] = material;
+		}
+
+		// Templates, header and unknown objects are ignored
+		else if (sTemplate != "" && !state.tokens.SkipBlock())
+		{
+			eError = kInvalidData;
+		}
+	}
+
+	// All data has been copied out of the file
+	UnmapFile( pFileData, iFileSize );
+	if (eError != kSuccess)
+	{
+		return eError;
+	}
+
+	// Resolve references to named materials
+	for (TUInt32 iRef = 0; iRef < state.materialReferences.size(); ++iRef)
+	{
+		const SXFileTextState::SMaterialReference& reference = state.materialReferences[iRef];
+		map<string, SXFileMaterial>::const_iterator material =
+			state.namedMaterials.find( reference.sName );
+		if (material == state.namedMaterials.end())
+		{
+			return kInvalidData;
+		}
+		m_Meshes[reference.iMesh].materials[reference.iMaterial] = material->second;
+	}
+
+	// Make a single global material list for all meshes
+	MakeGlobalMaterialList();
+
+	// Validate bones and match them to their frames
+	return ProcessBones();
+
+	GEN_ENDGUARD;
+}
+
+
+// Read the header of the next data object in a text X-File: its template name, optional
+// name and open brace. A reference to another data object ("{ name }") is returned with an
+// empty template name. Returns false if the text is invalid
+bool CImportXFile::ReadTextObjectHeader
+(
+	SXFileTextState& state,
+	string*          psTemplate,
+	string*          psName
+)
+{
+	GEN_GUARD;
+
+	psTemplate->clear();
+	psName->clear();
+
+	// Reference - a name and/or GUID in braces, only references by name are supported
+	if (state.tokens.ReadChar( '{' ))
+	{
+		state.tokens.ReadName( psName );
+		state.tokens.SkipGUID();
+		return state.tokens.ReadChar( '}' ) && !psName->empty();
+	}
+
+	// Data object - template name, optional name and GUID
+	if (!state.tokens.ReadName( psTemplate ))
+	{
+		return false;
+	}
+	state.tokens.ReadName( psName );
+	state.tokens.SkipGUID();
+	return state.tokens.ReadChar( '{' );
+
+	GEN_ENDGUARD;
+}
+
+
+// Create a new frame and parse its contents (frames, meshes and transform) from a text X-File
+EImportError CImportXFile::ParseTextFrame
+(
+	SXFileTextState& state,
+	const string&    sName,
+	const TUInt32    iParentFrame
+)
+{
+	GEN_GUARD;
+
+	// Create new frame
+	TUInt32 iCurrFrame = static_cast<TUInt32>(m_Frames.size());
+	m_Frames.push_back( SXFileFrame() );
+
+	// Initialise frame values
+	m_Frames[iCurrFrame].sName = sName;
+	m_Frames[iCurrFrame].iDepth = m_Frames[iParentFrame].iDepth + 1;
+	m_Frames[iCurrFrame].iParentIndex = iParentFrame;
+	m_Frames[iCurrFrame].iNumChildren = 0;
+	m_Frames[iCurrFrame].defaultMatrix = CMatrix4x4::kIdentity;
+	m_Frames[iCurrFrame].offsetMatrix = CMatrix4x4::kIdentity;
+
+	// For each child object
+	while (!state.tokens.ReadChar( '}' ))
+	{
+		string sTemplate, sChildName;
+		if (!ReadTextObjectHeader( state, &sTemplate, &sChildName ))
+		{
+			return kInvalidData;
+		}
+
+		// Found child frame
+		EImportError eError = kSuccess;
+		if (sTemplate == "Frame")
+		{
+			++m_Frames[iCurrFrame].iNumChildren;
+			eError = ParseTextFrame( state, sChildName, iCurrFrame );
+		}
+
+		// Found child frame transformation matrix
+		else if (sTemplate == "FrameTransformMatrix")
+		{
+			if (!state.tokens.ReadFloats( &m_Frames[iCurrFrame].defaultMatrix.e00, 16 ) ||
+			    !state.tokens.ReadChar( '}' ))
+			{
+				eError = kInvalidData;
+			}
+		}
+
+		// Found child mesh
+		else if (sTemplate == "Mesh")
+		{
+			eError = ParseTextMesh( state, iCurrFrame );
+		}
+
+		// References and unknown objects are ignored
+		else if (sTemplate != "" && !state.tokens.SkipBlock())
+		{
+			eError = kInvalidData;
+		}
+
+		// Return any errors found
+		if (eError != kSuccess)
+		{
+			return eError;
+		}
+	}
+
+	return kSuccess;
+
+	GEN_ENDGUARD;
+}
+
+
+// Create a new mesh in the given frame and parse its contents from a text X-File
+EImportError CImportXFile::ParseTextMesh
+(
+	SXFileTextState& state,
+	const TUInt32    iCurrFrame
+)
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+
+	// Create new mesh
+	TUInt32 iCurrMesh = static_cast<TUInt32>(m_Meshes.size());
+	m_Meshes.push_back( SXFileMesh() );
+	SXFileMesh& mesh = m_Meshes[iCurrMesh];
+
+	// Set owner frame
+	mesh.iParentFrame = iCurrFrame;
+	mesh.iNumUniqueVertices = 0;
+	mesh.iMaxBonesPerVertex = 0;
+	mesh.iMaxBonesPerFace = 0;
+
+	// Read vertices
+	TUInt32 iNumVertices;
+	if (!tokens.ReadUInt( &iNumVertices ) || !tokens.HasValues( 3ull * iNumVertices ))
+	{
+		return kInvalidData;
+	}
+	mesh.vertices.resize( iNumVertices );
+	for (TUInt32 iVertex = 0; iVertex < iNumVertices; ++iVertex)
+	{
+		CVector3& vertex = mesh.vertices[iVertex];
+		if (!tokens.ReadFloat( &vertex.x ) || !tokens.ReadFloat( &vertex.y ) ||
+		    !tokens.ReadFloat( &vertex.z ))
+		{
+			return kInvalidData;
+		}
+	}
+
+	// Read faces - they can be general polygons - convert them all to triangles
+	TUInt32 iNumFaces;
+	if (!tokens.ReadUInt( &iNumFaces ) || !tokens.HasValues( 4ull * iNumFaces ))
+	{
+		return kInvalidData;
+	}
+	mesh.origFaceEdges.resize( iNumFaces ); // See ReadMeshData
+	mesh.faces.reserve( iNumFaces );
+	for (TUInt32 iFace = 0; iFace < iNumFaces; ++iFace)
+	{
+		TUInt32 iNumEdges;
+		TUInt32 iFirstIndex, iIndexA, iIndexB;
+		if (!tokens.ReadUInt( &iNumEdges ) ||
+		    !tokens.ReadUInt( &iFirstIndex ) || !tokens.ReadUInt( &iIndexA ) ||
+		    iFirstIndex >= iNumVertices || iIndexA >= iNumVertices)
+		{
+			return kInvalidData;
+		}
+		mesh.origFaceEdges[iFace] = iNumEdges;
+
+		// Use successive pairs of indices to form triangles with the first one
+		for (TUInt32 iEdge = 2; iEdge < iNumEdges; ++iEdge)
+		{
+			if (!tokens.ReadUInt( &iIndexB ) || iIndexB >= iNumVertices)
+			{
+				return kInvalidData;
+			}
+			SXFileFace face = { iFirstIndex, iIndexA, iIndexB };
+			mesh.faces.push_back( face );
+			iIndexA = iIndexB;
+		}
+	}
+
+	// Counter for bones read from child data objects
+	TUInt32 iCurrBone = 0;
+
+	// For each child object
+	while (!tokens.ReadChar( '}' ))
+	{
+		string sTemplate, sName;
+		if (!ReadTextObjectHeader( state, &sTemplate, &sName ))
+		{
+			return kInvalidData;
+		}
+
+		// Found normal data
+		EImportError eError;
+		if (sTemplate == "MeshNormals")
+		{
+			eError = ReadTextNormalData( state, iCurrMesh );
+		}
+
+		// Found texture coordinate data
+		else if (sTemplate == "MeshTextureCoords")
+		{
+			eError = ReadTextTextureUVData( state, iCurrMesh );
+		}
+
+		// Found vertex colour data
+		else if (sTemplate == "MeshVertexColors")
+		{
+			eError = ReadTextVertexColourData( state, iCurrMesh );
+		}
+
+		// Found material list
+		else if (sTemplate == "MeshMaterialList")
+		{
+			eError = ReadTextMaterialData( state, iCurrMesh );
+		}
+
+		// Found vertex duplication list
+		else if (sTemplate == "VertexDuplicationIndices")
+		{
+			eError = ReadTextDuplicationData( state, iCurrMesh );
+		}
+
+		// Found face adjacency data
+		else if (sTemplate == "FaceAdjacency")
+		{
+			eError = ReadTextAdjacencyData( state, iCurrMesh );
+		}
+
+		// Found skinning definition
+		else if (sTemplate == "XSkinMeshHeader")
+		{
+			eError = ReadTextSkinDefnData( state, iCurrMesh );
+		}
+
+		// Found skin weights
+		else if (sTemplate == "SkinWeights")
+		{
+			eError = ReadTextSkinWeightsData( state, iCurrMesh, iCurrBone );
+			++iCurrBone;
+		}
+
+		// Found unknown mesh data or a reference - won't flag this as failure though
+		else
+		{
+			eError = (sTemplate == "" || tokens.SkipBlock()) ? kSuccess : kInvalidData;
+		}
+
+		if (eError != kSuccess)
+		{
+			return eError;
+		}
+	}
+
+	// Check if not enough bones
+	if (iCurrBone != mesh.bones.size())
+	{
+		return kInvalidData;
+	}
+
+	// Match the face lists of vertices and normals, so there is exactly one normal per vertex
+	MatchFaceLists( iCurrMesh );
+
+	return kSuccess;
+
+	GEN_ENDGUARD;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Text X-File template parsing
+-----------------------------------------------------------------------------------------*/
+
+// Read a normal data object from a text X-File
+EImportError CImportXFile::ReadTextNormalData( SXFileTextState& state, const TUInt32 iMesh )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Only allow one vertex normal list in a mesh
+	if (mesh.normals.size() > 0)
+	{
+		return kInvalidData;
+	}
+
+	// Read normals
+	TUInt32 iNumNormals;
+	if (!tokens.ReadUInt( &iNumNormals ) || !tokens.HasValues( 3ull * iNumNormals ))
+	{
+		return kInvalidData;
+	}
+	mesh.normals.resize( iNumNormals );
+	for (TUInt32 iNormal = 0; iNormal < iNumNormals; ++iNormal)
+	{
+		CVector3& normal = mesh.normals[iNormal];
+		if (!tokens.ReadFloat( &normal.x ) || !tokens.ReadFloat( &normal.y ) ||
+		    !tokens.ReadFloat( &normal.z ))
+		{
+			return kInvalidData;
+		}
+	}
+
+	// Verify that normal face list matches face list
+	TUInt32 iNumNormalFaces;
+	if (!tokens.ReadUInt( &iNumNormalFaces ) || iNumNormalFaces != mesh.origFaceEdges.size())
+	{
+		return kInvalidData;
+	}
+
+	// Read normal faces - they can be general polygons - convert them all to triangles
+	mesh.normalFaces.reserve( mesh.faces.size() );
+	for (TUInt32 iFace = 0; iFace < iNumNormalFaces; ++iFace)
+	{
+		// Check number of edges against original face data
+		TUInt32 iNumEdges;
+		TUInt32 iFirstIndex, iIndexA, iIndexB;
+		if (!tokens.ReadUInt( &iNumEdges ) || iNumEdges != mesh.origFaceEdges[iFace] ||
+		    !tokens.ReadUInt( &iFirstIndex ) || !tokens.ReadUInt( &iIndexA ) ||
+		    iFirstIndex >= iNumNormals || iIndexA >= iNumNormals)
+		{
+			return kInvalidData;
+		}
+
+		// Use successive pairs of indices to form triangles with the first one
+		for (TUInt32 iEdge = 2; iEdge < iNumEdges; ++iEdge)
+		{
+			if (!tokens.ReadUInt( &iIndexB ) || iIndexB >= iNumNormals)
+			{
+				return kInvalidData;
+			}
+			SXFileFace face = { iFirstIndex, iIndexA, iIndexB };
+			mesh.normalFaces.push_back( face );
+			iIndexA = iIndexB;
+		}
+	}
+
+	return tokens.ReadChar( '}' ) ? kSuccess : kInvalidData;
+
+	GEN_ENDGUARD;
+}
+
+// Read a texture coordinate object from a text X-File
+EImportError CImportXFile::ReadTextTextureUVData( SXFileTextState& state, const TUInt32 iMesh )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Only allow one texture coordinate list in a mesh
+	if (mesh.textureCoords.size() > 0)
+	{
+		return kInvalidData;
+	}
+
+	// Read texture coordinates - must be one per vertex
+	TUInt32 iNumTextureCoords;
+	if (!tokens.ReadUInt( &iNumTextureCoords ) || iNumTextureCoords != mesh.vertices.size())
+	{
+		return kInvalidData;
+	}
+	mesh.textureCoords.resize( iNumTextureCoords );
+	for (TUInt32 iUV = 0; iUV < iNumTextureCoords; ++iUV)
+	{
+		if (!tokens.ReadFloat( &mesh.textureCoords[iUV].fU ) ||
+		    !tokens.ReadFloat( &mesh.textureCoords[iUV].fV ))
+		{
+			return kInvalidData;
+		}
+	}
+
+	return tokens.ReadChar( '}' ) ? kSuccess : kInvalidData;
+
+	GEN_ENDGUARD;
+}
+
+// Read a vertex colour object from a text X-File, any vertices not assigned a colour will get white
+EImportError CImportXFile::ReadTextVertexColourData( SXFileTextState& state, const TUInt32 iMesh )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Only allow one vertex colour list in a mesh
+	if (mesh.vertexColours.size() > 0)
+	{
+		return kInvalidData;
+	}
+
+	// Read vertex colours, all colours default to white if not assigned. There is one colour
+	// per vertex, which may not all be listed
+	TUInt32 iNumVertexColours;
+	if (!tokens.ReadUInt( &iNumVertexColours ) || !tokens.HasValues( 5ull * iNumVertexColours ))
+	{
+		return kInvalidData;
+	}
+	SXFileRGBAColour defaultColour = { 1.0f, 1.0f, 1.0f, 1.0f };
+	mesh.vertexColours.resize( mesh.vertices.size(), defaultColour );
+	for (TUInt32 iColour = 0; iColour < iNumVertexColours; ++iColour)
+	{
+		TUInt32 iVertexIndex;
+		if (!tokens.ReadUInt( &iVertexIndex ) || iVertexIndex >= mesh.vertices.size())
+		{
+			return kInvalidData;
+		}
+		SXFileRGBAColour& colour = mesh.vertexColours[iVertexIndex];
+		if (!tokens.ReadFloat( &colour.fRed ) || !tokens.ReadFloat( &colour.fGreen ) ||
+		    !tokens.ReadFloat( &colour.fBlue ) || !tokens.ReadFloat( &colour.fAlpha ))
+		{
+			return kInvalidData;
+		}
+	}
+
+	return tokens.ReadChar( '}' ) ? kSuccess : kInvalidData;
+
+	GEN_ENDGUARD;
+}
+
+// Read a material list object from a text X-File. Its materials may be given in full or be
+// references to named top level materials
+EImportError CImportXFile::ReadTextMaterialData( SXFileTextState& state, const TUInt32 iMesh )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Only allow one material list in a mesh
+	if (mesh.materials.size() > 0)
+	{
+		return kInvalidData;
+	}
+
+	// Read number of materials and initialise material list
+	TUInt32 iNumMaterials;
+	if (!tokens.ReadUInt( &iNumMaterials ) || !tokens.HasValues( iNumMaterials ))
+	{
+		return kInvalidData;
+	}
+	SXFileMaterial defaultMaterial =
+	{
+		"",
+		{ 1.0f, 1.0f, 1.0f, 1.0f },
+		20.0f, { 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 0.0f },
+		""
+	};
+	mesh.materials.resize( iNumMaterials, defaultMaterial );
+
+	// Read face materials - matching the original face list before it was split into triangles.
+	// Will convert to match the new (triangle-only) face list
+	TUInt32 iNumFaceMaterials;
+	if (!tokens.ReadUInt( &iNumFaceMaterials ))
+	{
+		return kInvalidData;
+	}
+
+	// Handle undocumented case with only one face material - all faces use same material
+	if (iNumFaceMaterials == 1 && mesh.origFaceEdges.size() != 1)
+	{
+		TUInt32 iFaceMaterial;
+		if (!tokens.ReadUInt( &iFaceMaterial ) || iFaceMaterial >= iNumMaterials)
+		{
+			return kInvalidData;
+		}
+		mesh.faceMaterials.resize( mesh.faces.size(), iFaceMaterial );
+	}
+	else // Read standard face materials - one material reference for each face
+	{
+		if (iNumFaceMaterials != mesh.origFaceEdges.size())
+		{
+			return kInvalidData;
+		}
+		mesh.faceMaterials.resize( mesh.faces.size() );
+		TUInt32 iFace = 0;
+		for (TUInt32 iOrigFace = 0; iOrigFace < iNumFaceMaterials; ++iOrigFace)
+		{
+			TUInt32 iMaterial;
+			if (!tokens.ReadUInt( &iMaterial ) || iMaterial >= iNumMaterials)
+			{
+				return kInvalidData;
+			}
+			for (TUInt32 iEdge = 2; iEdge < mesh.origFaceEdges[iOrigFace]; ++iEdge)
+			{
+				mesh.faceMaterials[iFace] = iMaterial;
+				++iFace;
+			}
+		}
+	}
+
+	// Read materials from child objects
+	TUInt32 iMaterialsRead = 0;
+	while (!tokens.ReadChar( '}' ))
+	{
+		string sTemplate, sName;
+		if (!ReadTextObjectHeader( state, &sTemplate, &sName ))
+		{
+			return kInvalidData;
+		}
+
+		// Found material or reference to a named material
+		if (sTemplate == "Material" || sTemplate == "")
+		{
+			// Check if too many materials
+			if (iMaterialsRead >= iNumMaterials)
+			{
+				return kInvalidData;
+			}
+
+			if (sTemplate == "")
+			{
+				SXFileTextState::SMaterialReference reference = { iMesh, iMaterialsRead, sName };
+				state.materialReferences.push_back( reference );
+			}
+			else
+			{
+				EImportError eError = ReadTextMaterial( state, &mesh.materials[iMaterialsRead] );
+				if (eError != kSuccess)
+				{
+					return eError;
+				}
+				mesh.materials[iMaterialsRead].sName = sName;
+			}
+
+			// Increase number of materials that have been found and read
+			++iMaterialsRead;
+		}
+
+		// Found unknown material list data - ignore
+		else if (!tokens.SkipBlock())
+		{
+			return kInvalidData;
+		}
+	}
+
+	// Check if not enough materials
+	if (iMaterialsRead != iNumMaterials)
+	{
+		return kInvalidData;
+	}
+
+	return kSuccess;
+
+	GEN_ENDGUARD;
+}
+
+// Read a vertex duplication object from a text X-File
+EImportError CImportXFile::ReadTextDuplicationData( SXFileTextState& state, const TUInt32 iMesh )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Only allow one vertex duplication list in a mesh
+	if (mesh.duplicateIndices.size() > 0)
+	{
+		return kInvalidData;
+	}
+
+	// Read duplicaton indices, also fetch number of unique vertices
+	TUInt32 iNumDuplicationIndices;
+	if (!tokens.ReadUInt( &iNumDuplicationIndices ) ||
+	    iNumDuplicationIndices != mesh.vertices.size() ||
+	    !tokens.ReadUInt( &mesh.iNumUniqueVertices ))
+	{
+		return kInvalidData;
+	}
+	mesh.duplicateIndices.resize( iNumDuplicationIndices );
+	for (TUInt32 iIndex = 0; iIndex < iNumDuplicationIndices; ++iIndex)
+	{
+		if (!tokens.ReadUInt( &mesh.duplicateIndices[iIndex] ))
+		{
+			return kInvalidData;
+		}
+	}
+
+	return tokens.ReadChar( '}' ) ? kSuccess : kInvalidData;
+
+	GEN_ENDGUARD;
+}
+
+// Read a face adjacency object from a text X-File
+EImportError CImportXFile::ReadTextAdjacencyData( SXFileTextState& state, const TUInt32 iMesh )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Only allow one face adjacency list in a mesh
+	if (mesh.adjacencyIndices.size() > 0)
+	{
+		return kInvalidData;
+	}
+
+	// Read face adjacency list
+	TUInt32 iNumAdjacencyIndices;
+	if (!tokens.ReadUInt( &iNumAdjacencyIndices ) || !tokens.HasValues( iNumAdjacencyIndices ))
+	{
+		return kInvalidData;
+	}
+	mesh.adjacencyIndices.resize( iNumAdjacencyIndices );
+	for (TUInt32 iIndex = 0; iIndex < iNumAdjacencyIndices; ++iIndex)
+	{
+		if (!tokens.ReadUInt( &mesh.adjacencyIndices[iIndex] ))
+		{
+			return kInvalidData;
+		}
+	}
+
+	return tokens.ReadChar( '}' ) ? kSuccess : kInvalidData;
+
+	GEN_ENDGUARD;
+}
+
+// Read a skinning header object from a text X-File
+EImportError CImportXFile::ReadTextSkinDefnData( SXFileTextState& state, const TUInt32 iMesh )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Only allow one skining definition in a mesh
+	if (mesh.bones.size() > 0)
+	{
+		return kInvalidData;
+	}
+
+	// Read maximum weights info and number of bones used
+	TUInt16 iNumBones;
+	if (!tokens.ReadUInt16( &mesh.iMaxBonesPerVertex ) ||
+	    !tokens.ReadUInt16( &mesh.iMaxBonesPerFace ) || !tokens.ReadUInt16( &iNumBones ))
+	{
+		return kInvalidData;
+	}
+
+	// Initialise bone structures
+	SXFileBone bone;
+	bone.iFrame = 0;
+	bone.offsetMatrix = CMatrix4x4::kIdentity;
+	mesh.bones.resize( iNumBones, bone );
+
+	return tokens.ReadChar( '}' ) ? kSuccess : kInvalidData;
+
+	GEN_ENDGUARD;
+}
+
+// Read a skinning weights object from a text X-File
+EImportError CImportXFile::ReadTextSkinWeightsData( SXFileTextState& state, const TUInt32 iMesh,
+                                                    const TUInt32 iBone )
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+	SXFileMesh& mesh = m_Meshes[iMesh];
+
+	// Check if no skinning definition or too many bones
+	if (mesh.bones.size() == 0 || iBone >= mesh.bones.size())
+	{
+		return kInvalidData;
+	}
+	SXFileBone& bone = mesh.bones[iBone];
+
+	// Read name of bone and number of weights
+	TUInt32 iNumWeights;
+	if (!tokens.ReadString( &bone.sFrameName ) || !tokens.ReadUInt( &iNumWeights ) ||
+	    !tokens.HasValues( 2ull * iNumWeights ))
+	{
+		return kInvalidData;
+	}
+	bone.weights.resize( iNumWeights );
+
+	// Read skinning indices, weights and offset matrix
+	for (TUInt32 iIndex = 0; iIndex < iNumWeights; ++iIndex)
+	{
+		if (!tokens.ReadUInt( &bone.weights[iIndex].iVertexIndex ))
+		{
+			return kInvalidData;
+		}
+	}
+	for (TUInt32 iWeight = 0; iWeight < iNumWeights; ++iWeight)
+	{
+		if (!tokens.ReadFloat( &bone.weights[iWeight].fWeight ))
+		{
+			return kInvalidData;
+		}
+	}
+	if (!tokens.ReadFloats( &bone.offsetMatrix.e00, 16 ))
+	{
+		return kInvalidData;
+	}
+
+	return tokens.ReadChar( '}' ) ? kSuccess : kInvalidData;
+
+	GEN_ENDGUARD;
+}
+
+
+// Read a material object (including its close brace) from a text X-File
+EImportError CImportXFile::ReadTextMaterial
+(
+	SXFileTextState& state,
+	SXFileMaterial*  pMaterial
+)
+{
+	GEN_GUARD;
+
+	CXFileTokenizer& tokens = state.tokens;
+
+	// Face colour, specular power, specular colour and emissive colour
+	if (!tokens.ReadFloat( &pMaterial->faceColour.fRed ) ||
+	    !tokens.ReadFloat( &pMaterial->faceColour.fGreen ) ||
+	    !tokens.ReadFloat( &pMaterial->faceColour.fBlue ) ||
+	    !tokens.ReadFloat( &pMaterial->faceColour.fAlpha ) ||
+	    !tokens.ReadFloat( &pMaterial->fSpecularPower ) ||
+	    !tokens.ReadFloat( &pMaterial->specularColour.fRed ) ||
+	    !tokens.ReadFloat( &pMaterial->specularColour.fGreen ) ||
+	    !tokens.ReadFloat( &pMaterial->specularColour.fBlue ) ||
+	    !tokens.ReadFloat( &pMaterial->emmisiveColour.fRed ) ||
+	    !tokens.ReadFloat( &pMaterial->emmisiveColour.fGreen ) ||
+	    !tokens.ReadFloat( &pMaterial->emmisiveColour.fBlue ))
+	{
+		return kInvalidData;
+	}
+	pMaterial->sTextureName = "";
+
+	// For each child object
+	while (!tokens.ReadChar( '}' ))
+	{
+		string sTemplate, sName;
+		if (!ReadTextObjectHeader( state, &sTemplate, &sName ))
+		{
+			return kInvalidData;
+		}
+
+		// Found texture filename in material
+		if (sTemplate == "TextureFilename")
+		{
+			if (!tokens.ReadString( &pMaterial->sTextureName ) || !tokens.ReadChar( '}' ))
+			{
+				return kInvalidData;
+			}
+		}
+
+		// Found unknown material data - ignore
+		else if (sTemplate != "" && !tokens.SkipBlock())
+		{
+			return kInvalidData;
+		}
+	}
+
+	return kSuccess;
+
+	GEN_ENDGUARD;
+}
+
+
+} // namespace gen
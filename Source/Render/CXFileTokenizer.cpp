@@ -0,0 +1,173 @@
+/**************************************************************************************************
+	Module:       CXFileTokenizer.cpp
+
+	Tokenizer for text format Microsoft DirectX .X files, used by CImportXFile to import X-Files
+	without the DirectX X-File API
+**************************************************************************************************/
+
+#include <math.h>
+
+#include "CXFileTokenizer.h"
+
+namespace gen
+{
+
+/*-----------------------------------------------------------------------------------------
+	Constants
+-----------------------------------------------------------------------------------------*/
+
+// Powers of ten that are exactly representable in a double. Scaling a mantissa of up to 2^53
+// by one of these gives a correctly rounded result
+const double kaPowersOf10[] =
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const TInt32 kiMaxExactPowerOf10 = 22;
+
+// Digits are accumulated into the integer mantissa while it is below this value, so it can hold
+// 18 or 19 significant digits - far more than a float needs. Later digits only affect the exponent
+const TUInt64 kiMaxMantissa = 100000000000000000ull;
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+
+// Skip the rest of a block whose open brace has been read, including any nested blocks and
+// its close brace. Returns false if the text ends first
+bool CXFileTokenizer::SkipBlock()
+{
+	TUInt32 depth = 1;
+	while (m_Pos != m_End)
+	{
+		const char c = *m_Pos++;
+		if (c == '{')
+		{
+			++depth;
+		}
+		else if (c == '}')
+		{
+			if (--depth == 0)
+			{
+				return true;
+			}
+		}
+		else if (c == '"')
+		{
+			// Strings may contain braces
+			while (m_Pos != m_End && *m_Pos++ != '"');
+		}
+		else if (c == '#' || (c == '/' && m_Pos != m_End && *m_Pos == '/'))
+		{
+			// As may comments
+			while (m_Pos != m_End && *m_Pos != '\n') ++m_Pos;
+		}
+	}
+	return false;
+}
+
+
+// Read a float, returns false if the next token is not a number. The digits are converted
+// directly from the text: an integer mantissa and a power of ten are collected, then combined
+// in double precision. This gives the same result as strtod (rounded to float) for the numbers
+// found in practice, without copying the token to make a null terminated string
+bool CXFileTokenizer::ReadFloat( TFloat32* value )
+{
+	SkipSeparators();
+	const char* pos = m_Pos;
+
+	bool negative = false;
+	if (pos != m_End && (*pos == '-' || *pos == '+'))
+	{
+		negative = (*pos == '-');
+		++pos;
+	}
+
+	// Integer and fractional digits
+	TUInt64 mantissa = 0;
+	TInt32  exponent = 0;
+	bool    anyDigits = false;
+	while (pos != m_End && IsDigit( *pos ))
+	{
+		if (mantissa < kiMaxMantissa)
+		{
+			mantissa = mantissa * 10 + (*pos - '0');
+		}
+		else
+		{
+			++exponent;
+		}
+		anyDigits = true;
+		++pos;
+	}
+	if (pos != m_End && *pos == '.')
+	{
+		++pos;
+		while (pos != m_End && IsDigit( *pos ))
+		{
+			if (mantissa < kiMaxMantissa)
+			{
+				mantissa = mantissa * 10 + (*pos - '0');
+				--exponent;
+			}
+			anyDigits = true;
+			++pos;
+		}
+	}
+	if (!anyDigits)
+	{
+		return false;
+	}
+
+	// Optional exponent - only part of the number if it has digits
+	if (pos != m_End && (*pos == 'e' || *pos == 'E'))
+	{
+		const char* expPos = pos + 1;
+		bool negativeExp = false;
+		if (expPos != m_End && (*expPos == '-' || *expPos == '+'))
+		{
+			negativeExp = (*expPos == '-');
+			++expPos;
+		}
+		if (expPos != m_End && IsDigit( *expPos ))
+		{
+			TInt32 numberExp = 0;
+			while (expPos != m_End && IsDigit( *expPos ))
+			{
+				if (numberExp < 10000) // Far beyond float range, so no need for more
+				{
+					numberExp = numberExp * 10 + (*expPos - '0');
+				}
+				++expPos;
+			}
+			exponent += negativeExp ? -numberExp : numberExp;
+			pos = expPos;
+		}
+	}
+
+	// Combine mantissa and exponent
+	double result = static_cast<double>(mantissa);
+	if (mantissa != 0 && exponent != 0)
+	{
+		if (exponent < 0 && exponent >= -kiMaxExactPowerOf10)
+		{
+			result /= kaPowersOf10[-exponent];
+		}
+		else if (exponent > 0 && exponent <= kiMaxExactPowerOf10)
+		{
+			result *= kaPowersOf10[exponent];
+		}
+		else
+		{
+			result *= pow( 10.0, static_cast<double>(exponent) );
+		}
+	}
+	*value = static_cast<TFloat32>(negative ? -result : result);
+
+	m_Pos = pos;
+	return true;
+}
+
+
+} // namespace gen
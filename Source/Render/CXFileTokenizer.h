@@ -0,0 +1,259 @@
+/**************************************************************************************************
+	Module:       CXFileTokenizer.h
+
+	Tokenizer for text format Microsoft DirectX .X files, used by CImportXFile to import X-Files
+	without the DirectX X-File API
+**************************************************************************************************/
+
+#ifndef GEN_C_XFILE_TOKENIZER_H_INCLUDED
+#define GEN_C_XFILE_TOKENIZER_H_INCLUDED
+
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+// Reads the tokens of a text X-File from a block of memory (e.g. a memory mapped file), which does
+// not need to be null terminated. Tokens are read in place as they are needed, numbers are
+// converted directly from the text without copying. Commas, semicolons and comments are treated
+// as white space - X-File exporters are not consistent in their use of separators, and the
+// importer always knows how many values to read
+class CXFileTokenizer
+{
+	GEN_CLASS( CXFileTokenizer )
+
+/*-----------------------------------------------------------------------------------------
+	Types
+-----------------------------------------------------------------------------------------*/
+public:
+
+	// Types of token
+	enum EToken
+	{
+		Token_End,        // End of text
+		Token_OpenBrace,
+		Token_CloseBrace,
+		Token_Name,       // Identifier or number
+		Token_String,     // Quoted string
+		Token_GUID,       // GUID in angle brackets
+	};
+
+
+/*-----------------------------------------------------------------------------------------
+	Constructors/Destructors
+-----------------------------------------------------------------------------------------*/
+public:
+	// Constructor - tokenize the text from start up to (not including) end
+	CXFileTokenizer( const char* start, const char* end )
+	{
+		m_Pos = start;
+		m_End = end;
+	}
+
+private:
+	// Disallow use of copy constructor and assignment operator (private and not defined)
+	CXFileTokenizer( const CXFileTokenizer& );
+	CXFileTokenizer& operator=( const CXFileTokenizer& );
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+public:
+
+	// Return the type of the next token without reading it
+	EToken PeekToken()
+	{
+		SkipSeparators();
+		if (m_Pos == m_End) return Token_End;
+		switch (*m_Pos)
+		{
+			case '{': return Token_OpenBrace;
+			case '}': return Token_CloseBrace;
+			case '"': return Token_String;
+			case '<': return Token_GUID;
+			default:  return Token_Name;
+		}
+	}
+
+	// Read the given single character token ('{' or '}'), returns false if the next token differs
+	bool ReadChar( const char token )
+	{
+		SkipSeparators();
+		if (m_Pos == m_End || *m_Pos != token)
+		{
+			return false;
+		}
+		++m_Pos;
+		return true;
+	}
+
+	// Read an identifier (or any other unquoted word), returns false if there is none
+	bool ReadName( string* name )
+	{
+		if (PeekToken() != Token_Name)
+		{
+			return false;
+		}
+		const char* start = m_Pos;
+		while (m_Pos != m_End && !IsSeparator( *m_Pos ) && *m_Pos != '{' && *m_Pos != '}' &&
+		       *m_Pos != '"' && *m_Pos != '<')
+		{
+			++m_Pos;
+		}
+		name->assign( start, m_Pos );
+		return true;
+	}
+
+	// Read a quoted string (without the quotes), returns false if there is none
+	bool ReadString( string* text )
+	{
+		if (PeekToken() != Token_String)
+		{
+			return false;
+		}
+		const char* start = ++m_Pos;
+		while (m_Pos != m_End && *m_Pos != '"')
+		{
+			++m_Pos;
+		}
+		if (m_Pos == m_End)
+		{
+			return false;
+		}
+		text->assign( start, m_Pos++ );
+		return true;
+	}
+
+	// Read a GUID in angle brackets (contents are not checked), returns false if there is none
+	bool SkipGUID()
+	{
+		if (PeekToken() != Token_GUID)
+		{
+			return false;
+		}
+		while (m_Pos != m_End && *m_Pos != '>')
+		{
+			++m_Pos;
+		}
+		if (m_Pos == m_End)
+		{
+			return false;
+		}
+		++m_Pos;
+		return true;
+	}
+
+	// Skip the rest of a block whose open brace has been read, including any nested blocks and
+	// its close brace. Returns false if the text ends first
+	bool SkipBlock();
+
+	// Return true if enough text remains to hold the given number of values - each value needs
+	// at least a character and a separator. Used to reject corrupt counts before allocating
+	bool HasValues( const TUInt64 numValues ) const
+	{
+		return numValues <= static_cast<TUInt64>(m_End - m_Pos) / 2 + 1;
+	}
+
+
+	// Read an unsigned integer, returns false if the next token is not one
+	bool ReadUInt( TUInt32* value )
+	{
+		SkipSeparators();
+		const char* pos = m_Pos;
+		if (pos != m_End && *pos == '+') ++pos;
+		if (pos == m_End || !IsDigit( *pos ))
+		{
+			return false;
+		}
+		TUInt64 result = 0;
+		while (pos != m_End && IsDigit( *pos ))
+		{
+			result = result * 10 + (*pos++ - '0');
+			if (result > 0xffffffffu)
+			{
+				return false;
+			}
+		}
+		*value = static_cast<TUInt32>(result);
+		m_Pos = pos;
+		return true;
+	}
+
+	// Read an unsigned 16-bit integer, returns false if the next token is not one
+	bool ReadUInt16( TUInt16* value )
+	{
+		TUInt32 result;
+		if (!ReadUInt( &result ) || result > 0xffff)
+		{
+			return false;
+		}
+		*value = static_cast<TUInt16>(result);
+		return true;
+	}
+
+	// Read a float, returns false if the next token is not a number
+	bool ReadFloat( TFloat32* value );
+
+	// Read a given number of floats, returns false if there are not enough numbers
+	bool ReadFloats( TFloat32* values, const TUInt32 numValues )
+	{
+		for (TUInt32 value = 0; value < numValues; ++value)
+		{
+			if (!ReadFloat( &values[value] ))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+/*-----------------------------------------------------------------------------------------
+	Private interface
+-----------------------------------------------------------------------------------------*/
+private:
+
+	static bool IsDigit( const char c )
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	static bool IsSeparator( const char c )
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == ';';
+	}
+
+	// Move past white space, separators and comments
+	void SkipSeparators()
+	{
+		while (m_Pos != m_End)
+		{
+			if (IsSeparator( *m_Pos ))
+			{
+				++m_Pos;
+			}
+			else if (*m_Pos == '#' || (*m_Pos == '/' && m_Pos + 1 != m_End && m_Pos[1] == '/'))
+			{
+				while (m_Pos != m_End && *m_Pos != '\n') ++m_Pos;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+
+	// Current position and end of the text
+	const char* m_Pos;
+	const char* m_End;
+};
+
+
+} // namespace gen
+
+#endif // GEN_C_XFILE_TOKENIZER_H_INCLUDED
@@ -4,18 +4,23 @@
 	Mesh class implementation
 ********************************************/
 
+#ifndef GEN_HEADLESS
 #include <d3d10.h>
 #include <d3dx10.h>
+#endif
 #include "Mesh.h"
+#include "MeshCache.h"
 #include "CImportXFile.h"
 #include "RenderMethod.h"
 
 namespace gen
 {
 
+#ifndef GEN_HEADLESS
 // Get reference to global variables from another source file
 // Not good practice - these functions should be part of a class with this as a member
 extern ID3D10Device* g_pd3dDevice;
+#endif
 
 // Folder for all texture and mesh files
 extern const string MediaFolder;
@@ -36,10 +41,16 @@ CMesh::CMesh()
 
 	m_NumSubMeshes = 0;
 	m_SubMeshes = 0;
+	m_CacheFile = 0;
+
+	m_NumImportedMaterials = 0;
+	m_ImportedMaterials = 0;
+#ifndef GEN_HEADLESS
 	m_SubMeshesDX = 0;
 
 	m_NumMaterials = 0;
 	m_Materials = 0;
+#endif
 }
 
 // Model destructor
@@ -52,6 +63,7 @@ CMesh::~CMesh()
 // Release all nodes, sub-meshes and materials along with any DirectX data
 void CMesh::ReleaseResources()
 {
+#ifndef GEN_HEADLESS
 	for (TUInt32 material = 0; material < m_NumMaterials; ++material)
 	{
 		for (TUInt32 texture = 0; texture < m_Materials[material].numTextures; ++texture)
@@ -63,17 +75,35 @@ void CMesh::ReleaseResources()
 	m_Materials = 0;
 	m_NumMaterials = 0;
 
-	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	for (TUInt32 subMesh = 0; m_SubMeshesDX && subMesh < m_NumSubMeshes; ++subMesh)
 	{
 		if (m_SubMeshesDX[subMesh].indexBuffer)	 m_SubMeshesDX[subMesh].indexBuffer->Release();
 		if (m_SubMeshesDX[subMesh].vertexBuffer) m_SubMeshesDX[subMesh].vertexBuffer->Release();
 		if (m_SubMeshesDX[subMesh].vertexLayout) m_SubMeshesDX[subMesh].vertexLayout->Release();
 	}
 	delete[] m_SubMeshesDX;
-	delete[] m_SubMeshes;
 	m_SubMeshesDX = 0;
+#endif
+
+	delete[] m_ImportedMaterials;
+	m_ImportedMaterials = 0;
+	m_NumImportedMaterials = 0;
+
+	// Sub-mesh vertex / face data imported from an X-File is allocated by the import class and
+	// owned by the mesh, data from a cache file is in the mapped file
+	if (!m_CacheFile)
+	{
+		for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+		{
+			delete[] m_SubMeshes[subMesh].vertices;
+			delete[] m_SubMeshes[subMesh].faces;
+		}
+	}
+	delete[] m_SubMeshes;
 	m_SubMeshes = 0;
 	m_NumSubMeshes = 0;
+	delete m_CacheFile; // Sub-mesh data may be in the cache file, so close it after them
+	m_CacheFile = 0;
 
 	delete[] m_Nodes;
 	m_Nodes = 0;
@@ -226,12 +256,72 @@ bool CMesh::GetVertex( CVector3* pVertex )
 }
 
 
+//-----------------------------------------------------------------------------
+// Cache loading
+//-----------------------------------------------------------------------------
+
+// Import the mesh from the binary cache of the given X-File if there is an up-to-date one,
+// returns true on success. The cache file stays mapped while the mesh uses it
+bool CMesh::ImportCache( const string& fullFileName )
+{
+	// Open and check the cache, rejecting it if the X-File has changed since it was written
+	CMeshCacheFile* cacheFile = new CMeshCacheFile;
+	if (!cacheFile->Open( MeshCacheFileName( fullFileName ), fullFileName ))
+	{
+		delete cacheFile;
+		return false;
+	}
+
+	// Release any existing geometry
+	ReleaseResources();
+	m_CacheFile = cacheFile;
+
+	// Get node data from cache
+	m_NumNodes = cacheFile->GetNumNodes();
+	m_Nodes = new SMeshNode[m_NumNodes];
+	for (TUInt32 node = 0; node < m_NumNodes; ++node)
+	{
+		cacheFile->GetNode( node, &m_Nodes[node] );
+	}
+
+	// Get material data from cache, kept until the materials are created
+	m_NumImportedMaterials = cacheFile->GetNumMaterials();
+	m_ImportedMaterials = new SMeshMaterial[m_NumImportedMaterials];
+	for (TUInt32 material = 0; material < m_NumImportedMaterials; ++material)
+	{
+		cacheFile->GetMaterial( material, &m_ImportedMaterials[material] );
+	}
+
+	// Get submesh data from cache. The vertices and faces are already split and have tangents
+	// where needed, so they are used in place in the mapped file and uploaded without conversion
+	m_NumSubMeshes = cacheFile->GetNumSubMeshes();
+	m_SubMeshes = new SSubMesh[m_NumSubMeshes];
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		cacheFile->GetSubMesh( subMesh, &m_SubMeshes[subMesh] );
+	}
+
+	// Bounds were calculated when the cache was written
+	cacheFile->GetBounds( &m_MinBounds, &m_MaxBounds, &m_BoundingRadius );
+
+	return true;
+}
+
+
 //-----------------------------------------------------------------------------
 // Creation
 //-----------------------------------------------------------------------------
 
-// Create the model from an X-File, returns true on success
+// Create the model from an X-File, returns true on success. Imports the file then creates the
+// DirectX resources, see Import and CreateResources
 bool CMesh::Load( const string& fileName )
+{
+	return Import( fileName ) && CreateResources();
+}
+
+// Import the mesh from an X-File or its binary cache, without creating any DirectX resources.
+// Returns true on success
+bool CMesh::Import( const string& fileName )
 {
 	// Create a X-File import helper class
 	CImportXFile importFile;
@@ -239,6 +329,12 @@ bool CMesh::Load( const string& fileName )
 	// Add media folder path
 	string fullFileName = MediaFolder + fileName;
 
+	// Use the binary cache of the file if there is one
+	if (ImportCache( fullFileName ))
+	{
+		return true;
+	}
+
 	// Check that the given file is an X-file
 	if (!importFile.IsXFile( fullFileName ))
 	{
@@ -258,10 +354,7 @@ bool CMesh::Load( const string& fileName )
 	}
 
 	// Release any existing geometry
-	if (m_HasGeometry)
-	{
-		ReleaseResources();
-	}
+	ReleaseResources();
 
 	// Get node data from import class
 	m_NumNodes = importFile.GetNumNodes();
@@ -275,31 +368,19 @@ bool CMesh::Load( const string& fileName )
 		importFile.GetNode( node, &m_Nodes[node] );
 	}
 
-	// Get material data from import class, also load textures
-	TUInt32 requiredMaterials = importFile.GetNumMaterials();
-	m_Materials = new SMeshMaterialDX[requiredMaterials];
-	if (!m_Materials)
+	// Get material data from import class, kept until the materials are created
+	m_NumImportedMaterials = importFile.GetNumMaterials();
+	m_ImportedMaterials = new SMeshMaterial[m_NumImportedMaterials];
+	for (TUInt32 material = 0; material < m_NumImportedMaterials; ++material)
 	{
-		ReleaseResources();
-		return false;
-	}
-	for (m_NumMaterials = 0; m_NumMaterials < requiredMaterials; ++m_NumMaterials)
-	{
-		SMeshMaterial importMaterial; 
-		importFile.GetMaterial( m_NumMaterials, &importMaterial );
-		if (!CreateMaterialDX( importMaterial, &m_Materials[m_NumMaterials] ))
-		{
-			ReleaseResources();
-			return false;
-		}
+		importFile.GetMaterial( material, &m_ImportedMaterials[material] );
 	}
 
-	// Get submesh data from import class - convert to DirectX data for rendering
-	// but retain original data for easy access to vertices / faces
+	// Get submesh data from import class - retained for easy access to vertices / faces, and
+	// converted to DirectX data for rendering when resources are created
 	TUInt32 requiredSubMeshes = importFile.GetNumSubMeshes();
 	m_SubMeshes = new SSubMesh[requiredSubMeshes];
-	m_SubMeshesDX = new SSubMeshDX[requiredSubMeshes];
-	if (!m_SubMeshes || !m_SubMeshesDX)
+	if (!m_SubMeshes)
 	{
 		ReleaseResources();
 		return false;
@@ -311,24 +392,74 @@ bool CMesh::Load( const string& fileName )
 		bool needTangents = RenderMethodUsesTangents( meshMethod );
 
 		importFile.GetSubMesh( m_NumSubMeshes, &m_SubMeshes[m_NumSubMeshes], needTangents );
-		if (!CreateSubMeshDX( m_SubMeshes[m_NumSubMeshes], &m_SubMeshesDX[m_NumSubMeshes] ))
+	}
+
+	// Geometry pre-processing - just calculating bounding box in this example
+	if (!PreProcess())
+	{
+		ReleaseResources();
+		return false;
+	}
+
+	return true;
+}
+
+// Create the DirectX resources for an imported mesh - materials with their textures and vertex /
+// index buffers for the sub-meshes. Returns true on success. Headless builds create no resources
+bool CMesh::CreateResources()
+{
+	// Must have been imported
+	if (m_NumSubMeshes == 0)
+	{
+		return false;
+	}
+
+#ifndef GEN_HEADLESS
+	// Create materials and load textures
+	m_Materials = new SMeshMaterialDX[m_NumImportedMaterials];
+	if (!m_Materials)
+	{
+		ReleaseResources();
+		return false;
+	}
+	for (m_NumMaterials = 0; m_NumMaterials < m_NumImportedMaterials; ++m_NumMaterials)
+	{
+		if (!CreateMaterialDX( m_ImportedMaterials[m_NumMaterials], &m_Materials[m_NumMaterials] ))
 		{
 			ReleaseResources();
 			return false;
 		}
 	}
 
-	// Geometry pre-processing - just calculating bounding box in this example
-	if (!PreProcess())
+	// Create vertex / index buffers. The list is zero initialised so that it can be released if
+	// only some sub-meshes are created
+	m_SubMeshesDX = new SSubMeshDX[m_NumSubMeshes]();
+	if (!m_SubMeshesDX)
 	{
 		ReleaseResources();
 		return false;
 	}
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		if (!CreateSubMeshDX( m_SubMeshes[subMesh], &m_SubMeshesDX[subMesh] ))
+		{
+			ReleaseResources();
+			return false;
+		}
+	}
+#endif
+
+	// Imported materials are no longer needed
+	delete[] m_ImportedMaterials;
+	m_ImportedMaterials = 0;
+	m_NumImportedMaterials = 0;
 
 	m_HasGeometry = true;
 	return true;
 }
 
+#ifndef GEN_HEADLESS
+
 // Creates a DirectX specific sub-mesh from an imported sub-mesh (mesh materials must already have been prepared as we need to know render method to setup vertex data)
 bool CMesh::CreateSubMeshDX
 (
@@ -505,6 +636,8 @@ bool CMesh::CreateMaterialDX
 	return true;
 }
 
+#endif // GEN_HEADLESS
+
 
 // Pre-processing after loading, returns true on success - just calculates bounding box here
 // Rejects mesh if no sub-meshes or any empty sub-meshes
@@ -534,62 +667,18 @@ bool CMesh::PreProcess()
 			return false;
 		}
 
-		// Go through all vertices
-		TUInt8* pVertex = m_SubMeshes[subMesh].vertices;
-		for (TUInt32 vert = 0; vert < m_SubMeshes[subMesh].numVertices; ++vert)
-		{
-			// Get vertex coord as vector
-			pVertexCoord = reinterpret_cast<TFloat32*>(pVertex); // Assume float x,y,z coord again
-			CVector3 vertex;
-			vertex.x = *pVertexCoord++;
-			vertex.y = *pVertexCoord++;
-			vertex.z = *pVertexCoord;
-			
-			// Compare vertex against current bounds, updating bounds where necessary
-			if (vertex.x < m_MinBounds.x)
-			{
-				m_MinBounds.x = vertex.x;
-			}
-			if (vertex.x > m_MaxBounds.x)
-			{
-				m_MaxBounds.x = vertex.x;
-			}
-			++pVertexCoord;
-
-			if (vertex.y < m_MinBounds.y)
-			{
-				m_MinBounds.y = vertex.y;
-			}
-			if (vertex.y > m_MaxBounds.y)
-			{
-				m_MaxBounds.y = vertex.y;
-			}
-			++pVertexCoord;
-
-			if (vertex.z < m_MinBounds.z)
-			{
-				m_MinBounds.z = vertex.z;
-			}
-			if (vertex.z > m_MaxBounds.z)
-			{
-				m_MaxBounds.z = vertex.z;
-			}
-
-			TFloat32 length = vertex.Length();
-			if (length > m_BoundingRadius)
-			{
-				m_BoundingRadius = length;
-			}
-
-			// Step to next vertex (flexible vertex size)
-			pVertex += m_SubMeshes[subMesh].vertexSize;
-		}
+		// Expand bounds to contain all vertices, stepping through them by the vertex size
+		// (flexible vertex size). Assume float x,y,z coord again
+		ExpandBounds( m_SubMeshes[subMesh].vertices, m_SubMeshes[subMesh].vertexSize,
+		              m_SubMeshes[subMesh].numVertices, &m_MinBounds, &m_MaxBounds, &m_BoundingRadius );
 	}
 
 	return true;
 }
 
 
+#ifndef GEN_HEADLESS
+
 //-----------------------------------------------------------------------------
 // Rendering
 //-----------------------------------------------------------------------------
@@ -629,4 +718,19 @@ void CMesh::Render(	CMatrix4x4* matrices )
 }
 
 
-} // namespace gen
\ No newline at end of file
+#else // GEN_HEADLESS
+
+//-----------------------------------------------------------------------------
+// Rendering
+//-----------------------------------------------------------------------------
+
+// Nothing to render in headless builds
+void CMesh::Render( CMatrix4x4* matrices )
+{
+	GEN_UNREFERENCED_PARAMETER( matrices );
+}
+
+#endif // GEN_HEADLESS
+
+
+} // namespace gen
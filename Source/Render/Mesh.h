@@ -9,7 +9,9 @@
 #include <string>
 using namespace std;
 
+#ifndef GEN_HEADLESS
 #include <d3d10.h>
+#endif
 
 #include "Defines.h"
 #include "CVector3.h"
@@ -19,6 +21,8 @@ using namespace std;
 
 namespace gen
 {
+
+class CMeshCacheFile;
 	
 // Mesh class
 class CMesh
@@ -107,9 +111,19 @@ public:
 	/////////////////////////////////////
 	// Creation
 
-	// Load the mesh from an X-File
+	// Load the mesh from an X-File. If there is an up-to-date binary cache of the file (see
+	// MeshCache.h) it is loaded instead, which is much faster. Headless builds (GEN_HEADLESS)
+	// create no DirectX resources - the mesh cannot be rendered - and can only import text
+	// X-Files. Same as calling Import then CreateResources
 	bool Load( const string& fileName );
 
+	// Loading can also be done in two steps. Import reads the file into memory and prepares the
+	// geometry, it uses no DirectX resources so different meshes can be imported on different
+	// threads at once. CreateResources then creates the DirectX materials, textures and buffers
+	// and should be called on the rendering thread. Both return true on success
+	bool Import( const string& fileName );
+	bool CreateResources();
+
 
 	/////////////////////////////////////
 	// Rendering
@@ -122,7 +136,12 @@ public:
 	Private interface
 -----------------------------------------------------------------------------------------*/
 private:
+
+	// Import the mesh from the binary cache of the given X-File if there is an up-to-date one,
+	// returns true on success. The cache file stays mapped while the mesh uses it
+	bool ImportCache( const string& fullFileName );
 	
+#ifndef GEN_HEADLESS
 	/////////////////////////////////////
 	// Types
 
@@ -167,9 +186,6 @@ private:
 	/////////////////////////////////////
 	// Support functions
 
-	// Release all nodes, sub-meshes and materials along with any DirectX data
-	void ReleaseResources();
-
 	// Creates a DirectX specific material from an imported material
 	bool CreateMaterialDX
 	(
@@ -184,6 +200,11 @@ private:
 		SSubMeshDX*     subMeshDX
 	);
 
+#endif // GEN_HEADLESS
+
+
+	// Release all nodes, sub-meshes and materials along with any DirectX data
+	void ReleaseResources();
 
 	// Pre-processing after loading
 	bool PreProcess();
@@ -203,11 +224,19 @@ private:
 	// Sub-meshes for mesh - each uses a single material
 	TUInt32          m_NumSubMeshes;
 	SSubMesh*        m_SubMeshes;    // Original sub-mesh data (dynamically allocated array)
+	CMeshCacheFile*  m_CacheFile;    // Cache file holding sub-mesh vertex / face data, 0 if the
+	                                 // mesh was imported from an X-File
+
+	// Materials read by Import, held until CreateResources creates the materials used to render
+	TUInt32          m_NumImportedMaterials;
+	SMeshMaterial*   m_ImportedMaterials;  // Dynamically allocated array
+#ifndef GEN_HEADLESS
 	SSubMeshDX*      m_SubMeshesDX;  // DirectX sub-mesh data (vertex / index buffers)
 
 	// Materials used in mesh
 	TUInt32          m_NumMaterials;
 	SMeshMaterialDX* m_Materials;    // Dynamically allocated array
+#endif
 
 	// Mesh bounding volume - minimum and maximum x,y & z values stored in two vectors
 	CVector3         m_MinBounds;
@@ -0,0 +1,412 @@
+/*******************************************
+	MeshCache.cpp
+
+	Binary mesh cache - a file format holding
+	a mesh ready for use, written offline from
+	an X-File and memory mapped when loading
+********************************************/
+
+#include <string.h>
+#include <fstream>
+#include <vector>
+#include "MeshCache.h"
+
+namespace gen
+{
+
+// Identifier at the start of every mesh cache file
+static const TUInt8 kMeshCacheID[4] = { 'G', 'M', 'S', 'H' };
+
+// Alignment of vertex data in the file, suits any vertex component type (and SIMD loads)
+static const TUInt32 kMeshCacheDataAlign = 16;
+
+
+/////////////////////////////////////
+// Functions
+
+// Return the name of the cache file for the given mesh file (the extension is replaced)
+string MeshCacheFileName( const string& meshFileName )
+{
+	string::size_type dot = meshFileName.find_last_of( '.' );
+	string::size_type separator = meshFileName.find_last_of( "/\\" );
+	if (dot == string::npos || (separator != string::npos && dot < separator))
+	{
+		return meshFileName + ksMeshCacheExtension;
+	}
+	return meshFileName.substr( 0, dot ) + ksMeshCacheExtension;
+}
+
+
+// Helpers for SaveMeshCache - append data to the file being built and return its offset
+static TUInt32 AppendData( vector<TUInt8>& file, const void* data, TUInt32 size, TUInt32 align )
+{
+	file.resize( (file.size() + align - 1) / align * align );
+	TUInt32 offset = static_cast<TUInt32>(file.size());
+	file.insert( file.end(), static_cast<const TUInt8*>(data), static_cast<const TUInt8*>(data) + size );
+	return offset;
+}
+
+// Write a mesh cache file from a mesh's data - its node hierarchy, materials, sub-meshes (with
+// vertex data already split and tangents calculated as required) and bounds. Returns true on success
+bool SaveMeshCache
+(
+	const string&        fileName,
+	const SMeshNode*     nodes,
+	TUInt32              numNodes,
+	const SMeshMaterial* materials,
+	TUInt32              numMaterials,
+	const SSubMesh*      subMeshes,
+	TUInt32              numSubMeshes,
+	const CVector3&      minBounds,
+	const CVector3&      maxBounds,
+	TFloat32             boundingRadius
+)
+{
+	typedef CMeshCacheFile::SFileHeader   SFileHeader;
+	typedef CMeshCacheFile::SFileNode     SFileNode;
+	typedef CMeshCacheFile::SFileMaterial SFileMaterial;
+	typedef CMeshCacheFile::SFileSubMesh  SFileSubMesh;
+
+	// Records are filled in first, then the data and strings they refer to are appended after them
+	TUInt32 recordsSize = sizeof(SFileHeader) + numNodes * sizeof(SFileNode) +
+	                      numMaterials * sizeof(SFileMaterial) + numSubMeshes * sizeof(SFileSubMesh);
+	vector<TUInt8> file( recordsSize, 0 );
+
+	// Sub-mesh vertex and face data
+	vector<SFileSubMesh> fileSubMeshes( numSubMeshes );
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		const SSubMesh& source = subMeshes[subMesh];
+		SFileSubMesh& dest = fileSubMeshes[subMesh];
+		dest.node = source.node;
+		dest.material = source.material;
+		dest.flags = (source.hasSkinningData  ? CMeshCacheFile::SubMesh_SkinningData  : 0) |
+		             (source.hasNormals       ? CMeshCacheFile::SubMesh_Normals       : 0) |
+		             (source.hasTangents      ? CMeshCacheFile::SubMesh_Tangents      : 0) |
+		             (source.hasTextureCoords ? CMeshCacheFile::SubMesh_TextureCoords : 0) |
+		             (source.hasVertexColours ? CMeshCacheFile::SubMesh_VertexColours : 0);
+		if (source.vertexSize != CMeshCacheFile::VertexSize( dest.flags ))
+		{
+			return false; // Vertex layout not understood by the loader
+		}
+		dest.numVertices = source.numVertices;
+		dest.vertexSize = source.vertexSize;
+		dest.verticesOffset = AppendData( file, source.vertices, source.numVertices * source.vertexSize,
+		                                  kMeshCacheDataAlign );
+		dest.numFaces = source.numFaces;
+		dest.facesOffset = AppendData( file, source.faces, source.numFaces * sizeof(SMeshFace),
+		                               kMeshCacheDataAlign );
+	}
+
+	// Nodes and their names
+	vector<SFileNode> fileNodes( numNodes );
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		const SMeshNode& source = nodes[node];
+		SFileNode& dest = fileNodes[node];
+		dest.name.length = static_cast<TUInt32>(source.name.length());
+		dest.name.offset = AppendData( file, source.name.data(), dest.name.length, 1 );
+		dest.depth = source.depth;
+		dest.parent = source.parent;
+		dest.numChildren = source.numChildren;
+		memcpy( dest.positionMatrix, &source.positionMatrix.e00, sizeof(dest.positionMatrix) );
+		memcpy( dest.invMeshOffset, &source.invMeshOffset.e00, sizeof(dest.invMeshOffset) );
+	}
+
+	// Materials and texture names
+	vector<SFileMaterial> fileMaterials( numMaterials );
+	for (TUInt32 material = 0; material < numMaterials; ++material)
+	{
+		const SMeshMaterial& source = materials[material];
+		SFileMaterial& dest = fileMaterials[material];
+		memset( &dest, 0, sizeof(dest) );
+		dest.renderMethod = source.renderMethod;
+		dest.diffuseColour[0] = source.diffuseColour.r;
+		dest.diffuseColour[1] = source.diffuseColour.g;
+		dest.diffuseColour[2] = source.diffuseColour.b;
+		dest.diffuseColour[3] = source.diffuseColour.a;
+		dest.specularColour[0] = source.specularColour.r;
+		dest.specularColour[1] = source.specularColour.g;
+		dest.specularColour[2] = source.specularColour.b;
+		dest.specularColour[3] = source.specularColour.a;
+		dest.specularPower = source.specularPower;
+		dest.numTextures = source.numTextures;
+		for (TUInt32 texture = 0; texture < source.numTextures && texture < kiMaxTextures; ++texture)
+		{
+			const string& name = source.textureFileNames[texture];
+			dest.textureFileNames[texture].length = static_cast<TUInt32>(name.length());
+			dest.textureFileNames[texture].offset = AppendData( file, name.data(),
+			                                                    static_cast<TUInt32>(name.length()), 1 );
+		}
+	}
+
+	// Header
+	SFileHeader header;
+	memcpy( header.id, kMeshCacheID, sizeof(header.id) );
+	header.version = kiMeshCacheVersion;
+	header.fileSize = static_cast<TUInt32>(file.size());
+	header.numNodes = numNodes;
+	header.numMaterials = numMaterials;
+	header.numSubMeshes = numSubMeshes;
+	header.minBounds[0] = minBounds.x;
+	header.minBounds[1] = minBounds.y;
+	header.minBounds[2] = minBounds.z;
+	header.maxBounds[0] = maxBounds.x;
+	header.maxBounds[1] = maxBounds.y;
+	header.maxBounds[2] = maxBounds.z;
+	header.boundingRadius = boundingRadius;
+
+	// Copy records to the start of the file
+	TUInt8* records = &file[0];
+	memcpy( records, &header, sizeof(header) );
+	records += sizeof(header);
+	if (numNodes > 0)
+	{
+		memcpy( records, &fileNodes[0], numNodes * sizeof(SFileNode) );
+		records += numNodes * sizeof(SFileNode);
+	}
+	if (numMaterials > 0)
+	{
+		memcpy( records, &fileMaterials[0], numMaterials * sizeof(SFileMaterial) );
+		records += numMaterials * sizeof(SFileMaterial);
+	}
+	if (numSubMeshes > 0)
+	{
+		memcpy( records, &fileSubMeshes[0], numSubMeshes * sizeof(SFileSubMesh) );
+	}
+
+	ofstream output( fileName.c_str(), ios::out | ios::binary | ios::trunc );
+	if (!output)
+	{
+		return false;
+	}
+	output.write( reinterpret_cast<const char*>(&file[0]), file.size() );
+	return !output.fail();
+}
+
+
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Constructor - no file open
+CMeshCacheFile::CMeshCacheFile()
+{
+	m_Data = 0;
+	m_Size = 0;
+}
+
+// Destructor closes any open file
+CMeshCacheFile::~CMeshCacheFile()
+{
+	Close();
+}
+
+
+/////////////////////////////////////
+// File access
+
+// Open a cache file and check that it is complete, consistent and of the current version.
+// If a source file name is given, the cache is also rejected if the source file is newer (the
+// cache is out of date). Returns true if the file can be used
+bool CMeshCacheFile::Open( const string& fileName, const string& sourceFileName /*= ""*/ )
+{
+	Close();
+
+	// Check cache is newer than its source (if the source is present)
+	TUInt64 cacheTime, sourceTime;
+	if (!GetFileModifiedTime( fileName, &cacheTime ))
+	{
+		return false;
+	}
+	if (!sourceFileName.empty() && GetFileModifiedTime( sourceFileName, &sourceTime ) &&
+	    sourceTime > cacheTime)
+	{
+		return false;
+	}
+
+	m_Data = static_cast<const TUInt8*>(MapFile( fileName, &m_Size ));
+	if (!m_Data)
+	{
+		return false;
+	}
+
+	// Check header and that all records, data and strings lie in the file
+	const SFileHeader* header = Header();
+	if (m_Size < sizeof(SFileHeader) || memcmp( header->id, kMeshCacheID, sizeof(header->id) ) != 0 ||
+	    header->version != kiMeshCacheVersion || header->fileSize != m_Size ||
+	    header->numNodes == 0 || header->numSubMeshes == 0 ||
+	    !InFile( sizeof(SFileHeader), static_cast<TUInt64>(header->numNodes) * sizeof(SFileNode) +
+	                                  static_cast<TUInt64>(header->numMaterials) * sizeof(SFileMaterial) +
+	                                  static_cast<TUInt64>(header->numSubMeshes) * sizeof(SFileSubMesh) ))
+	{
+		Close();
+		return false;
+	}
+	for (TUInt32 node = 0; node < header->numNodes; ++node)
+	{
+		const SFileNode& fileNode = Nodes()[node];
+		if (!InFile( fileNode.name.offset, fileNode.name.length ) || fileNode.parent >= header->numNodes)
+		{
+			Close();
+			return false;
+		}
+	}
+	for (TUInt32 material = 0; material < header->numMaterials; ++material)
+	{
+		const SFileMaterial& fileMaterial = Materials()[material];
+		if (fileMaterial.renderMethod >= NumRenderMethods || fileMaterial.numTextures > kiMaxTextures)
+		{
+			Close();
+			return false;
+		}
+		for (TUInt32 texture = 0; texture < fileMaterial.numTextures; ++texture)
+		{
+			if (!InFile( fileMaterial.textureFileNames[texture].offset,
+			             fileMaterial.textureFileNames[texture].length ))
+			{
+				Close();
+				return false;
+			}
+		}
+	}
+	for (TUInt32 subMesh = 0; subMesh < header->numSubMeshes; ++subMesh)
+	{
+		const SFileSubMesh& fileSubMesh = SubMeshes()[subMesh];
+		if (fileSubMesh.node >= header->numNodes || fileSubMesh.material >= header->numMaterials ||
+		    fileSubMesh.vertexSize != VertexSize( fileSubMesh.flags ) ||
+		    fileSubMesh.numVertices == 0 || fileSubMesh.verticesOffset % kMeshCacheDataAlign != 0 ||
+		    !InFile( fileSubMesh.verticesOffset,
+		             static_cast<TUInt64>(fileSubMesh.numVertices) * fileSubMesh.vertexSize ) ||
+		    fileSubMesh.facesOffset % sizeof(TUInt16) != 0 ||
+		    !InFile( fileSubMesh.facesOffset, static_cast<TUInt64>(fileSubMesh.numFaces) * sizeof(SMeshFace) ))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Close the file - sub-mesh data returned by GetSubMesh is no longer valid
+void CMeshCacheFile::Close()
+{
+	if (m_Data)
+	{
+		UnmapFile( m_Data, m_Size );
+		m_Data = 0;
+		m_Size = 0;
+	}
+}
+
+
+/////////////////////////////////////
+// Data access
+
+// Get number of nodes in the mesh hierarchy
+TUInt32 CMeshCacheFile::GetNumNodes()
+{
+	return Header()->numNodes;
+}
+
+// Get a single node from the mesh hierarchy, returned through a pointer
+void CMeshCacheFile::GetNode( TUInt32 node, SMeshNode* meshNode )
+{
+	const SFileNode& fileNode = Nodes()[node];
+	meshNode->name = GetString( fileNode.name );
+	meshNode->depth = fileNode.depth;
+	meshNode->parent = fileNode.parent;
+	meshNode->numChildren = fileNode.numChildren;
+	memcpy( &meshNode->positionMatrix.e00, fileNode.positionMatrix, sizeof(fileNode.positionMatrix) );
+	memcpy( &meshNode->invMeshOffset.e00, fileNode.invMeshOffset, sizeof(fileNode.invMeshOffset) );
+}
+
+// Get number of materials used in the mesh
+TUInt32 CMeshCacheFile::GetNumMaterials()
+{
+	return Header()->numMaterials;
+}
+
+// Get specification of a given material, returned through a pointer
+void CMeshCacheFile::GetMaterial( TUInt32 material, SMeshMaterial* meshMaterial )
+{
+	const SFileMaterial& fileMaterial = Materials()[material];
+	meshMaterial->renderMethod = static_cast<ERenderMethod>(fileMaterial.renderMethod);
+	meshMaterial->diffuseColour = SColourRGBA( fileMaterial.diffuseColour[0], fileMaterial.diffuseColour[1],
+	                                           fileMaterial.diffuseColour[2], fileMaterial.diffuseColour[3] );
+	meshMaterial->specularColour = SColourRGBA( fileMaterial.specularColour[0], fileMaterial.specularColour[1],
+	                                            fileMaterial.specularColour[2], fileMaterial.specularColour[3] );
+	meshMaterial->specularPower = fileMaterial.specularPower;
+	meshMaterial->numTextures = fileMaterial.numTextures;
+	for (TUInt32 texture = 0; texture < fileMaterial.numTextures; ++texture)
+	{
+		meshMaterial->textureFileNames[texture] = GetString( fileMaterial.textureFileNames[texture] );
+	}
+}
+
+// Get number of sub-meshes in the mesh
+TUInt32 CMeshCacheFile::GetNumSubMeshes()
+{
+	return Header()->numSubMeshes;
+}
+
+// Get the specification and data for given sub-mesh, returned through a pointer. The vertex
+// and face pointers point into the mapped file - they must not be written to or deleted and
+// are only valid until the file is closed
+void CMeshCacheFile::GetSubMesh( TUInt32 subMesh, SSubMesh* meshSubMesh )
+{
+	const SFileSubMesh& fileSubMesh = SubMeshes()[subMesh];
+	meshSubMesh->node = fileSubMesh.node;
+	meshSubMesh->material = fileSubMesh.material;
+	meshSubMesh->numVertices = fileSubMesh.numVertices;
+	meshSubMesh->vertices = const_cast<TUInt8*>(m_Data + fileSubMesh.verticesOffset);
+	meshSubMesh->vertexSize = fileSubMesh.vertexSize;
+	meshSubMesh->hasSkinningData = (fileSubMesh.flags & SubMesh_SkinningData) != 0;
+	meshSubMesh->hasNormals = (fileSubMesh.flags & SubMesh_Normals) != 0;
+	meshSubMesh->hasTangents = (fileSubMesh.flags & SubMesh_Tangents) != 0;
+	meshSubMesh->hasTextureCoords = (fileSubMesh.flags & SubMesh_TextureCoords) != 0;
+	meshSubMesh->hasVertexColours = (fileSubMesh.flags & SubMesh_VertexColours) != 0;
+	meshSubMesh->numFaces = fileSubMesh.numFaces;
+	meshSubMesh->faces = reinterpret_cast<SMeshFace*>(const_cast<TUInt8*>(m_Data + fileSubMesh.facesOffset));
+}
+
+// Get the mesh bounds and bounding radius, returned through pointers
+void CMeshCacheFile::GetBounds( CVector3* minBounds, CVector3* maxBounds, TFloat32* boundingRadius )
+{
+	const SFileHeader* header = Header();
+	minBounds->Set( header->minBounds[0], header->minBounds[1], header->minBounds[2] );
+	maxBounds->Set( header->maxBounds[0], header->maxBounds[1], header->maxBounds[2] );
+	*boundingRadius = header->boundingRadius;
+}
+
+
+/////////////////////////////////////
+// Private functions
+
+// Return the size of a vertex with the components in the given sub-mesh flags. Matches the
+// vertex layout built by CMesh::CreateSubMeshDX
+TUInt32 CMeshCacheFile::VertexSize( TUInt32 flags )
+{
+	TUInt32 size = 12; // Position
+	if (flags & SubMesh_SkinningData)  size += 20; // Blend weights and indices
+	if (flags & SubMesh_Normals)       size += 12;
+	if (flags & SubMesh_Tangents)      size += 12;
+	if (flags & SubMesh_TextureCoords) size += 8;
+	if (flags & SubMesh_VertexColours) size += 4;
+	return size;
+}
+
+// Return true if the given range lies within the open file
+bool CMeshCacheFile::InFile( TUInt32 offset, TUInt64 size )
+{
+	return offset <= m_Size && size <= m_Size - offset;
+}
+
+// Return a string from the file
+string CMeshCacheFile::GetString( const SFileString& fileString )
+{
+	return string( reinterpret_cast<const char*>(m_Data + fileString.offset), fileString.length );
+}
+
+
+} // namespace gen
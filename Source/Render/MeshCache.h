@@ -0,0 +1,240 @@
+/*******************************************
+	MeshCache.h
+
+	Binary mesh cache - a file format holding
+	a mesh ready for use, written offline from
+	an X-File and memory mapped when loading
+********************************************/
+
+#pragma once
+
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "MeshData.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+//	Constants
+
+// Extension of mesh cache files, which are stored beside their X-File (e.g. HoverTank01.mesh)
+const string ksMeshCacheExtension = ".mesh";
+
+// Version of the mesh cache format. Must be increased whenever the file layout or the sub-mesh
+// vertex layout changes, so existing cache files are rejected rather than misread
+const TUInt32 kiMeshCacheVersion = 1;
+
+
+/////////////////////////////////////
+//	Functions
+
+// Return the name of the cache file for the given mesh file (the extension is replaced)
+string MeshCacheFileName( const string& meshFileName );
+
+// Write a mesh cache file from a mesh's data - its node hierarchy, materials, sub-meshes (with
+// vertex data already split and tangents calculated as required) and bounds. Returns true on success
+bool SaveMeshCache
+(
+	const string&        fileName,
+	const SMeshNode*     nodes,
+	TUInt32              numNodes,
+	const SMeshMaterial* materials,
+	TUInt32              numMaterials,
+	const SSubMesh*      subMeshes,
+	TUInt32              numSubMeshes,
+	const CVector3&      minBounds,
+	const CVector3&      maxBounds,
+	TFloat32             boundingRadius
+);
+
+
+/////////////////////////////////////
+//	Mesh cache file
+
+// A mesh cache file opened for reading. The file is memory mapped and checked when opened, then
+// its contents are read through an interface matching CImportXFile. Sub-mesh vertex and face data
+// is not copied - it points directly into the mapped file, so it can be passed straight to the
+// graphics API. The file is laid out as:
+// - A header holding the format version, counts and bounds
+// - Fixed size records for each node, material and sub-mesh
+// - Vertex and face data for each sub-mesh (16-byte aligned), then the strings for names
+// Offsets in the records are from the start of the file. Values are stored in the byte order of
+// the machine that wrote the file (all supported platforms are little-endian)
+class CMeshCacheFile
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Constructor - no file open
+	CMeshCacheFile();
+
+	// Destructor closes any open file
+	~CMeshCacheFile();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CMeshCacheFile( const CMeshCacheFile& );
+	CMeshCacheFile& operator=( const CMeshCacheFile& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// File access
+
+	// Open a cache file and check that it is complete, consistent and of the current version.
+	// If a source file name is given, the cache is also rejected if the source file is newer (the
+	// cache is out of date). Returns true if the file can be used
+	bool Open( const string& fileName, const string& sourceFileName = "" );
+
+	// Close the file - sub-mesh data returned by GetSubMesh is no longer valid
+	void Close();
+
+	// Return true if a file is open
+	bool IsOpen()
+	{
+		return m_Data != 0;
+	}
+
+
+	/////////////////////////////////////
+	// Data access (file must be open)
+
+	// Get number of nodes in the mesh hierarchy
+	TUInt32 GetNumNodes();
+
+	// Get a single node from the mesh hierarchy, returned through a pointer
+	void GetNode( TUInt32 node, SMeshNode* meshNode );
+
+	// Get number of materials used in the mesh
+	TUInt32 GetNumMaterials();
+
+	// Get specification of a given material, returned through a pointer
+	void GetMaterial( TUInt32 material, SMeshMaterial* meshMaterial );
+
+	// Get number of sub-meshes in the mesh
+	TUInt32 GetNumSubMeshes();
+
+	// Get the specification and data for given sub-mesh, returned through a pointer. The vertex
+	// and face pointers point into the mapped file - they must not be written to or deleted and
+	// are only valid until the file is closed
+	void GetSubMesh( TUInt32 subMesh, SSubMesh* meshSubMesh );
+
+	// Get the mesh bounds and bounding radius, returned through pointers
+	void GetBounds( CVector3* minBounds, CVector3* maxBounds, TFloat32* boundingRadius );
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// File records - only fixed size types so the layout is the same for all compilers
+
+	// A string in the file, characters are not null terminated
+	struct SFileString
+	{
+		TUInt32 offset;
+		TUInt32 length;
+	};
+
+	struct SFileHeader
+	{
+		TUInt8   id[4];   // "GMSH"
+		TUInt32  version; // kiMeshCacheVersion
+		TUInt32  fileSize;
+		TUInt32  numNodes;
+		TUInt32  numMaterials;
+		TUInt32  numSubMeshes;
+		TFloat32 minBounds[3];
+		TFloat32 maxBounds[3];
+		TFloat32 boundingRadius;
+	};
+
+	struct SFileNode
+	{
+		SFileString name;
+		TUInt32     depth;
+		TUInt32     parent;
+		TUInt32     numChildren;
+		TFloat32    positionMatrix[16];
+		TFloat32    invMeshOffset[16];
+	};
+
+	struct SFileMaterial
+	{
+		TUInt32     renderMethod;
+		TFloat32    diffuseColour[4];
+		TFloat32    specularColour[4];
+		TFloat32    specularPower;
+		TUInt32     numTextures;
+		SFileString textureFileNames[kiMaxTextures];
+	};
+
+	// Vertex component flags for a sub-mesh
+	enum ESubMeshFlags
+	{
+		SubMesh_SkinningData  = 1,
+		SubMesh_Normals       = 2,
+		SubMesh_Tangents      = 4,
+		SubMesh_TextureCoords = 8,
+		SubMesh_VertexColours = 16,
+	};
+
+	struct SFileSubMesh
+	{
+		TUInt32 node;
+		TUInt32 material;
+		TUInt32 flags; // ESubMeshFlags
+		TUInt32 numVertices;
+		TUInt32 vertexSize;
+		TUInt32 verticesOffset;
+		TUInt32 numFaces;
+		TUInt32 facesOffset;
+	};
+
+	// Return the size of a vertex with the components in the given sub-mesh flags
+	static TUInt32 VertexSize( TUInt32 flags );
+
+	// Return true if the given range lies within the open file
+	bool InFile( TUInt32 offset, TUInt64 size );
+
+	// Return a string from the file
+	string GetString( const SFileString& fileString );
+
+	// Return pointers to the header and record arrays
+	const SFileHeader* Header()
+	{
+		return reinterpret_cast<const SFileHeader*>(m_Data);
+	}
+	const SFileNode* Nodes()
+	{
+		return reinterpret_cast<const SFileNode*>(m_Data + sizeof(SFileHeader));
+	}
+	const SFileMaterial* Materials()
+	{
+		return reinterpret_cast<const SFileMaterial*>(Nodes() + Header()->numNodes);
+	}
+	const SFileSubMesh* SubMeshes()
+	{
+		return reinterpret_cast<const SFileSubMesh*>(Materials() + Header()->numMaterials);
+	}
+
+	// SaveMeshCache writes the records
+	friend bool SaveMeshCache( const string&, const SMeshNode*, TUInt32, const SMeshMaterial*,
+	                           TUInt32, const SSubMesh*, TUInt32, const CVector3&, const CVector3&,
+	                           TFloat32 );
+
+
+	// Mapped file contents and size
+	const TUInt8* m_Data;
+	TUInt32       m_Size;
+};
+
+
+} // namespace gen
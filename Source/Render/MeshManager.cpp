@@ -0,0 +1,235 @@
+/*******************************************
+	MeshManager.cpp
+
+	Mesh manager - shares loaded meshes
+	between their users, so each mesh file
+	is only loaded once
+********************************************/
+
+#include <string.h>
+
+#include "MeshManager.h"
+
+namespace gen
+{
+
+// Folder for all mesh files
+extern const string MediaFolder;
+
+
+/////////////////////////////////////
+//	Constructors/Destructors
+
+// Destructor deletes any meshes not yet released
+CMeshManager::~CMeshManager()
+{
+	while (!m_Meshes.empty())
+	{
+		DeleteMesh( m_Meshes.begin()->second );
+	}
+}
+
+
+/////////////////////////////////////
+//	Public interface
+
+// Return the mesh for the given file (in the media folder, as CMesh::Load), loading it if it
+// is not already loaded, and add a user to it. Returns 0 if the mesh cannot be loaded.
+// Release the mesh with ReleaseMesh when finished with it
+CMesh* CMeshManager::AcquireMesh( const string& fileName )
+{
+	bool isNew;
+	SSharedMesh* sharedMesh = AddMeshUser( fileName, &isNew );
+	if (!sharedMesh)
+	{
+		return 0;
+	}
+	if (isNew && !sharedMesh->mesh->Load( fileName ))
+	{
+		DeleteMesh( sharedMesh );
+		return 0;
+	}
+	return sharedMesh->mesh;
+}
+
+// Return the meshes for a list of files, as AcquireMesh called for each file in turn. Meshes
+// not already loaded are imported in parallel on the threads of the given job system, then
+// their DirectX resources are created on the calling thread. Returns false if any mesh cannot
+// be loaded, in which case no meshes are returned and no users are added
+bool CMeshManager::AcquireMeshes( const vector<string>& fileNames, vector<CMesh*>* meshes,
+                                  CJobSystem& jobSystem )
+{
+	// Find or add the shared mesh for each file. A file requested more than once in the list, or
+	// with the same contents as an earlier one, finds the mesh added for the earlier file
+	meshes->clear();
+	vector<SSharedMesh*> newMeshes;
+	vector<const string*> newFileNames;
+	bool success = true;
+	for (TUInt32 file = 0; file < fileNames.size(); ++file)
+	{
+		bool isNew;
+		SSharedMesh* sharedMesh = AddMeshUser( fileNames[file], &isNew );
+		if (!sharedMesh)
+		{
+			success = false;
+			break;
+		}
+		meshes->push_back( sharedMesh->mesh );
+		if (isNew)
+		{
+			newMeshes.push_back( sharedMesh );
+			newFileNames.push_back( &fileNames[file] );
+		}
+	}
+
+	// Import the new meshes in parallel, one mesh per job as meshes vary greatly in size. Each
+	// result has its own byte (not a vector<bool>) so jobs do not write to the same memory
+	TUInt32 numNewMeshes = static_cast<TUInt32>(newMeshes.size());
+	vector<TUInt8> imported( numNewMeshes, 0 );
+	if (success)
+	{
+		jobSystem.ParallelFor( numNewMeshes, 1, [&]( TUInt32 begin, TUInt32 end )
+		{
+			for (TUInt32 newMesh = begin; newMesh < end; ++newMesh)
+			{
+				imported[newMesh] = newMeshes[newMesh]->mesh->Import( *newFileNames[newMesh] );
+			}
+		} );
+	}
+
+	// Create DirectX resources on this thread
+	for (TUInt32 newMesh = 0; newMesh < numNewMeshes && success; ++newMesh)
+	{
+		success = imported[newMesh] && newMeshes[newMesh]->mesh->CreateResources();
+	}
+
+	// On failure remove the users added above, which deletes the new meshes
+	if (!success)
+	{
+		for (TUInt32 mesh = 0; mesh < meshes->size(); ++mesh)
+		{
+			ReleaseMesh( (*meshes)[mesh] );
+		}
+		meshes->clear();
+	}
+	return success;
+}
+
+// Remove a user from a mesh returned by AcquireMesh, deleting it if there are no other users
+void CMeshManager::ReleaseMesh( CMesh* mesh )
+{
+	TMeshIter sharedMesh = m_Meshes.find( mesh );
+	if (sharedMesh == m_Meshes.end())
+	{
+		return;
+	}
+	if (--sharedMesh->second->numUsers == 0)
+	{
+		DeleteMesh( sharedMesh->second );
+	}
+}
+
+
+/////////////////////////////////////
+//	Private interface
+
+// Find the shared mesh for the given file and add a user to it. If the file has not been
+// loaded then a new shared mesh is added with an empty mesh, which the caller must load.
+// Returns 0 if the file does not exist
+CMeshManager::SSharedMesh* CMeshManager::AddMeshUser( const string& fileName, bool* isNew )
+{
+	*isNew = false;
+	string canonicalName;
+	if (!GetCanonicalFileName( MediaFolder + fileName, &canonicalName ))
+	{
+		return 0;
+	}
+
+	// Use the mesh already loaded from this file if there is one
+	TMeshNameIter meshName = m_MeshNames.find( canonicalName );
+	if (meshName != m_MeshNames.end())
+	{
+		++meshName->second->numUsers;
+		return meshName->second;
+	}
+
+	// Otherwise use a mesh loaded from another file with the same contents. Mapping the file
+	// does not read it, only files with the same size as a loaded one are actually compared
+	TUInt32 fileSize;
+	const void* fileData = MapFile( canonicalName, &fileSize );
+	if (!fileData)
+	{
+		return 0;
+	}
+	SSharedMesh* sharedMesh = FindSameContents( fileData, fileSize );
+	UnmapFile( fileData, fileSize );
+	if (sharedMesh)
+	{
+		// Remember this name for the mesh too, so the contents are only compared once
+		sharedMesh->fileNames.push_back( canonicalName );
+		m_MeshNames[canonicalName] = sharedMesh;
+		++sharedMesh->numUsers;
+		return sharedMesh;
+	}
+
+	// New mesh
+	sharedMesh = new SSharedMesh;
+	sharedMesh->mesh = new CMesh();
+	sharedMesh->numUsers = 1;
+	sharedMesh->fileSize = fileSize;
+	sharedMesh->fileNames.push_back( canonicalName );
+	m_Meshes[sharedMesh->mesh] = sharedMesh;
+	m_MeshNames[canonicalName] = sharedMesh;
+	m_MeshSizes.insert( TMeshSizes::value_type( fileSize, sharedMesh ) );
+	*isNew = true;
+	return sharedMesh;
+}
+
+// Return a loaded mesh whose file has exactly the given contents, or 0 if there is none
+CMeshManager::SSharedMesh* CMeshManager::FindSameContents( const void* fileData, TUInt32 fileSize )
+{
+	pair<TMeshSizeIter, TMeshSizeIter> sameSize = m_MeshSizes.equal_range( fileSize );
+	for (TMeshSizeIter meshSize = sameSize.first; meshSize != sameSize.second; ++meshSize)
+	{
+		// Compare with the file the mesh was loaded from
+		SSharedMesh* sharedMesh = meshSize->second;
+		TUInt32 otherSize;
+		const void* otherData = MapFile( sharedMesh->fileNames[0], &otherSize );
+		if (!otherData)
+		{
+			continue;
+		}
+		bool same = (otherSize == fileSize && memcmp( otherData, fileData, fileSize ) == 0);
+		UnmapFile( otherData, otherSize );
+		if (same)
+		{
+			return sharedMesh;
+		}
+	}
+	return 0;
+}
+
+// Remove a shared mesh from the maps and delete it
+void CMeshManager::DeleteMesh( SSharedMesh* sharedMesh )
+{
+	for (TUInt32 name = 0; name < sharedMesh->fileNames.size(); ++name)
+	{
+		m_MeshNames.erase( sharedMesh->fileNames[name] );
+	}
+	pair<TMeshSizeIter, TMeshSizeIter> sameSize = m_MeshSizes.equal_range( sharedMesh->fileSize );
+	for (TMeshSizeIter meshSize = sameSize.first; meshSize != sameSize.second; ++meshSize)
+	{
+		if (meshSize->second == sharedMesh)
+		{
+			m_MeshSizes.erase( meshSize );
+			break;
+		}
+	}
+	m_Meshes.erase( sharedMesh->mesh );
+
+	delete sharedMesh->mesh;
+	delete sharedMesh;
+}
+
+
+} // namespace gen
@@ -0,0 +1,114 @@
+/*******************************************
+	MeshManager.h
+
+	Mesh manager - shares loaded meshes
+	between their users, so each mesh file
+	is only loaded once
+********************************************/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "CJobSystem.h"
+#include "Mesh.h"
+
+namespace gen
+{
+
+// The mesh manager holds each loaded mesh with a count of its users (e.g. entity templates).
+// Meshes are requested by file name and shared with any earlier user of the same file, found by
+// its canonical name, so different names for the same file (e.g. "Tank.x" and "./tank.x" on
+// Windows) give one mesh. Files with different names but identical contents are also shared -
+// a new file is compared byte for byte with each loaded file of the same size. A mesh is deleted
+// when its last user releases it.
+// Meshes are not to be changed by their users, as any change would be seen by the others
+class CMeshManager
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Constructor - no meshes loaded
+	CMeshManager() {}
+
+	// Destructor deletes any meshes not yet released
+	~CMeshManager();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CMeshManager( const CMeshManager& );
+	CMeshManager& operator=( const CMeshManager& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Return the mesh for the given file (in the media folder, as CMesh::Load), loading it if it
+	// is not already loaded, and add a user to it. Returns 0 if the mesh cannot be loaded.
+	// Release the mesh with ReleaseMesh when finished with it
+	CMesh* AcquireMesh( const string& fileName );
+
+	// Return the meshes for a list of files, as AcquireMesh called for each file in turn. Meshes
+	// not already loaded are imported in parallel on the threads of the given job system, then
+	// their DirectX resources are created on the calling thread. Returns false if any mesh cannot
+	// be loaded, in which case no meshes are returned and no users are added
+	bool AcquireMeshes( const vector<string>& fileNames, vector<CMesh*>* meshes,
+	                    CJobSystem& jobSystem );
+
+	// Remove a user from a mesh returned by AcquireMesh, deleting it if there are no other users
+	void ReleaseMesh( CMesh* mesh );
+
+	// Return the number of meshes currently loaded
+	TUInt32 NumMeshes()
+	{
+		return static_cast<TUInt32>(m_Meshes.size());
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// A loaded mesh, its number of users, and the canonical names of the files it has been
+	// requested with. The first name is the file it was loaded from
+	struct SSharedMesh
+	{
+		CMesh*         mesh;
+		TUInt32        numUsers;
+		TUInt32        fileSize;
+		vector<string> fileNames;
+	};
+
+	// Shared meshes are held in maps, define some types for convenience
+	typedef map<CMesh*, SSharedMesh*> TMeshes;
+	typedef TMeshes::iterator TMeshIter;
+	typedef map<string, SSharedMesh*> TMeshNames;
+	typedef TMeshNames::iterator TMeshNameIter;
+	typedef multimap<TUInt32, SSharedMesh*> TMeshSizes;
+	typedef TMeshSizes::iterator TMeshSizeIter;
+
+	// Find the shared mesh for the given file and add a user to it. If the file has not been
+	// loaded then a new shared mesh is added with an empty mesh, which the caller must load.
+	// Returns 0 if the file does not exist
+	SSharedMesh* AddMeshUser( const string& fileName, bool* isNew );
+
+	// Return a loaded mesh whose file has exactly the given contents, or 0 if there is none
+	SSharedMesh* FindSameContents( const void* fileData, TUInt32 fileSize );
+
+	// Remove a shared mesh from the maps and delete it
+	void DeleteMesh( SSharedMesh* sharedMesh );
+
+
+	// Shared meshes indexed by mesh pointer, by each canonical file name and by file size
+	TMeshes    m_Meshes;
+	TMeshNames m_MeshNames;
+	TMeshSizes m_MeshSizes;
+};
+
+
+} // namespace gen
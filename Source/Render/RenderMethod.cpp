@@ -6,7 +6,9 @@
 ****************************************************************************************/
 
 #include "RenderMethod.h"
+#ifndef GEN_HEADLESS
 #include "MathDX.h"
+#endif
 
 namespace gen
 {
@@ -17,6 +19,8 @@ namespace gen
 // Render Method Specifications
 //-----------------------------------------------------------------------------
 
+#ifndef GEN_HEADLESS
+
 // Prototypes for shader initialisation functions in array below
 // The functions are defined using a function pointer type (PShaderFn in RenderMethod.h)
 // These functions must all have the same style of prototype as shown above
@@ -45,6 +49,28 @@ SRenderMethod RenderMethods[NumRenderMethods] =
 	"CutoutPixelLitTex", RM_TransformTexMaterial, 1,         false,      0,                // CutoutPixelLitTex
 };
 
+#else // GEN_HEADLESS
+
+// Headless builds have no shaders, only the usage information from the table above is kept (for
+// mesh import). Keep the two tables in step
+struct SRenderMethodInfo
+{
+	unsigned int numTextures;
+	bool         usesTangents;
+};
+
+SRenderMethodInfo RenderMethods[NumRenderMethods] =
+{
+//	|Num Tex|  |Tangents|   |Method Name|
+	{ 0,         false },   // PlainColour
+	{ 1,         false },   // PlainTexture
+	{ 0,         false },   // PixelLit
+	{ 1,         false },   // PixelLitTex
+	{ 1,         false },   // CutoutPixelLitTex
+};
+
+#endif // GEN_HEADLESS
+
 
 //-----------------------------------------------------------------------------
 // Select render method from artwork material information
@@ -102,6 +128,8 @@ bool RenderMethodUsesTangents( ERenderMethod method )
 	return RenderMethods[method].usesTangents;
 }
 
+#ifndef GEN_HEADLESS
+
 // Return the .fx file technique used by given render method
 ID3D10EffectTechnique* GetRenderMethodTechnique( ERenderMethod method )
 {
@@ -325,5 +353,7 @@ void RM_NormalMapping( D3DXCOLOR* diffuseColour, D3DXCOLOR* specularColour, floa
     NormalMapVar->SetResource( textures[1] );
 }
 
+#endif // GEN_HEADLESS
+
 
-} // namespace gen
\ No newline at end of file
+} // namespace gen
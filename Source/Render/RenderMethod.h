@@ -10,8 +10,11 @@
 #include <string>
 using namespace std;
 
+// Headless builds only need the render method list and usage information (for mesh import)
+#ifndef GEN_HEADLESS
 #include <d3d10.h>
 #include <d3dx10.h>
+#endif
 
 #include "Defines.h"
 #include "CMatrix4x4.h"
@@ -38,6 +41,8 @@ enum ERenderMethod
 };
 
 
+#ifndef GEN_HEADLESS
+
 // Pointer to a function to initialise a render method - typically sets shader constants
 typedef void (*PRenderMethodFn)(D3DXCOLOR* diffuseColour, D3DXCOLOR* specularColour, float specularPower, ID3D10ShaderResourceView** textures, CMatrix4x4* worldMatrix);
 
@@ -55,6 +60,8 @@ struct SRenderMethod
 	ID3D10EffectTechnique* technique;     // Pointer to actual technique
 };
 
+#endif // GEN_HEADLESS
+
 
 
 //-----------------------------------------------------------------------------
@@ -79,6 +86,8 @@ unsigned int NumTexturesUsedByRenderMethod( ERenderMethod method );
 // Return whether given render method uses tangents
 bool RenderMethodUsesTangents( ERenderMethod method );
 
+#ifndef GEN_HEADLESS
+
 // Return the .fx file technique used by given render method
 ID3D10EffectTechnique* GetRenderMethodTechnique( ERenderMethod method );
 
@@ -114,5 +123,7 @@ void SetLights( CLight** lights );
 // Set the camera to use for all methods
 void SetCamera( CCamera* camera );
 
+#endif // GEN_HEADLESS
+
 
-} // namespace gen
\ No newline at end of file
+} // namespace gen
@@ -11,8 +11,9 @@ namespace gen
 
 	CAmmoBoxEntity::CAmmoBoxEntity
 	(
-		CAmmoBoxTemplate* ammoTemplate, TEntityUID UID, const string& name, const CVector3& position, const CVector3& rotation, const CVector3& scale
-	) : CEntity(ammoTemplate, UID, name, position, rotation, scale)
+		CAmmoBoxTemplate* ammoTemplate, TEntityUID UID, const string& name, const CVector3& position, const CVector3& rotation, const CVector3& scale,
+		CMatrixArena* matrixArena, TUInt32 matrixSlot
+	) : CEntity(ammoTemplate, UID, name, position, rotation, scale, matrixArena, matrixSlot)
 	{
 		gravity = ammoTemplate->GetGravity(); // Sets the gravity for the ammo box
 	}
@@ -20,7 +21,7 @@ namespace gen
 	bool CAmmoBoxEntity::Update(TFloat32 updateTime)
 	{
 		// if not at ground level, fall to ground
-		if (Position().y > 2.0f)
+		if (GetPosition().y > 2.0f)
 		{
 			Matrix().MoveLocalY(gravity * updateTime);
 		}
@@ -16,8 +16,8 @@ namespace gen
 
 		CAmmoBoxTemplate
 		(
-			const string& type, const string& name, const string& meshFilename, TFloat32 gravity
-		) : CEntityTemplate(type, name, meshFilename)
+			const string& type, const string& name, CMesh* mesh, TFloat32 gravity
+		) : CEntityTemplate(type, name, mesh)
 		{
 			m_Gravity = gravity; // Sets the gravity which is the speed the ammo box should fall at
 		}
@@ -38,7 +38,9 @@ namespace gen
 			const string& name = "",
 			const CVector3& position = CVector3::kOrigin,
 			const CVector3& rotation = CVector3(0.0f, 0.0f, 0.0f),
-			const CVector3& scale = CVector3(.5f, .5f, .5f)
+			const CVector3& scale = CVector3(.5f, .5f, .5f),
+			CMatrixArena* matrixArena = 0,
+			TUInt32 matrixSlot = 0
 		);
 
 		virtual bool Update(TFloat32 updateTime);
@@ -5,8 +5,10 @@
 	Camera class implementation
 ********************************************/
 
+#ifndef GEN_HEADLESS
 #include <d3dx9.h>
 #include "MathDX.h"
+#endif
 #include "Camera.h"
 #include "CVector4.h"
 
@@ -48,8 +50,18 @@ void CCamera::CalculateMatrices()
 	// aspect ratio, and the near and far clipping planes (which define at
     // what distances geometry should be no longer be rendered).
 	float fovY = ATan(Tan( m_FOV * 0.5f ) / m_Aspect) * 2.0f; // Need fovY, storing fovX
+#ifndef GEN_HEADLESS
     D3DXMatrixPerspectiveFovLH( ToD3DXMATRIXPtr(&m_MatProj), fovY, m_Aspect,
 	                            m_NearClip, m_FarClip );
+#else
+	// No D3DX in headless builds, build the same left-handed perspective matrix by hand
+	TFloat32 yScale = 1.0f / Tan( fovY * 0.5f );
+	TFloat32 zScale = m_FarClip / (m_FarClip - m_NearClip);
+	m_MatProj = CMatrix4x4( yScale / m_Aspect, 0.0f,   0.0f,                  0.0f,
+	                        0.0f,              yScale, 0.0f,                  0.0f,
+	                        0.0f,              0.0f,   zScale,                1.0f,
+	                        0.0f,              0.0f,   -m_NearClip * zScale,  0.0f );
+#endif
 
 	// Combine the view and projection matrix into a single matrix - this will
 	// be passed to vertex shaders (more efficient this way)
@@ -129,6 +141,41 @@ bool CCamera::PixelFromWorldPt( CVector3 worldPt, TUInt32 ViewportWidth, TUInt32
 	return true; // Placeholder code, fill in for User Interface assignment task
 }
 
+// Calculate pixel coordinates for an array of world coordinates, as above but more efficient
+// for many points. The pixel coordinates are written to the X and Y arrays at the same index
+// as the world coordinate. Points behind the camera are skipped, the indices of the others are
+// written to the start of the visiblePts array. Returns the number of these visible points
+TUInt32 CCamera::PixelsFromWorldPts( const CVector3* worldPts, TUInt32 numPts,
+                                     TUInt32 ViewportWidth, TUInt32 ViewportHeight,
+                                     TInt32* X, TInt32* Y, TUInt32* visiblePts )
+{
+	// Transform the points in batches through a small buffer on the stack
+	const TUInt32 kBatchSize = 64;
+	CVector4 viewportPts[kBatchSize];
+
+	TUInt32 numVisible = 0;
+	for (TUInt32 batchStart = 0; batchStart < numPts; batchStart += kBatchSize)
+	{
+		TUInt32 batchSize = Min( numPts - batchStart, kBatchSize );
+		TransformPoints( m_MatViewProj, &worldPts[batchStart], viewportPts, batchSize );
+
+		for (TUInt32 pt = 0; pt < batchSize; ++pt)
+		{
+			const CVector4& viewportPt = viewportPts[pt];
+			if (viewportPt.w >= 0)
+			{
+				TUInt32 index = batchStart + pt;
+				X[index] = (viewportPt.x / viewportPt.w + 1.0f) * (ViewportWidth / 2);
+				Y[index] = (1.0f - viewportPt.y / viewportPt.w) * (ViewportHeight / 2);
+				visiblePts[numVisible] = index;
+				++numVisible;
+			}
+		}
+	}
+
+	return numVisible;
+}
+
 // Calculate the world coordinates of a point on the near clip plane corresponding to given 
 // X and Y pixel coordinates using this camera. Pass the viewport width and height
 CVector3 CCamera::WorldPtFromPixel( TInt32 X, TInt32 Y, 
@@ -113,6 +113,14 @@ public:
 	bool PixelFromWorldPt( CVector3 worldPt, TUInt32 ViewportWidth, TUInt32 ViewportHeight,
 	                       TInt32* X, TInt32* Y );
 
+	// Calculate pixel coordinates for an array of world coordinates, as above but more efficient
+	// for many points. The pixel coordinates are written to the X and Y arrays at the same index
+	// as the world coordinate. Points behind the camera are skipped, the indices of the others are
+	// written to the start of the visiblePts array. Returns the number of these visible points
+	TUInt32 PixelsFromWorldPts( const CVector3* worldPts, TUInt32 numPts,
+	                            TUInt32 ViewportWidth, TUInt32 ViewportHeight,
+	                            TInt32* X, TInt32* Y, TUInt32* visiblePts );
+
 	// Calculate the world coordinates of a point on the near clip plane corresponding to given 
 	// X and Y pixel coordinates using this camera. Pass the viewport width and height
 	CVector3 WorldPtFromPixel( TInt32 X, TInt32 Y,
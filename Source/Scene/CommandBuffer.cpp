@@ -0,0 +1,170 @@
+/*******************************************
+	CommandBuffer.cpp
+
+	Deferred commands recorded by entities
+	during a parallel update
+********************************************/
+
+#include "CommandBuffer.h"
+#include "EntityManager.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Recording
+
+// Start a new section of commands with the given order value. Commands recorded before any
+// section is started go in a section with order 0
+void CCommandBuffer::BeginSection( TUInt32 order )
+{
+	SSection section;
+	section.order = order;
+	section.firstCommand = m_NumCommands;
+	m_Sections.push_back( section );
+}
+
+// Send a message to the given UID, or to all entities or a team, as the messenger functions
+void CCommandBuffer::SendMessage( TEntityUID to, const SMessage& msg )
+{
+	SCommand& command = AddCommand( Cmd_SendMessage );
+	command.UID = to;
+	command.msg = msg;
+}
+
+void CCommandBuffer::BroadcastMessage( const SMessage& msg )
+{
+	SCommand& command = AddCommand( Cmd_BroadcastMessage );
+	command.msg = msg;
+}
+
+void CCommandBuffer::SendTeamMessage( TUInt32 team, const SMessage& msg )
+{
+	SCommand& command = AddCommand( Cmd_SendTeamMessage );
+	command.team = team;
+	command.msg = msg;
+}
+
+// Create a shell, as the entity manager function of the same name
+void CCommandBuffer::CreateShell
+(
+	const string&   templateName,
+	const CVector3& target,
+	CTankEntity*    parentEntity,
+	const string&   name /*= ""*/,
+	const CVector3& position /*= CVector3::kOrigin*/,
+	const CVector3& rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
+	const CVector3& scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
+)
+{
+	SCommand& command = AddCommand( Cmd_CreateShell );
+	command.templateName = templateName;
+	command.name = name;
+	command.target = target;
+	command.hasParent = (parentEntity != 0);
+	command.UID = command.hasParent ? parentEntity->GetUID() : 0;
+	command.position = position;
+	command.rotation = rotation;
+	command.scale = scale;
+}
+
+// Destroy the entity with the given UID
+void CCommandBuffer::DestroyEntity( TEntityUID UID )
+{
+	SCommand& command = AddCommand( Cmd_DestroyEntity );
+	command.UID = UID;
+}
+
+
+/////////////////////////////////////
+// Execution
+
+// Execute the commands in the given section using the given entity manager and messenger,
+// except for entity destruction
+void CCommandBuffer::ExecuteSection( TUInt32 section, CEntityManager* entityManager,
+                                     CMessenger* messenger )
+{
+	TUInt32 endCommand = SectionEnd( section );
+	for (TUInt32 index = m_Sections[section].firstCommand; index < endCommand; ++index)
+	{
+		SCommand& command = m_Commands[index];
+		switch (command.type)
+		{
+			case Cmd_SendMessage:
+				messenger->SendMessage( command.UID, command.msg );
+				break;
+			case Cmd_BroadcastMessage:
+				messenger->BroadcastMessage( command.msg );
+				break;
+			case Cmd_SendTeamMessage:
+				messenger->SendTeamMessage( command.team, command.msg );
+				break;
+			case Cmd_CreateShell:
+			{
+				// The parent is 0 if it was destroyed before this update
+				CTankEntity* parentEntity = 0;
+				if (command.hasParent)
+				{
+					parentEntity = static_cast<CTankEntity*>(entityManager->GetEntity( command.UID ));
+				}
+				entityManager->CreateShell( command.templateName, command.target, parentEntity,
+				                            command.name, command.position, command.rotation, command.scale );
+				break;
+			}
+			case Cmd_DestroyEntity:
+				// Executed by DestroySectionEntities
+				break;
+		}
+	}
+}
+
+// Execute the entity destruction commands in the given section
+void CCommandBuffer::DestroySectionEntities( TUInt32 section, CEntityManager* entityManager )
+{
+	TUInt32 endCommand = SectionEnd( section );
+	for (TUInt32 index = m_Sections[section].firstCommand; index < endCommand; ++index)
+	{
+		if (m_Commands[index].type == Cmd_DestroyEntity)
+		{
+			entityManager->DestroyEntity( m_Commands[index].UID );
+		}
+	}
+}
+
+// Remove all commands, keeping the memory for reuse
+void CCommandBuffer::Clear()
+{
+	m_NumCommands = 0;
+	m_Sections.clear();
+}
+
+
+/////////////////////////////////////
+// Support functions
+
+// Add a new command of the given type to the current section and return it
+CCommandBuffer::SCommand& CCommandBuffer::AddCommand( ECommandType type )
+{
+	if (m_Sections.empty())
+	{
+		BeginSection( 0 );
+	}
+	if (m_NumCommands == m_Commands.size())
+	{
+		m_Commands.push_back( SCommand() );
+	}
+
+	SCommand& command = m_Commands[m_NumCommands];
+	command.type = type;
+	++m_NumCommands;
+	return command;
+}
+
+// Return the index after the last command in the given section
+TUInt32 CCommandBuffer::SectionEnd( TUInt32 section )
+{
+	return (section + 1 < m_Sections.size()) ? m_Sections[section + 1].firstCommand : m_NumCommands;
+}
+
+
+} // namespace gen
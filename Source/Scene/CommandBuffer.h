@@ -0,0 +1,166 @@
+/*******************************************
+	CommandBuffer.h
+
+	Deferred commands recorded by entities
+	during a parallel update
+********************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "Entity.h"
+#include "Messenger.h"
+
+namespace gen
+{
+
+// Forward declarations of classes used by commands
+class CTankEntity;
+class CEntityManager;
+
+
+// A command buffer records changes that an entity makes outside of itself during its update -
+// sending messages and creating or destroying entities - so they can be made later, at a point
+// when no entities are being updated. Each thread updating entities has its own buffer, so no
+// locking is needed to record commands.
+// Commands are recorded in sections, each given an order value when started (e.g. the index of
+// the first entity in a chunk of updates). Sections from several buffers are executed in order
+// of these values, so the commands are executed in the same order however the work was split
+// between threads. Entity destruction is executed separately, after every section's other
+// commands, so new entities can be added together and entities named by other commands do not
+// move in their pools before those commands are executed
+class CCommandBuffer
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Constructor
+	CCommandBuffer()
+	{
+		m_NumCommands = 0;
+	}
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CCommandBuffer( const CCommandBuffer& );
+	CCommandBuffer& operator=( const CCommandBuffer& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Recording
+
+	// Start a new section of commands with the given order value. Commands recorded before any
+	// section is started go in a section with order 0
+	void BeginSection( TUInt32 order );
+
+	// Send a message to the given UID, or to all entities or a team, as the messenger functions
+	void SendMessage( TEntityUID to, const SMessage& msg );
+	void BroadcastMessage( const SMessage& msg );
+	void SendTeamMessage( TUInt32 team, const SMessage& msg );
+
+	// Create a shell, as the entity manager function of the same name
+	void CreateShell
+	(
+		const string&   templateName,
+		const CVector3& target,
+		CTankEntity*    parentEntity,
+		const string&   name = "",
+		const CVector3& position = CVector3::kOrigin,
+		const CVector3& rotation = CVector3( 0.0f, 0.0f, 0.0f ),
+		const CVector3& scale = CVector3( 1.0f, 1.0f, 1.0f )
+	);
+
+	// Destroy the entity with the given UID
+	void DestroyEntity( TEntityUID UID );
+
+
+	/////////////////////////////////////
+	// Execution
+
+	// Return the number of sections recorded
+	TUInt32 NumSections()
+	{
+		return static_cast<TUInt32>(m_Sections.size());
+	}
+
+	// Return the order value of the given section
+	TUInt32 SectionOrder( TUInt32 section )
+	{
+		return m_Sections[section].order;
+	}
+
+	// Execute the commands in the given section using the given entity manager and messenger,
+	// except for entity destruction
+	void ExecuteSection( TUInt32 section, CEntityManager* entityManager, CMessenger* messenger );
+
+	// Execute the entity destruction commands in the given section
+	void DestroySectionEntities( TUInt32 section, CEntityManager* entityManager );
+
+	// Remove all commands, keeping the memory for reuse
+	void Clear();
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Types of command
+	enum ECommandType
+	{
+		Cmd_SendMessage,
+		Cmd_BroadcastMessage,
+		Cmd_SendTeamMessage,
+		Cmd_CreateShell,
+		Cmd_DestroyEntity,
+	};
+
+	// A recorded command. Only the members used by the command type are set
+	struct SCommand
+	{
+		ECommandType type;
+		TEntityUID   UID;    // Message recipient, entity to destroy or parent of new shell
+		TUInt32      team;   // Message team
+		SMessage     msg;
+
+		// Shell creation. The parent tank is recorded by UID (in the UID member above) rather than
+		// by pointer, as it may have moved in its pool since the command was recorded
+		string       templateName;
+		string       name;
+		CVector3     target;
+		bool         hasParent;
+		CVector3     position;
+		CVector3     rotation;
+		CVector3     scale;
+	};
+
+	// A section of commands - the order value and the index of the first command
+	struct SSection
+	{
+		TUInt32 order;
+		TUInt32 firstCommand;
+	};
+
+	// Add a new command of the given type to the current section and return it
+	SCommand& AddCommand( ECommandType type );
+
+	// Return the index after the last command in the given section
+	TUInt32 SectionEnd( TUInt32 section );
+
+	// Recorded commands and the sections they are divided into. Cleared commands are kept rather
+	// than destroyed, so their strings keep any memory allocated
+	vector<SCommand> m_Commands;
+	TUInt32          m_NumCommands;
+	vector<SSection> m_Sections;
+};
+
+
+} // namespace gen
@@ -4,11 +4,16 @@
 	Entity class implementation
 ********************************************/
 
+#include "Error.h"
+#include "CQuatTransform.h"
 #include "Entity.h"
 
 namespace gen
 {
 
+// Interpolated matrices for the entity being rendered. Rendering is only done on one thread
+static vector<CMatrix4x4> InterpolatedMatrices;
+
 /*-----------------------------------------------------------------------------------------
 -------------------------------------------------------------------------------------------
 	Base Entity Class
@@ -17,6 +22,8 @@ namespace gen
 
 // Base entity constructor, needs pointer to common template data and UID, may also pass 
 // name, initial position, rotation and scaling. Set up positional matrices for the entity
+// The matrices are held in a matrix arena at the given slot - entity pools pass their own
+// arena and the entity's slot after the other parameters
 CEntity::CEntity
 (
 	CEntityTemplate* entityTemplate,
@@ -24,47 +31,114 @@ CEntity::CEntity
 	const string&    name /*=""*/,
 	const CVector3&  position /*= CVector3::kOrigin*/, 
 	const CVector3&  rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
-	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
+	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/,
+	CMatrixArena*    matrixArena /*= 0*/,
+	TUInt32          matrixSlot /*= 0*/
 )
 {
+	GEN_ASSERT( matrixArena, "Entities must be created in an entity pool" );
+
 	m_Template = entityTemplate;
 	m_UID = UID;
 	m_Name = name;
 
-	// Allocate space for matrices
+	// Make sure the arena has room for the matrices
 	TUInt32 numNodes = m_Template->Mesh()->GetNumNodes();
-	m_RelMatrices = new CMatrix4x4[numNodes];
-	m_Matrices = new CMatrix4x4[numNodes];
+	m_MatrixArena = matrixArena;
+	m_MatrixSlot = matrixSlot;
+	m_MatrixArena->ReserveNodes( numNodes );
 
 	// Set initial matrices from mesh defaults
+	CMatrix4x4* relMatrices = m_MatrixArena->RelMatrices( m_MatrixSlot );
 	for (TUInt32 node = 0; node < numNodes; ++node)
 	{
-		m_RelMatrices[node] = m_Template->Mesh()->GetNode( node ).positionMatrix;
+		relMatrices[node] = m_Template->Mesh()->GetNode( node ).positionMatrix;
 	}
 
 	// Override root matrix with constructor parameters
-	m_RelMatrices[0] = CMatrix4x4( position, rotation, kZXY, scale );
+	relMatrices[0] = CMatrix4x4( position, rotation, kZXY, scale );
+
+	// Static entities are never updated, so this is their only world matrix calculation
+	UpdateWorldMatrices();
 }
 
 
-// Render the model
-void CEntity::Render()
+// Calculate the cached world matrices from the relative matrices and node hierarchy. If
+// keepPrevious is true the world matrices from before are kept, and rendering interpolates
+// between the two. Otherwise the entity is rendered at the new world matrices
+void CEntity::UpdateWorldMatrices( bool keepPrevious /*= false*/ )
 {
 	// Get pointer to mesh to simplify code
 	CMesh* Mesh = m_Template->Mesh();
+	TUInt32 numNodes = Mesh->GetNumNodes();
+
+	CMatrix4x4* relMatrices = m_MatrixArena->RelMatrices( m_MatrixSlot );
+	CMatrix4x4* matrices = m_MatrixArena->Matrices( m_MatrixSlot );
+	CMatrix4x4* prevMatrices = m_MatrixArena->PrevMatrices( m_MatrixSlot );
+	if (keepPrevious)
+	{
+		for (TUInt32 node = 0; node < numNodes; ++node)
+		{
+			prevMatrices[node] = matrices[node];
+		}
+	}
 
 	// Calculate absolute matrices from relative node matrices & node heirarchy
-	m_Matrices[0] = m_RelMatrices[0];
-	TUInt32 numNodes = Mesh->GetNumNodes();
+	matrices[0] = relMatrices[0];
 	for (TUInt32 node = 1; node < numNodes; ++node)
 	{
-		m_Matrices[node] = m_RelMatrices[node] * m_Matrices[Mesh->GetNode( node ).parent];
+		matrices[node] = relMatrices[node] * matrices[Mesh->GetNode( node ).parent];
 	}
 	// Incorporate any bone<->mesh offsets (only relevant for skinning)
 	// Don't need this step for this exercise
 
-	// Render with absolute matrices
-	Mesh->Render( m_Matrices );
+	m_WorldMatricesDirty = false;
+	m_HasPreviousMatrices = keepPrevious;
+}
+
+// Discard the previous world matrices kept by UpdateWorldMatrices, used for entities that have
+// not moved in the latest simulation step
+void CEntity::ClearPreviousWorldMatrices()
+{
+	m_HasPreviousMatrices = false;
+}
+
+
+// Render the model using its cached world matrices, first calculating them if out of date.
+// Pass the fraction of time (0 to 1) from the previous simulation step to the latest, if the
+// entity moved in the latest step its matrices are interpolated between the two
+void CEntity::Render( TFloat32 interpolation /*= 1.0f*/ )
+{
+	// Only entities changed outside of the update (e.g. static scenery moved by the app) are
+	// out of date here, updated entities have their world matrices calculated after the update
+	if (m_WorldMatricesDirty)
+	{
+		UpdateWorldMatrices();
+	}
+
+	CMatrix4x4* matrices = m_MatrixArena->Matrices( m_MatrixSlot );
+	if (!m_HasPreviousMatrices || interpolation >= 1.0f)
+	{
+		m_Template->Mesh()->Render( matrices );
+		return;
+	}
+
+	// Interpolate each node's world matrix as a quaternion transform - slerp for rotation and
+	// lerp for position and scale, so nodes do not shear or shrink part way through a turn
+	CMatrix4x4* prevMatrices = m_MatrixArena->PrevMatrices( m_MatrixSlot );
+	TUInt32 numNodes = m_Template->Mesh()->GetNumNodes();
+	if (InterpolatedMatrices.size() < numNodes)
+	{
+		InterpolatedMatrices.resize( numNodes );
+	}
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		CQuatTransform transform;
+		Slerp( CQuatTransform( prevMatrices[node] ), CQuatTransform( matrices[node] ), interpolation,
+		       transform );
+		transform.GetMatrix( InterpolatedMatrices[node] );
+	}
+	m_Template->Mesh()->Render( &InterpolatedMatrices[0] );
 }
 
 
@@ -14,6 +14,7 @@ using namespace std;
 #include "CMatrix4x4.h"
 #include "Camera.h"
 #include "Mesh.h"
+#include "MatrixArena.h"
 
 namespace gen
 {
@@ -25,6 +26,10 @@ namespace gen
 typedef TUInt32 TEntityUID;
 const TEntityUID SystemUID = 0xffffffff;
 
+// Template types and names are interned to integer IDs by the entity manager so they can be
+// compared quickly. This ID matches any template type or name in entity queries
+const TUInt32 kAnyTemplateID = 0xffffffff;
+
 
 /*-----------------------------------------------------------------------------------------
 -------------------------------------------------------------------------------------------
@@ -41,27 +46,19 @@ class CEntityTemplate
 //	Constructors/Destructors
 public:
 	// Base entity template constructor needs template type (e.g. "Car"), name (e.g. "Fiat Panda")
-	// and the associated mesh (e.g. "panda.x")
-	CEntityTemplate( const string& type, const string& name, const string& meshFilename )
+	// and the associated mesh. Meshes are shared between templates using the same mesh file, so
+	// the mesh is owned by the entity manager rather than the template
+	CEntityTemplate( const string& type, const string& name, CMesh* mesh )
 	{
 		m_Type = type;
 		m_Name = name;
-
-		// Load mesh
-		m_Mesh = new CMesh();
-		if (!m_Mesh->Load( meshFilename ))
-		{
-			string errorMsg = "Error loading mesh " + meshFilename;
-			SystemMessageBox( errorMsg.c_str(), "Mesh Error" );
-			throw; // failure in constructor can only be signalled with exception 
-		}
+		m_TypeID = kAnyTemplateID;
+		m_NameID = kAnyTemplateID;
+		m_Mesh = mesh;
 	}
 
 	// Destructor - base class destructors should always be virtual
-	virtual ~CEntityTemplate()
-	{
-		delete m_Mesh;
-	}
+	virtual ~CEntityTemplate() {}
 
 private:
 	// Prevent use of copy constructor and assignment operator (private and not defined)
@@ -73,6 +70,17 @@ private:
 //	Public interface
 public:
 
+	/////////////////////////////////////
+	//	Setters
+
+	// Set the interned type and name IDs, called by the entity manager when the template is added
+	void SetIDs( TUInt32 typeID, TUInt32 nameID )
+	{
+		m_TypeID = typeID;
+		m_NameID = nameID;
+	}
+
+
 	/////////////////////////////////////
 	//	Getters
 
@@ -86,6 +94,17 @@ public:
 		return m_Name;
 	}
 
+	// Interned IDs for the type and name, assigned by the entity manager
+	TUInt32 GetTypeID()
+	{
+		return m_TypeID;
+	}
+
+	TUInt32 GetNameID()
+	{
+		return m_NameID;
+	}
+
 	CMesh* const Mesh()
 	{
 		return m_Mesh;
@@ -96,11 +115,13 @@ public:
 //	Private interface
 private:
 
-	// Type and name of the template
-	string m_Type;
-	string m_Name;
+	// Type and name of the template, and their interned IDs
+	string  m_Type;
+	string  m_Name;
+	TUInt32 m_TypeID;
+	TUInt32 m_NameID;
 
-	// The mesh representing this entity
+	// The mesh representing this entity, shared with any other templates using the same mesh
 	CMesh* m_Mesh;
 };
 
@@ -122,6 +143,8 @@ class CEntity
 public:
 	// Base entity constructor, needs pointer to common template data and UID, may also pass 
 	// name, initial position, rotation and scaling. Set up positional matrices for the entity
+	// The matrices are held in a matrix arena at the given slot - entity pools pass their own
+	// arena and the entity's slot after the other parameters
 	CEntity
 	(
 		CEntityTemplate* entityTemplate,
@@ -129,15 +152,13 @@ public:
 		const string&    name = "",
 		const CVector3&  position = CVector3::kOrigin, 
 		const CVector3&  rotation = CVector3( 0.0f, 0.0f, 0.0f ),
-		const CVector3&  scale = CVector3( 1.0f, 1.0f, 1.0f )
+		const CVector3&  scale = CVector3( 1.0f, 1.0f, 1.0f ),
+		CMatrixArena*    matrixArena = 0,
+		TUInt32          matrixSlot = 0
 	);
 
 	// Destructor - base class destructors should always be virtual
-	virtual ~CEntity()
-	{
-		delete[] m_Matrices;
-		delete[] m_RelMatrices;
-	}
+	virtual ~CEntity() {}
 
 private:
 	// Prevent use of copy constructor and assignment operator (private and not defined)
@@ -171,16 +192,53 @@ public:
 	/////////////////////////////////////
 	// Matrix access
 
-	// Direct access to position and matrix
+	// Direct access to position and matrix. The entity is assumed to have moved, so its cached
+	// world matrices are marked out of date. Use GetPosition / GetMatrix to read without this
 	CVector3& Position( TUInt32 node = 0 )
 	{
-		return m_RelMatrices[node].Position();
+		m_WorldMatricesDirty = true;
+		return m_MatrixArena->RelMatrices( m_MatrixSlot )[node].Position();
 	}
 	CMatrix4x4& Matrix( TUInt32 node = 0 )
 	{
-		return m_RelMatrices[node];
+		m_WorldMatricesDirty = true;
+		return m_MatrixArena->RelMatrices( m_MatrixSlot )[node];
+	}
+
+	// Read only access to position and matrix
+	const CVector3& GetPosition( TUInt32 node = 0 )
+	{
+		return m_MatrixArena->RelMatrices( m_MatrixSlot )[node].Position();
+	}
+	const CMatrix4x4& GetMatrix( TUInt32 node = 0 )
+	{
+		return m_MatrixArena->RelMatrices( m_MatrixSlot )[node];
+	}
+
+	// Access to the world matrix of a node, combining its relative matrix with those of its
+	// parents. World matrices are cached - they are calculated when the entity is created and
+	// by the entity manager after each update, so do not include changes made since then
+	const CMatrix4x4& WorldMatrix( TUInt32 node = 0 )
+	{
+		return m_MatrixArena->Matrices( m_MatrixSlot )[node];
+	}
+
+	// Return true if the entity's matrices have been accessed for change since its world matrices
+	// were last calculated
+	bool WorldMatricesDirty()
+	{
+		return m_WorldMatricesDirty;
 	}
 
+	// Calculate the cached world matrices from the relative matrices and node hierarchy. If
+	// keepPrevious is true the world matrices from before are kept, and rendering interpolates
+	// between the two. Otherwise the entity is rendered at the new world matrices
+	void UpdateWorldMatrices( bool keepPrevious = false );
+
+	// Discard the previous world matrices kept by UpdateWorldMatrices, used for entities that
+	// have not moved in the latest simulation step
+	void ClearPreviousWorldMatrices();
+
 
 	/////////////////////////////////////
 	// Update / Render
@@ -190,8 +248,10 @@ public:
 	// Virtual function, base version does nothing
 	virtual bool Update( TFloat32 updateTime ) { return true; }
 	
-	// Render the entity
-	void Render();
+	// Render the entity using its cached world matrices, first calculating them if out of date.
+	// Pass the fraction of time (0 to 1) from the previous simulation step to the latest, if the
+	// entity moved in the latest step its matrices are interpolated between the two
+	void Render( TFloat32 interpolation = 1.0f );
 
 
 /////////////////////////////////////
@@ -205,9 +265,16 @@ private:
 	TEntityUID  m_UID;
 	string      m_Name;
 
-	// Relative and absolute world matrices for each node in the template's mesh
-	CMatrix4x4* m_RelMatrices; // Dynamically allocated arrays
-	CMatrix4x4* m_Matrices;
+	// Arena holding the relative and absolute world matrices for each node in the template's
+	// mesh, and the slot in the arena used by this entity
+	CMatrixArena* m_MatrixArena;
+	TUInt32       m_MatrixSlot;
+
+	// Set when the matrices are accessed for change, cleared when world matrices are calculated
+	bool          m_WorldMatricesDirty;
+
+	// Set when the arena holds previous world matrices that differ from the current ones
+	bool          m_HasPreviousMatrices;
 };
 
 
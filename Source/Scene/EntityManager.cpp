@@ -5,31 +5,53 @@
 	destruction
 ********************************************/
 
+#include <algorithm>
+using namespace std;
+
 #include "EntityManager.h"
+#include "Messenger.h"
 
 namespace gen
 {
 
+// Messenger used to send the messages recorded in command buffers
+extern CMessenger Messenger;
+
 /////////////////////////////////////
 // Constructors/Destructors
 
 // Constructor reserves space for entities and UID hash map, also sets first UID
-CEntityManager::CEntityManager()
+CEntityManager::CEntityManager() : m_Shells( kShellPoolCapacity )
 {
-	// Initialise list of entities and UID hash map
-	m_Entities.reserve( 1024 );
-	m_EntityUIDMap = new CHashTable<TEntityUID, TUInt32>( 2048, JOneAtATimeHash ); 
+	// Allocate the shell pool now rather than when firing starts
+	m_Shells.Reserve( kShellPoolCapacity );
+
+	// Initialise UID hash maps
+	m_EntityUIDMap = new CHashTable<TEntityUID, TUInt32>( 2048, IntegerHash ); 
+	m_TypeIndexMap = new CHashTable<TEntityUID, TUInt32>( 2048, IntegerHash ); 
 
 	// Set first entity UID that will be used
 	m_NextUID = 0;
+	m_RandomSeed = 0;
+	m_MaxTankRadius = 0.0f;
+	m_TankTypeID = kAnyTemplateID;
 
-	m_IsEnumerating = false;
+	m_TeamOneScore = 0;
+	m_TeamTwoScore = 0;
+
+	// Command buffer for the calling thread, more are added when threads are started
+	m_CommandBuffers.push_back( new CCommandBuffer );
+	m_CommittingCommands = false;
 }
 
 // Destructor removes all entities
 CEntityManager::~CEntityManager()
 {
+	StopThreads();
+	delete m_CommandBuffers[0];
+
 	DestroyAllEntities();
+	delete m_TypeIndexMap;
 	delete m_EntityUIDMap;
 }
 
@@ -38,42 +60,116 @@ CEntityManager::~CEntityManager()
 // Template creation / destruction
 
 // Create a base entity template with the given type, name and mesh. Returns the new entity
-// template pointer
+// template pointer, or 0 if the mesh cannot be loaded
 CEntityTemplate* CEntityManager::CreateTemplate( const string& type, const string& name, const string& mesh )
 {
+	CMesh* templateMesh = AcquireTemplateMesh( mesh );
+	if (!templateMesh)
+	{
+		return 0;
+	}
+
 	// Create new entity template
-	CEntityTemplate* newTemplate = new CEntityTemplate( type, name, mesh );
+	CEntityTemplate* newTemplate = new CEntityTemplate( type, name, templateMesh );
 
 	// Add the template name / template pointer pair to the map
-    m_Templates[name] = newTemplate;
+	AddTemplate( newTemplate );
 
 	return newTemplate;
 }
 
 // Create a tank template with the given type, name, mesh and stats. Returns the new entity
-// template pointer
+// template pointer, or 0 if the mesh cannot be loaded
 CTankTemplate* CEntityManager::CreateTankTemplate(const string& type, const string& name,
 	const string& mesh, float maxSpeed,
 	float acceleration, float turnSpeed,
 	float turretTurnSpeed, int maxHP, int shellDamage)
 {
+	CMesh* templateMesh = AcquireTemplateMesh(mesh);
+	if (!templateMesh)
+	{
+		return 0;
+	}
+
 	// Create new tank template
-	CTankTemplate* newTemplate = new CTankTemplate(type, name, mesh, maxSpeed, acceleration,
+	CTankTemplate* newTemplate = new CTankTemplate(type, name, templateMesh, maxSpeed, acceleration,
 		turnSpeed, turretTurnSpeed, maxHP, shellDamage);
 
 	// Add the template name / template pointer pair to the map
-	m_Templates[name] = newTemplate;
+	AddTemplate(newTemplate);
 
 	return newTemplate;
 }
 
+// Create an ammo box template with the given type, name, mesh and gravity. Returns the new entity
+// template pointer, or 0 if the mesh cannot be loaded
 CAmmoBoxTemplate* CEntityManager::CreateAmmoBoxTemplate(const string& type, const string& name, const string& mesh, float gravity)
 {
-	CAmmoBoxTemplate* newTemplate = new CAmmoBoxTemplate(type, name, mesh, gravity);
-	m_Templates[name] = newTemplate;
+	CMesh* templateMesh = AcquireTemplateMesh(mesh);
+	if (!templateMesh)
+	{
+		return 0;
+	}
+
+	CAmmoBoxTemplate* newTemplate = new CAmmoBoxTemplate(type, name, templateMesh, gravity);
+	AddTemplate(newTemplate);
 	return newTemplate;
 }
 
+// Return the shared mesh for a new template, loading it if no other template uses it. Reports
+// the error and returns 0 if the mesh cannot be loaded
+CMesh* CEntityManager::AcquireTemplateMesh( const string& mesh )
+{
+	CMesh* templateMesh = m_MeshManager.AcquireMesh( mesh );
+	if (!templateMesh)
+	{
+		string errorMsg = "Error loading mesh " + mesh;
+		SystemMessageBox( errorMsg.c_str(), "Mesh Error" );
+	}
+	return templateMesh;
+}
+
+// Add a newly created template to the template map, assigning its type and name IDs
+void CEntityManager::AddTemplate( CEntityTemplate* newTemplate )
+{
+	TUInt32 typeID = TemplateTypeID( newTemplate->GetType() );
+	newTemplate->SetIDs( typeID, TemplateNameID( newTemplate->GetName() ) );
+	m_Templates[newTemplate->GetName()] = newTemplate;
+
+	// Remember the tank type ID for shell collision. Type IDs are never reused, so it stays
+	// valid when templates are destroyed
+	if (newTemplate->GetType() == "Tank")
+	{
+		m_TankTypeID = typeID;
+	}
+}
+
+// Delete a template, releasing its mesh
+void CEntityManager::DeleteTemplate( CEntityTemplate* entityTemplate )
+{
+	m_MeshManager.ReleaseMesh( entityTemplate->Mesh() );
+	delete entityTemplate;
+}
+
+// Load the meshes for templates that are about to be created, so a level's meshes can be
+// loaded together rather than one template at a time. The meshes are imported in parallel on
+// the update threads, then template creation finds them already loaded. The meshes are held
+// until ReleasePreloadedMeshes is called. Returns false if any mesh cannot be loaded
+bool CEntityManager::PreloadMeshes( const vector<string>& meshes )
+{
+	ReleasePreloadedMeshes();
+	return m_MeshManager.AcquireMeshes( meshes, &m_PreloadedMeshes, m_JobSystem );
+}
+
+void CEntityManager::ReleasePreloadedMeshes()
+{
+	for (TUInt32 mesh = 0; mesh < m_PreloadedMeshes.size(); ++mesh)
+	{
+		m_MeshManager.ReleaseMesh( m_PreloadedMeshes[mesh] );
+	}
+	m_PreloadedMeshes.clear();
+}
+
 // Destroy the given template (name) - returns true if the template existed and was destroyed
 bool CEntityManager::DestroyTemplate( const string& name )
 {
@@ -86,7 +182,7 @@ bool CEntityManager::DestroyTemplate( const string& name )
 	}
 
 	// Delete the template and remove the map entry
-	delete entityTemplate->second;
+	DeleteTemplate( entityTemplate->second );
 	m_Templates.erase( entityTemplate );
 	return true;
 }
@@ -99,7 +195,7 @@ void CEntityManager::DestroyAllTemplates()
 		TTemplateIter entityTemplate = m_Templates.begin();
 		while (entityTemplate != m_Templates.end())
 		{
-			delete entityTemplate->second;
+			DeleteTemplate( entityTemplate->second );
 			++entityTemplate;
 		};
 		m_Templates.clear();
@@ -107,6 +203,46 @@ void CEntityManager::DestroyAllTemplates()
 }
 
 
+// Return the interned ID for a template type or template name. IDs are assigned when first
+// requested, so can be looked up before any template uses them. An empty string returns
+// kAnyTemplateID, which matches anything in entity queries
+TUInt32 CEntityManager::TemplateTypeID( const string& type )
+{
+	TUInt32 typeID = InternTemplateID( m_TemplateTypeIDs, type );
+	if (typeID != kAnyTemplateID && typeID >= m_TypeEntities.size())
+	{
+		// New type, add an empty membership list for it
+		m_TypeEntities.resize( typeID + 1 );
+	}
+	return typeID;
+}
+
+TUInt32 CEntityManager::TemplateNameID( const string& name )
+{
+	return InternTemplateID( m_TemplateNameIDs, name );
+}
+
+// Return the interned ID for the given string from an ID map, adding it if new
+TUInt32 CEntityManager::InternTemplateID( TTemplateIDs& templateIDs, const string& key )
+{
+	if (key.length() == 0)
+	{
+		return kAnyTemplateID;
+	}
+
+	TTemplateIDIter templateID = templateIDs.find( key );
+	if (templateID != templateIDs.end())
+	{
+		return templateID->second;
+	}
+
+	// IDs are allocated in sequence so they can be used as array indexes
+	TUInt32 newID = static_cast<TUInt32>(templateIDs.size());
+	templateIDs[key] = newID;
+	return newID;
+}
+
+
 /////////////////////////////////////
 // Entity creation / destruction
 
@@ -124,20 +260,11 @@ TEntityUID CEntityManager::CreateEntity
 	// Get template associated with the template name
 	CEntityTemplate* entityTemplate = GetTemplate( templateName );
 
-	// Create new entity with next UID
-	CEntity* newEntity = new CEntity( entityTemplate, m_NextUID, name, position, rotation, scale );
-
-	// Get vector index for new entity and add it to vector
-	TUInt32 entityIndex = static_cast<TUInt32>(m_Entities.size());
-	m_Entities.push_back( newEntity );
+	// Create new entity with next UID in the base entity pool
+	TUInt32 entityIndex = m_Entities.Create( entityTemplate, m_NextUID, name, position, rotation, scale );
 
-	// Add mapping from UID to entity index into hash map
-	m_EntityUIDMap->SetKeyValue( m_NextUID, entityIndex );
-	
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
-
-	// Return UID of new entity then increase it ready for next entity
-	return m_NextUID++;
+	// Add mapping from UID to entity location and return the new UID
+	return AddEntityUID( Pool_Entity, entityIndex );
 }
 
 
@@ -157,20 +284,16 @@ TEntityUID CEntityManager::CreateTank
 	// This will cause an error if the template is not a tank type
 	CTankTemplate* tankTemplate = static_cast<CTankTemplate*>(GetTemplate(templateName));
 
-	// Create new tank entity with next UID
-	CEntity* newEntity = new CTankEntity(tankTemplate, m_NextUID, team, name, position, rotation, scale);
-
-	// Get vector index for new entity and add it to vector
-	TUInt32 entityIndex = static_cast<int>(m_Entities.size());
-	m_Entities.push_back(newEntity);
-
-	// Add mapping from UID to entity index into hash map
-	m_EntityUIDMap->SetKeyValue(m_NextUID, entityIndex);
+	// Create new tank entity with next UID in the tank pool
+	TUInt32 entityIndex = m_Tanks.Create(tankTemplate, m_NextUID, team, name, position, rotation, scale);
+	m_SpatialGrid.AddEntity(m_Tanks.GetAt(entityIndex), team);
 
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
+	// Keep track of the largest tank for shell collision
+	TFloat32 maxScale = Max( scale.x, Max( scale.y, scale.z ) );
+	m_MaxTankRadius = Max( m_MaxTankRadius, tankTemplate->Mesh()->BoundingRadius() * maxScale );
 
-							 // Return UID of new entity then increase it ready for next entity
-	return m_NextUID++;
+	// Add mapping from UID to entity location and return the new UID
+	return AddEntityUID(Pool_Tank, entityIndex);
 }
 
 
@@ -190,21 +313,13 @@ TEntityUID CEntityManager::CreateShell
 	// Get template associated with the template name
 	CEntityTemplate* entityTemplate = GetTemplate(templateName);
 
-	// Create new tank entity with next UID
-	CEntity* newEntity = new CShellEntity(entityTemplate, m_NextUID, target, ParentEntity,
+	// Create new shell entity with next UID in the shell pool
+	TUInt32 entityIndex = m_Shells.Create(entityTemplate, m_NextUID, target, ParentEntity,
 		name, position, rotation, scale);
+	m_SpatialGrid.AddEntity(m_Shells.GetAt(entityIndex), ParentEntity ? ParentEntity->GetTeam() : kNoTeam);
 
-	// Get vector index for new entity and add it to vector
-	TUInt32 entityIndex = static_cast<int>(m_Entities.size());
-	m_Entities.push_back(newEntity);
-
-	// Add mapping from UID to entity index into hash map
-	m_EntityUIDMap->SetKeyValue(m_NextUID, entityIndex);
-
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
-
-							 // Return UID of new entity then increase it ready for next entity
-	return m_NextUID++;
+	// Add mapping from UID to entity location and return the new UID
+	return AddEntityUID(Pool_Shell, entityIndex);
 }
 
 TEntityUID CEntityManager::CreateAmmoBox(const string& templateName, const string& name, const CVector3& position, const CVector3& rotation, const CVector3& scale)
@@ -212,17 +327,39 @@ TEntityUID CEntityManager::CreateAmmoBox(const string& templateName, const strin
 	// Get template associated with the template name
 	CAmmoBoxTemplate* entityTemplate = static_cast<CAmmoBoxTemplate*>(GetTemplate(templateName));
 
-	// Create new entity with next UID
-	CEntity* newEntity = new CAmmoBoxEntity(entityTemplate, m_NextUID, name, position, rotation, scale);
+	// Create new entity with next UID in the ammo box pool
+	TUInt32 entityIndex = m_AmmoBoxes.Create(entityTemplate, m_NextUID, name, position, rotation, scale);
+	m_SpatialGrid.AddEntity(m_AmmoBoxes.GetAt(entityIndex));
 
-	// Get vector index for new entity and add it to vector
-	TUInt32 entityIndex = static_cast<TUInt32>(m_Entities.size());
-	m_Entities.push_back(newEntity);
-
-	// Add mapping from UID to entity index into hash map
-	m_EntityUIDMap->SetKeyValue(m_NextUID, entityIndex);
+	// Add mapping from UID to entity location and return the new UID
+	return AddEntityUID(Pool_AmmoBox, entityIndex);
+}
 
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
+// Add the UID of a newly created entity to the UID map and its type's membership list, then
+// return the UID. While committing commands the UID is added to the maps later, together
+// with the other new entities
+TEntityUID CEntityManager::AddEntityUID( TUInt32 pool, TUInt32 index )
+{
+	// Add entity to the membership list for its template type
+	CEntity* newEntity = PoolEntity( pool, index );
+	TEntityList& typeEntities = m_TypeEntities[newEntity->Template()->GetTypeID()];
+	TUInt32 typeIndex = static_cast<TUInt32>(typeEntities.size());
+	typeEntities.push_back( newEntity );
+
+	// Add mapping from UID to entity pool and index, and to index in membership list, into hash
+	// maps
+	TUInt32 entityLocation = (pool << kPoolShift) | index;
+	if (m_CommittingCommands)
+	{
+		m_NewUIDs.push_back( m_NextUID );
+		m_NewLocations.push_back( entityLocation );
+		m_NewTypeIndexes.push_back( typeIndex );
+	}
+	else
+	{
+		m_EntityUIDMap->SetKeyValue( m_NextUID, entityLocation );
+		m_TypeIndexMap->SetKeyValue( m_NextUID, typeIndex );
+	}
 
 	// Return UID of new entity then increase it ready for next entity
 	return m_NextUID++;
@@ -232,75 +369,381 @@ TEntityUID CEntityManager::CreateAmmoBox(const string& templateName, const strin
 // Destroy the given entity - returns true if the entity existed and was destroyed
 bool CEntityManager::DestroyEntity( TEntityUID UID )
 {
-	// Find the vector index of the given UID
-	TUInt32 entityIndex;
-	if (!m_EntityUIDMap->LookUpKey( UID, &entityIndex ))
+	// Find the pool and index of the given UID
+	TUInt32 entityLocation;
+	if (!m_EntityUIDMap->LookUpKey( UID, &entityLocation ))
 	{
 		// Quit if not found
 		return false;
 	}
 
-	// Delete the given entity and remove from UID map
-	delete m_Entities[entityIndex];
+	// Remove the entity from the UID map and its type's membership list
 	m_EntityUIDMap->RemoveKey( UID );
-
-	// If not removing last entity...
-	if (entityIndex != m_Entities.size() - 1)
+	TUInt32 pool = entityLocation >> kPoolShift;
+	TUInt32 entityIndex = entityLocation & kPoolIndexMask;
+
+	TUInt32 typeIndex;
+	m_TypeIndexMap->LookUpKey( UID, &typeIndex );
+	m_TypeIndexMap->RemoveKey( UID );
+	TEntityList& typeEntities = m_TypeEntities[PoolEntity( pool, entityIndex )->Template()->GetTypeID()];
+	if (typeIndex != typeEntities.size() - 1)
 	{
-		// ...put the last entity into the empty entity slot and update UID map
-		m_Entities[entityIndex] = m_Entities.back();
-		m_EntityUIDMap->SetKeyValue( m_Entities.back()->GetUID(), entityIndex );
+		// If not removing last entity, put the last entity into the empty slot
+		typeEntities[typeIndex] = typeEntities.back();
+		m_TypeIndexMap->SetKeyValue( typeEntities[typeIndex]->GetUID(), typeIndex );
 	}
-	m_Entities.pop_back(); // Remove last entity
+	typeEntities.pop_back();
 
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
+	// Destroy the entity in its pool
+	switch (pool)
+	{
+		case Pool_Entity:  DestroyPoolEntity( m_Entities, pool, entityIndex );  break;
+		case Pool_Tank:    DestroyPoolEntity( m_Tanks, pool, entityIndex );     break;
+		case Pool_Shell:   DestroyPoolEntity( m_Shells, pool, entityIndex );    break;
+		case Pool_AmmoBox: DestroyPoolEntity( m_AmmoBoxes, pool, entityIndex ); break;
+	}
 	return true;
 }
 
+// Destroy the entity at the given index in a pool, updating the UID map for any entity that
+// moves to fill the gap
+template <class TEntityType>
+void CEntityManager::DestroyPoolEntity( CEntityPool<TEntityType>& entities, TUInt32 pool,
+                                        TUInt32 index )
+{
+	// Base class entities are not held in the spatial index, removal will do nothing for them
+	m_SpatialGrid.RemoveEntity( entities.GetAt( index ) );
+
+	// If not removing last entity, the pool puts the last entity into the empty slot
+	TEntityType* movedEntity = entities.DestroyAt( index );
+	if (movedEntity)
+	{
+		m_EntityUIDMap->SetKeyValue( movedEntity->GetUID(), (pool << kPoolShift) | index );
+	}
+}
+
 
 // Destroy all entities held by the manager
 void CEntityManager::DestroyAllEntities()
 {
 	m_EntityUIDMap->RemoveAllKeys();
-	while (m_Entities.size())
+	m_TypeIndexMap->RemoveAllKeys();
+	for (TUInt32 type = 0; type < m_TypeEntities.size(); ++type)
 	{
-		delete m_Entities.back();
-		m_Entities.pop_back();
+		m_TypeEntities[type].clear();
 	}
-
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
+	m_SpatialGrid.RemoveAllEntities();
+	m_Entities.DestroyAll();
+	m_Tanks.DestroyAll();
+	m_Shells.DestroyAll();
+	m_AmmoBoxes.DestroyAll();
 }
 
 
 /////////////////////////////////////
 // Update / Rendering
 
+// Start threads to share entity updates, pass the total number of threads including the
+// calling thread, or 0 for one per hardware thread. Entities are updated on the calling
+// thread alone until this is called
+void CEntityManager::StartThreads( TUInt32 numThreads /*= 0*/ )
+{
+	m_JobSystem.Start( numThreads );
+	while (m_CommandBuffers.size() < m_JobSystem.NumThreads())
+	{
+		m_CommandBuffers.push_back( new CCommandBuffer );
+	}
+}
+
+// Stop the threads sharing entity updates
+void CEntityManager::StopThreads()
+{
+	m_JobSystem.Stop();
+	while (m_CommandBuffers.size() > 1)
+	{
+		delete m_CommandBuffers.back();
+		m_CommandBuffers.pop_back();
+	}
+}
+
 // Call all entity update functions. Pass the time since last update
+// Base class entities are static scenery (their update does nothing) so they are not visited
 void CEntityManager::UpdateAllEntities( float updateTime )
 {
-	TUInt32 entity = 0;
-	while (entity < m_Entities.size())
+	UpdatePoolEntities( m_Tanks, Pool_Tank, updateTime );
+	UpdatePoolEntities( m_Shells, Pool_Shell, updateTime );
+	CollideShells();
+	UpdatePoolEntities( m_AmmoBoxes, Pool_AmmoBox, updateTime );
+
+	// Make the changes recorded during the updates
+	CommitCommands();
+
+	// Calculate world matrices once for the entities that may have moved, for use in rendering
+	// and next update. Base class entities are static so their world matrices never change
+	UpdatePoolWorldMatrices( m_Tanks );
+	UpdatePoolWorldMatrices( m_Shells );
+	UpdatePoolWorldMatrices( m_AmmoBoxes );
+}
+
+// Update all entities in a pool, recording the destruction of those whose update returns false
+template <class TEntityType>
+void CEntityManager::UpdatePoolEntities( CEntityPool<TEntityType>& entities, TUInt32 pool,
+                                         float updateTime )
+{
+	// Update the pool in chunks across the job system threads. Each chunk starts a section in its
+	// thread's command buffer, ordered by the location of its first entity (pool then index)
+	m_JobSystem.ParallelFor( entities.Size(), kUpdateChunkSize, [&]( TUInt32 begin, TUInt32 end )
 	{
-		// Update entity, if it returns false, then destroy it
-		if (!m_Entities[entity]->Update( updateTime ))
+		CCommandBuffer& commands = Commands();
+		commands.BeginSection( (pool << kPoolShift) | begin );
+		for (TUInt32 entity = begin; entity < end; ++entity)
 		{
-			DestroyEntity(m_Entities[entity]->GetUID());
+			// Update entity, if it returns false, then destroy it. All entities in the pool have
+			// the same class so the update function is called directly rather than through the
+			// vtable
+			TEntityType* poolEntity = entities.GetAt( entity );
+			if (!poolEntity->TEntityType::Update( updateTime ))
+			{
+				commands.DestroyEntity( poolEntity->GetUID() );
+			}
 		}
-		else
+	} );
+
+	// Keep spatial index up to date with the entities' new positions, including those about to
+	// be destroyed. Entities that have not changed their matrices this tick have not moved
+	for (TUInt32 entity = 0; entity < entities.Size(); ++entity)
+	{
+		TEntityType* poolEntity = entities.GetAt( entity );
+		if (poolEntity->WorldMatricesDirty())
 		{
-			++entity;
+			m_SpatialGrid.MoveEntity( poolEntity );
 		}
 	}
 }
 
-// Render all entities
-void CEntityManager::RenderAllEntities()
+// Find the shells that hit an enemy tank during their latest update, sending each tank hit a
+// message and destroying the shell. Shells are tested together after they have all moved
+void CEntityManager::CollideShells()
 {
-	TEntityIter entity = m_Entities.begin();
-	while (entity != m_Entities.end())
+	if (m_TankTypeID == kAnyTemplateID || m_Shells.Size() == 0)
+	{
+		return;
+	}
+	while (m_CollisionCandidates.size() < m_JobSystem.NumThreads())
+	{
+		m_CollisionCandidates.push_back( vector<CEntity*>() );
+	}
+
+	// Shells are independent so they are tested in parallel. The tanks are not changed during the
+	// pass, their hits are recorded as commands and made with the other changes from this update
+	m_JobSystem.ParallelFor( m_Shells.Size(), kUpdateChunkSize, [&]( TUInt32 begin, TUInt32 end )
 	{
-		(*entity)->Render();
-		++entity;
+		CCommandBuffer& commands = Commands();
+		commands.BeginSection( (kCollisionSectionPool << kPoolShift) | begin );
+		vector<CEntity*>& candidates = m_CollisionCandidates[CJobSystem::ThreadIndex()];
+		for (TUInt32 shellIndex = begin; shellIndex < end; ++shellIndex)
+		{
+			CShellEntity* shell = m_Shells.GetAt( shellIndex );
+			const CVector3& pathStart = shell->GetPrevPosition();
+			const CVector3& pathEnd = shell->GetPosition();
+			TFloat32 shellRadius = shell->Template()->Mesh()->BoundingRadius();
+
+			// Broad phase - enemy tanks whose bounding sphere may touch the sphere around the
+			// shell's whole path, found using the spatial index
+			CVector3 midPoint = (pathStart + pathEnd) * 0.5f;
+			TFloat32 searchRadius = Distance( pathStart, pathEnd ) * 0.5f + shellRadius + m_MaxTankRadius;
+			candidates.clear();
+			m_SpatialGrid.FindInRadius( midPoint, searchRadius, candidates, m_TankTypeID, Team_Other,
+			                            shell->GetTeam() );
+
+			// Narrow phase - the first tank the shell touches along its path. Ties go to the lower
+			// UID so the result does not depend on the order of the candidates
+			CEntity* hitTank = 0;
+			TFloat32 firstHitTime = 0.0f;
+			for (TUInt32 candidate = 0; candidate < candidates.size(); ++candidate)
+			{
+				TFloat32 hitTime;
+				if (SweepSphereTank( pathStart, pathEnd, shellRadius, static_cast<CTankEntity*>(candidates[candidate]),
+				                     &hitTime ) &&
+				    (!hitTank || hitTime < firstHitTime ||
+				     (hitTime == firstHitTime && candidates[candidate]->GetUID() < hitTank->GetUID())))
+				{
+					hitTank = candidates[candidate];
+					firstHitTime = hitTime;
+				}
+			}
+
+			if (hitTank)
+			{
+				// Tells the tank its been hit
+				SMessage msg;
+				msg.type = Msg_Hit;
+				msg.from = shell->GetUID();
+				commands.SendMessage( hitTank->GetUID(), msg );
+				commands.DestroyEntity( shell->GetUID() );
+			}
+		}
+	} );
+}
+
+// Test the path of a sphere from start to end against the bounding box of a tank's mesh, placed
+// with the tank's matrix. Returns true on a hit, with the fraction of the path (0 to 1) at the
+// point of contact through the given pointer
+bool CEntityManager::SweepSphereTank( const CVector3& start, const CVector3& end, TFloat32 radius,
+                                      CTankEntity* tank, TFloat32* hitTime )
+{
+	// The tank's root matrix is read rather than its cached world matrix, which is not updated
+	// until the end of the update. The tanks do not move during the shell pass
+	CMesh* mesh = tank->Template()->Mesh();
+	const CMatrix4x4& tankMatrix = tank->GetMatrix();
+	CVector3 scale = tankMatrix.GetScale();
+	TFloat32 maxScale = Max( scale.x, Max( scale.y, scale.z ) );
+
+	// Quick rejection against the tank's bounding sphere: the distance from the centre to the
+	// closest point on the path
+	CVector3 path = end - start;
+	CVector3 toCentre = tankMatrix.GetPosition() - start;
+	TFloat32 pathLengthSq = path.LengthSquared();
+	TFloat32 closest = (pathLengthSq > 0.0f) ? Dot( toCentre, path ) / pathLengthSq : 0.0f;
+	closest = Min( Max( closest, 0.0f ), 1.0f );
+	TFloat32 sphereRadius = mesh->BoundingRadius() * maxScale + radius;
+	if ((toCentre - path * closest).LengthSquared() > sphereRadius * sphereRadius)
+	{
+		return false;
+	}
+
+	// Transform the path into the mesh's space and test it against the bounding box grown by the
+	// shell's radius (the box's corners are treated as square rather than rounded, a slightly
+	// generous hit). The radius is scaled down by the smallest tank scaling to stay conservative
+	CMatrix4x4 invTankMatrix = InverseRotTransScale( tankMatrix );
+	CVector3 localStart = invTankMatrix.TransformPoint( start );
+	CVector3 localPath = invTankMatrix.TransformPoint( end ) - localStart;
+	TFloat32 localRadius = radius / Min( scale.x, Min( scale.y, scale.z ) );
+	CVector3 boxMin = mesh->MinBounds() - CVector3( localRadius, localRadius, localRadius );
+	CVector3 boxMax = mesh->MaxBounds() + CVector3( localRadius, localRadius, localRadius );
+
+	// Slab test - clip the path to the box's extent along each axis in turn
+	TFloat32 enter = 0.0f;
+	TFloat32 exit = 1.0f;
+	for (TUInt32 axis = 0; axis < 3; ++axis)
+	{
+		TFloat32 axisStart = localStart[axis];
+		TFloat32 axisPath = localPath[axis];
+		TFloat32 axisMin = boxMin[axis];
+		TFloat32 axisMax = boxMax[axis];
+		if (IsZero( axisPath ))
+		{
+			if (axisStart < axisMin || axisStart > axisMax)
+			{
+				return false;
+			}
+			continue;
+		}
+		TFloat32 t0 = (axisMin - axisStart) / axisPath;
+		TFloat32 t1 = (axisMax - axisStart) / axisPath;
+		if (t0 > t1)
+		{
+			TFloat32 t = t0;
+			t0 = t1;
+			t1 = t;
+		}
+		enter = Max( enter, t0 );
+		exit = Min( exit, t1 );
+		if (enter > exit)
+		{
+			return false;
+		}
+	}
+	*hitTime = enter;
+	return true;
+}
+
+// Calculate the world matrices of the entities in a pool whose matrices have changed, the
+// others reuse their cached world matrices. The world matrices from before the update are kept
+// for rendering to interpolate from
+template <class TEntityType>
+void CEntityManager::UpdatePoolWorldMatrices( CEntityPool<TEntityType>& entities )
+{
+	m_JobSystem.ParallelFor( entities.Size(), kWorldMatrixChunkSize, [&]( TUInt32 begin, TUInt32 end )
+	{
+		for (TUInt32 entity = begin; entity < end; ++entity)
+		{
+			TEntityType* poolEntity = entities.GetAt( entity );
+			if (poolEntity->WorldMatricesDirty())
+			{
+				poolEntity->UpdateWorldMatrices( true );
+			}
+			else
+			{
+				poolEntity->ClearPreviousWorldMatrices();
+			}
+		}
+	} );
+}
+
+// Commit the commands recorded during the update, in the order of the entities that recorded
+// them, then clear the command buffers. Entities are created first, then added to the UID maps
+// in bulk, then entities are destroyed
+void CEntityManager::CommitCommands()
+{
+	m_CommandSections.clear();
+	for (TUInt32 buffer = 0; buffer < m_CommandBuffers.size(); ++buffer)
+	{
+		for (TUInt32 section = 0; section < m_CommandBuffers[buffer]->NumSections(); ++section)
+		{
+			SCommandSection commandSection;
+			commandSection.order = m_CommandBuffers[buffer]->SectionOrder( section );
+			commandSection.buffer = buffer;
+			commandSection.section = section;
+			m_CommandSections.push_back( commandSection );
+		}
+	}
+
+	// Sections are sorted so the result does not depend on which thread ran each chunk
+	sort( m_CommandSections.begin(), m_CommandSections.end(),
+	      []( const SCommandSection& a, const SCommandSection& b ) { return a.order < b.order; } );
+	m_CommittingCommands = true;
+	for (TUInt32 section = 0; section < m_CommandSections.size(); ++section)
+	{
+		m_CommandBuffers[m_CommandSections[section].buffer]->ExecuteSection(
+			m_CommandSections[section].section, this, &Messenger );
+	}
+	m_CommittingCommands = false;
+
+	// Add the new entities to the UID maps, resizing each at most once
+	if (!m_NewUIDs.empty())
+	{
+		TUInt32 numNew = static_cast<TUInt32>(m_NewUIDs.size());
+		m_EntityUIDMap->SetKeyValues( &m_NewUIDs[0], &m_NewLocations[0], numNew );
+		m_TypeIndexMap->SetKeyValues( &m_NewUIDs[0], &m_NewTypeIndexes[0], numNew );
+		m_NewUIDs.clear();
+		m_NewLocations.clear();
+		m_NewTypeIndexes.clear();
+	}
+
+	// Destroy entities last, as destruction moves other entities in their pools
+	for (TUInt32 section = 0; section < m_CommandSections.size(); ++section)
+	{
+		m_CommandBuffers[m_CommandSections[section].buffer]->DestroySectionEntities(
+			m_CommandSections[section].section, this );
+	}
+
+	for (TUInt32 buffer = 0; buffer < m_CommandBuffers.size(); ++buffer)
+	{
+		m_CommandBuffers[buffer]->Clear();
+	}
+}
+
+// Render all entities. Pass the fraction of time (0 to 1) from the previous simulation step to
+// the latest, entities that moved in the latest step are rendered part way between the two
+void CEntityManager::RenderAllEntities( TFloat32 interpolation /*= 1.0f*/ )
+{
+	for (TUInt32 pool = 0; pool < NumEntityPools; ++pool)
+	{
+		for (TUInt32 entity = 0; entity < PoolSize( pool ); ++entity)
+		{
+			PoolEntity( pool, entity )->Render( interpolation );
+		}
 	}
 }
 
@@ -8,10 +8,18 @@
 #pragma once
 
 #include <map>
+#include <atomic>
 using namespace std;
 
 #include "Defines.h"
 #include "CHashTable.h"
+#include "CJobSystem.h"
+#include "CRandom.h"
+#include "CommandBuffer.h"
+#include "EntityPool.h"
+#include "SpatialGrid.h"
+#include "PatrolPoints.h"
+#include "MeshManager.h"
 #include "Entity.h"
 #include "TankEntity.h"
 #include "ShellEntity.h"
@@ -22,7 +30,13 @@ namespace gen
 {
 
 // The entity manager is responsible for creation, update, rendering and deletion of
-// entities. It also manages UIDs for entities using a hash table
+// entities. It also manages UIDs for entities using a hash table. Entities are stored in a
+// separate contiguous pool for each entity class so updates walk memory linearly.
+// Each pool is updated in chunks spread over the threads of a job system. While a pool is
+// updated, entities must not change anything outside themselves directly - they record
+// messages, shell creation and so on in the command buffer for their thread (Commands). The
+// buffers are committed together at the end of the update, so no pool changes while it is
+// being updated
 class CEntityManager
 {
 /////////////////////////////////////
@@ -49,17 +63,28 @@ public:
 	// Template creation / destruction
 
 	// Create a base entity template with the given type, name and mesh. Returns the new entity
-	// template pointer
-	CEntityTemplate* CEntityManager::CreateTemplate( const string& type, const string& name, const string& mesh	);
+	// template pointer, or 0 if the mesh cannot be loaded. Templates using the same mesh file
+	// share a single loaded mesh (this is the case for all the template creation functions)
+	CEntityTemplate* CreateTemplate( const string& type, const string& name, const string& mesh	);
 
 	// Create a tank template with the given type, name, mesh and stats. Returns the new entity
-	// template pointer
-	CTankTemplate* CEntityManager::CreateTankTemplate( const string& type, const string& name,
-	                                                   const string& mesh, float maxSpeed,
-	                                                   float acceleration, float turnSpeed,
-	                                                   float turretTurnSpeed, int maxHP, int shellDamage );
-
-	CAmmoBoxTemplate* CEntityManager::CreateAmmoBoxTemplate(const string& type, const string& name, const string& mesh, float gravity = -9.81f);
+	// template pointer, or 0 if the mesh cannot be loaded
+	CTankTemplate* CreateTankTemplate( const string& type, const string& name,
+	                                   const string& mesh, float maxSpeed,
+	                                   float acceleration, float turnSpeed,
+	                                   float turretTurnSpeed, int maxHP, int shellDamage );
+
+	// Create an ammo box template with the given type, name, mesh and gravity. Returns the new
+	// entity template pointer, or 0 if the mesh cannot be loaded
+	CAmmoBoxTemplate* CreateAmmoBoxTemplate(const string& type, const string& name, const string& mesh, float gravity = -9.81f);
+
+	// Load the meshes for templates that are about to be created, so a level's meshes can be
+	// loaded together rather than one template at a time. The meshes are imported in parallel on
+	// the update threads (see StartThreads), then template creation finds them already loaded.
+	// The meshes are held until ReleasePreloadedMeshes is called, which should be done once the
+	// templates are created. Returns false if any mesh cannot be loaded
+	bool PreloadMeshes( const vector<string>& meshes );
+	void ReleasePreloadedMeshes();
 
 	// Destroy the given template (name) - returns true if the template existed and was destroyed
 	bool DestroyTemplate( const string& name );
@@ -67,6 +92,12 @@ public:
 	// Destroy all templates held by the manager
 	void DestroyAllTemplates();
 
+	// Return the interned ID for a template type or template name. IDs are assigned when first
+	// requested, so can be looked up before any template uses them. An empty string returns
+	// kAnyTemplateID, which matches anything in entity queries
+	TUInt32 TemplateTypeID( const string& type );
+	TUInt32 TemplateNameID( const string& name );
+
 
 	/////////////////////////////////////
 	// Entity creation / destruction
@@ -143,121 +174,260 @@ public:
 	// Return the number of entities
 	TUInt32 NumEntities() 
 	{
-		return static_cast<TUInt32>(m_Entities.size());
+		return m_Entities.Size() + m_Tanks.Size() + m_Shells.Size() + m_AmmoBoxes.Size();
 	}
 
-	// Return the entities at the given array index
+	// Return the entity at the given index, entities are indexed pool by pool. Returns 0 if the
+	// index is not less than NumEntities
 	CEntity* GetEntityAtIndex( TUInt32 index )
 	{
-		return m_Entities[index];
+		for (TUInt32 pool = 0; pool < NumEntityPools; ++pool)
+		{
+			if (index < PoolSize( pool ))
+			{
+				return PoolEntity( pool, index );
+			}
+			index -= PoolSize( pool );
+		}
+		return 0;
 	}
 
 	// Return the entity with the given UID
 	CEntity* GetEntity( TEntityUID UID )
 	{
 		// Find the entity UID in the entity hash map
-		TUInt32 entityIndex;
-		if (!m_EntityUIDMap->LookUpKey( UID, &entityIndex ))
+		TUInt32 entityLocation;
+		if (!m_EntityUIDMap->LookUpKey( UID, &entityLocation ))
 		{
 			return 0;
 		}
-		return m_Entities[entityIndex];
+		return PoolEntity( entityLocation >> kPoolShift, entityLocation & kPoolIndexMask );
 	}
 
 	// Return the entity with the given name & optionally the given template name & type
 	CEntity* GetEntity( const string& name, const string& templateName = "",
 	                    const string& templateType = "" )
 	{
-		TEntityIter entity = m_Entities.begin();
-		while (entity != m_Entities.end())
+		TUInt32 templateNameID = TemplateNameID( templateName );
+		TUInt32 templateTypeID = TemplateTypeID( templateType );
+		for (TUInt32 pool = 0; pool < NumEntityPools; ++pool)
 		{
-			if ((*entity)->GetName() == name && 
-				(templateName.length() == 0 || (*entity)->Template()->GetName() == templateName) &&
-				(templateType.length() == 0 || (*entity)->Template()->GetType() == templateType))
+			for (TUInt32 index = 0; index < PoolSize( pool ); ++index)
 			{
-				return (*entity);
+				CEntity* entity = PoolEntity( pool, index );
+				if (entity->GetName() == name && 
+					(templateNameID == kAnyTemplateID || entity->Template()->GetNameID() == templateNameID) &&
+					(templateTypeID == kAnyTemplateID || entity->Template()->GetTypeID() == templateTypeID))
+				{
+					return entity;
+				}
 			}
-			++entity;
 		}
 		return 0;
 	}
 
-
-	// Begin an enumeration of entities matching given name, template name and type
-	// An empty string indicates to match anything in this field (would be nice to support
-	// wildcards, e.g. match name of "Ship*")
-	void BeginEnumEntities( const string& name, const string& templateName,
-	                        const string& templateType = "" )
+	// Return the number of entities whose template has the given type ID
+	TUInt32 NumEntitiesOfType( TUInt32 templateTypeID )
 	{
-		m_IsEnumerating = true;
-		m_EnumEntity = m_Entities.begin();
-		m_EnumName = name;
-		m_EnumTemplateName = templateName;
-		m_EnumTemplateType = templateType;
+		if (templateTypeID >= m_TypeEntities.size())
+		{
+			return 0;
+		}
+		return static_cast<TUInt32>(m_TypeEntities[templateTypeID].size());
 	}
 
-	// Finish enumerating entities (see above)
-	void EndEnumEntities()
+	// Return the entity at the given index among those whose template has the given type ID
+	CEntity* GetEntityOfType( TUInt32 templateTypeID, TUInt32 index )
 	{
-		m_IsEnumerating = false;
+		return m_TypeEntities[templateTypeID][index];
 	}
 
-	// Return next entity matching parameters passed to a previous call to BeginEnumEntities
-	// Returns 0 if BeginEnumEntities not called or no more matching entities
-	CEntity* EnumEntity()
+
+	/////////////////////////////////////
+	// Entity queries
+
+	// An entity query steps through the entities matching a template type ID and template name
+	// ID, either of which may be kAnyTemplateID. Queries are small objects held on the stack
+	// and are used with range-based for loops, e.g:
+	//     for (CEntity* entity : EntityManager.QueryEntities( tankTypeID )) { ... }
+	// Each query holds its own position, so queries can be nested or run on several threads at
+	// once. Entities created during a query will be visited if they match. Destroying entities
+	// during a query is safe, but the entity moved into the destroyed entity's place may be
+	// skipped. When a type is given only entities of that type are visited
+	class CEntityQuery
 	{
-		if (!m_IsEnumerating)
+	public:
+		// Query iterator, holds the position of the query
+		class CIterator
 		{
-			return 0;
-		}
+		public:
+			// Constructor finds the first matching entity from the given query. Pass a null query
+			// for an end iterator
+			CIterator( CEntityQuery* query )
+			{
+				m_Query = query;
+				m_Pool = 0;
+				m_Index = 0;
+				m_Entity = 0;
+				if (m_Query)
+				{
+					FindMatch();
+				}
+			}
 
-		while (m_EnumEntity != m_Entities.end())
-		{
-			if ((m_EnumName.length() == 0 || (*m_EnumEntity)->GetName() == m_EnumName) && 
-				(m_EnumTemplateName.length() == 0 ||
-				 (*m_EnumEntity)->Template()->GetName() == m_EnumTemplateName) &&
-				(m_EnumTemplateType.length() == 0 ||
-				 (*m_EnumEntity)->Template()->GetType() == m_EnumTemplateType))
+			CEntity* operator*()
 			{
-				CEntity* foundEntity = *m_EnumEntity;
-				++m_EnumEntity;
-				return foundEntity;
+				return m_Entity;
 			}
-			++m_EnumEntity;
-		}
-		
-		m_IsEnumerating = false;
-		return 0;
-	}
 
-	struct SPatrolPoints
-	{
-		int teamNum;
-		CVector3 PatrolPoints;
-	};
+			// Step to the next matching entity
+			CIterator& operator++()
+			{
+				++m_Index;
+				FindMatch();
+				return *this;
+			}
 
-	void PushPatrolPoints(SPatrolPoints points) { m_PatrolPoints.push_back(points); }
+			// Iterators differ if they are on different entities - the end iterator has none
+			bool operator!=( const CIterator& other ) const
+			{
+				return m_Entity != other.m_Entity;
+			}
 
-	SPatrolPoints GetPatrolPoints(int team)
-	{
-		SPatrolPoints pt;
-		pt = m_PatrolPoints[Random(0, m_PatrolPoints.size())];
-		if (team == 0)
-		{
-			while(pt.teamNum != 0)
+		private:
+			// Find the first matching entity at or after the current position, sets the entity to
+			// 0 if there are no more. Steps through the membership list for the type if given,
+			// otherwise through each pool
+			void FindMatch()
 			{
-				pt = m_PatrolPoints[Random(0, m_PatrolPoints.size())];
+				CEntityManager* manager = m_Query->m_Manager;
+				while (true)
+				{
+					if (m_Query->m_TemplateTypeID != kAnyTemplateID)
+					{
+						if (m_Index >= manager->NumEntitiesOfType( m_Query->m_TemplateTypeID ))
+						{
+							break;
+						}
+						m_Entity = manager->GetEntityOfType( m_Query->m_TemplateTypeID, m_Index );
+					}
+					else
+					{
+						if (m_Pool >= NumEntityPools)
+						{
+							break;
+						}
+						if (m_Index >= manager->PoolSize( m_Pool ))
+						{
+							++m_Pool;
+							m_Index = 0;
+							continue;
+						}
+						m_Entity = manager->PoolEntity( m_Pool, m_Index );
+					}
+
+					if (m_Query->m_TemplateNameID == kAnyTemplateID ||
+					    m_Entity->Template()->GetNameID() == m_Query->m_TemplateNameID)
+					{
+						return;
+					}
+					++m_Index;
+				}
+				m_Entity = 0;
 			}
+
+			CEntityQuery* m_Query;
+			TUInt32       m_Pool;
+			TUInt32       m_Index;
+			CEntity*      m_Entity;
+		};
+
+		// Constructor takes the manager to query and the template type and name IDs to match
+		CEntityQuery( CEntityManager* manager, TUInt32 templateTypeID, TUInt32 templateNameID )
+		{
+			m_Manager = manager;
+			m_TemplateTypeID = templateTypeID;
+			m_TemplateNameID = templateNameID;
 		}
-		else if (team == 1)
+
+		// Range support
+		CIterator begin()
 		{
-			while (pt.teamNum != 1)
-			{
-				pt = m_PatrolPoints[Random(0, m_PatrolPoints.size())];
-			}
+			return CIterator( this );
+		}
+		CIterator end()
+		{
+			return CIterator( 0 );
 		}
-		return pt;
+
+	private:
+		CEntityManager* m_Manager;
+		TUInt32         m_TemplateTypeID;
+		TUInt32         m_TemplateNameID;
+	};
+
+	// Return a query over entities matching the given template type ID and template name ID
+	CEntityQuery QueryEntities( TUInt32 templateTypeID, TUInt32 templateNameID = kAnyTemplateID )
+	{
+		return CEntityQuery( this, templateTypeID, templateNameID );
+	}
+
+	// Return a query over entities matching the given template type and template name. An empty
+	// string matches anything. The strings are only used to look up IDs when creating the query.
+	// New strings are interned, so call this version from the main thread only
+	CEntityQuery QueryEntities( const string& templateType, const string& templateName = "" )
+	{
+		return CEntityQuery( this, TemplateTypeID( templateType ), TemplateNameID( templateName ) );
+	}
+
+
+	/////////////////////////////////////
+	// Spatial queries
+
+	// Return the nearest tank, shell or ammo box to a point within the given radius, matching the
+	// given template type ID (kAnyTemplateID for any) and team filter. Returns 0 if there is none
+	// Static scenery (base class entities) is not held in the spatial index. Optionally returns
+	// the entity's position as of the last update pass through the given pointer - use this
+	// rather than the entity's matrix during updates, as the entity may be updating on another
+	// thread
+	CEntity* FindNearestEntity( const CVector3& point, TFloat32 radius,
+	                            TUInt32 templateTypeID = kAnyTemplateID,
+	                            ETeamFilter teamFilter = Team_Any, TUInt32 team = kNoTeam,
+	                            CVector3* position = 0 )
+	{
+		return m_SpatialGrid.FindNearest( point, radius, templateTypeID, teamFilter, team, position );
 	}
+
+	// Add the tanks, shells and ammo boxes within a radius of a point that match the given
+	// template type ID and team filter to a vector. Returns the number of entities found
+	TUInt32 FindEntitiesInRadius( const CVector3& point, TFloat32 radius, vector<CEntity*>& results,
+	                              TUInt32 templateTypeID = kAnyTemplateID,
+	                              ETeamFilter teamFilter = Team_Any, TUInt32 team = kNoTeam )
+	{
+		return m_SpatialGrid.FindInRadius( point, radius, results, templateTypeID, teamFilter, team );
+	}
+
+
+	// Return the patrol points of each team, loaded with the level
+	CPatrolPoints& PatrolPoints()
+	{
+		return m_PatrolPoints;
+	}
+
+	// Set the seed for the random number generators of entities created from now on. Each
+	// entity that needs random numbers has its own generator, seeded with this and its UID
+	void SetRandomSeed( TUInt64 seed )
+	{
+		m_RandomSeed = seed;
+	}
+
+	// Return the seed for the random number generators of entities
+	TUInt64 GetRandomSeed()
+	{
+		return m_RandomSeed;
+	}
+
+	// Scores may be increased by entity updates on any thread
 	void TeamOneScore() { m_TeamOneScore++; }
 	void TeamTwoScore() { m_TeamTwoScore++; }
 
@@ -267,12 +437,30 @@ public:
 	/////////////////////////////////////
 	// Update / Rendering
 
+	// Start threads to share entity updates, pass the total number of threads including the
+	// calling thread, or 0 for one per hardware thread. Entities are updated on the calling
+	// thread alone until this is called
+	void StartThreads( TUInt32 numThreads = 0 );
+
+	// Stop the threads sharing entity updates
+	void StopThreads();
+
+	// Return the command buffer for the current thread. Entity updates record changes outside the
+	// entity here, they are made at the end of UpdateAllEntities
+	CCommandBuffer& Commands()
+	{
+		return *m_CommandBuffers[CJobSystem::ThreadIndex()];
+	}
+
 	// Call all entity update functions - not the ideal method, OK for this example
-	// Pass the time since last update
+	// Pass the time since last update. The world matrices of the updated entities are then
+	// calculated in a single pass
 	void UpdateAllEntities( float updateTime );
 
 	// Render all entities - not the ideal method, OK for this example
-	void RenderAllEntities();
+	// Pass the fraction of time (0 to 1) from the previous simulation step to the latest,
+	// entities that moved in the latest step are rendered part way between the two
+	void RenderAllEntities( TFloat32 interpolation = 1.0f );
 
 		
 /////////////////////////////////////
@@ -286,9 +474,108 @@ private:
 	typedef map<string, CEntityTemplate*> TTemplates;
 	typedef TTemplates::iterator TTemplateIter;
 
-	// Entity instances are held in a vector, define some types for convenience
-	typedef vector<CEntity*> TEntities;
-	typedef TEntities::iterator TEntityIter;
+	// Interned template types and names are held in maps from string to ID
+	typedef map<string, TUInt32> TTemplateIDs;
+	typedef TTemplateIDs::iterator TTemplateIDIter;
+
+	// Membership list of the entities using templates of a particular type
+	typedef vector<CEntity*> TEntityList;
+
+	// Entity instances are held in a pool for each entity class
+	enum EEntityPool
+	{
+		Pool_Entity,
+		Pool_Tank,
+		Pool_Shell,
+		Pool_AmmoBox,
+		NumEntityPools
+	};
+
+	// The UID map holds the location of each entity - its pool in the top bits and its index
+	// within that pool in the remaining bits
+	static const TUInt32 kPoolShift = 28;
+	static const TUInt32 kPoolIndexMask = (1 << kPoolShift) - 1;
+
+	// The shell pool is allocated up front with room for this many shells. Shells are created and
+	// destroyed constantly in battle, so this avoids any memory allocation for them. The pool
+	// grows by the same amount again if it is ever full
+	static const TUInt32 kShellPoolCapacity = 256;
+
+
+	/////////////////////////////////////
+	// Pool access
+
+	// Return the number of entities in the given pool
+	TUInt32 PoolSize( TUInt32 pool )
+	{
+		switch (pool)
+		{
+			case Pool_Entity:  return m_Entities.Size();
+			case Pool_Tank:    return m_Tanks.Size();
+			case Pool_Shell:   return m_Shells.Size();
+			case Pool_AmmoBox: return m_AmmoBoxes.Size();
+		}
+		return 0;
+	}
+
+	// Return the entity at the given index in the given pool
+	CEntity* PoolEntity( TUInt32 pool, TUInt32 index )
+	{
+		switch (pool)
+		{
+			case Pool_Entity:  return m_Entities.GetAt( index );
+			case Pool_Tank:    return m_Tanks.GetAt( index );
+			case Pool_Shell:   return m_Shells.GetAt( index );
+			case Pool_AmmoBox: return m_AmmoBoxes.GetAt( index );
+		}
+		return 0;
+	}
+
+	// Return the shared mesh for a new template, loading it if no other template uses it. Reports
+	// the error and returns 0 if the mesh cannot be loaded
+	CMesh* AcquireTemplateMesh( const string& mesh );
+
+	// Add a newly created template to the template map, assigning its type and name IDs
+	void AddTemplate( CEntityTemplate* newTemplate );
+
+	// Delete a template, releasing its mesh
+	void DeleteTemplate( CEntityTemplate* entityTemplate );
+
+	// Return the interned ID for the given string from an ID map, adding it if new
+	TUInt32 InternTemplateID( TTemplateIDs& templateIDs, const string& key );
+
+	// Add the UID of a newly created entity to the UID map and its type's membership list, then
+	// return the UID. While committing commands the UID is added to the maps later, together
+	// with the other new entities
+	TEntityUID AddEntityUID( TUInt32 pool, TUInt32 index );
+
+	// Destroy the entity at the given index in a pool, updating the UID map for any entity that
+	// moves to fill the gap
+	template <class TEntityType>
+	void DestroyPoolEntity( CEntityPool<TEntityType>& entities, TUInt32 pool, TUInt32 index );
+
+	// Update all entities in a pool, recording the destruction of those whose update returns false
+	template <class TEntityType>
+	void UpdatePoolEntities( CEntityPool<TEntityType>& entities, TUInt32 pool, float updateTime );
+
+	// Find the shells that hit an enemy tank during their latest update, sending each tank hit a
+	// message and destroying the shell. Shells are tested together after they have all moved
+	void CollideShells();
+
+	// Test the path of a sphere from start to end against the bounding box of a tank's mesh,
+	// placed with the tank's matrix. Returns true on a hit, with the fraction of the path (0 to 1)
+	// at the point of contact through the given pointer
+	bool SweepSphereTank( const CVector3& start, const CVector3& end, TFloat32 radius,
+	                      CTankEntity* tank, TFloat32* hitTime );
+
+	// Calculate the world matrices of the entities in a pool whose matrices have changed
+	template <class TEntityType>
+	void UpdatePoolWorldMatrices( CEntityPool<TEntityType>& entities );
+
+	// Commit the commands recorded during the update, in the order of the entities that recorded
+	// them, then clear the command buffers. Entities are created first, then added to the UID
+	// maps in bulk, then entities are destroyed
+	void CommitCommands();
 
 
 	/////////////////////////////////////
@@ -297,39 +584,101 @@ private:
 	// The map of template names / templates
 	TTemplates m_Templates;
 
+	// The meshes used by the templates, each loaded once however many templates use it
+	CMeshManager m_MeshManager;
+
+	// Meshes loaded by PreloadMeshes for templates not yet created
+	vector<CMesh*> m_PreloadedMeshes;
+
+	// Interned template type and name IDs
+	TTemplateIDs m_TemplateTypeIDs;
+	TTemplateIDs m_TemplateNameIDs;
+
 
 	/////////////////////////////////////
 	// Entity Data
 
-	// The main list of entities. This vector is kept packed - i.e. with no gaps. If an
-	// entity is removed from the middle of the list, the last entity is moved down to
-	// fill its space
-	TEntities m_Entities;
-
-	// A mapping from UIDs to indexes into the above array
+	// The entity pools, one for each entity class. Each pool keeps a packed list of its
+	// entities - i.e. with no gaps. If an entity is removed from the middle of the list, the
+	// last entity is moved down to fill its space. Each pool also holds the node matrices of its
+	// entities in a contiguous arena.
+	// Base class entities are static scenery and form a separate partition from the others: they
+	// are not updated, not held in the spatial index and their world matrices are calculated
+	// only when created (or when rendered after being changed)
+	CEntityPool<CEntity>        m_Entities;
+	CEntityPool<CTankEntity>    m_Tanks;
+	CEntityPool<CShellEntity>   m_Shells;
+	CEntityPool<CAmmoBoxEntity> m_AmmoBoxes;
+
+	// A mapping from UIDs to locations (pool and index) in the above pools
 	CHashTable<TEntityUID, TUInt32>* m_EntityUIDMap;
 
+	// Membership lists of entities for each template type ID, kept packed like the pools. Also
+	// a mapping from UIDs to indexes into these lists
+	vector<TEntityList>              m_TypeEntities;
+	CHashTable<TEntityUID, TUInt32>* m_TypeIndexMap;
+
+	// Spatial index of the entities in the tank, shell and ammo box pools. Updated after each
+	// pool's update pass, so queries during a pass see positions from before it
+	CSpatialGrid m_SpatialGrid;
+
+	// Largest bounding radius of any tank created, including its scaling. Used to find the tanks
+	// that a shell may have hit
+	TFloat32 m_MaxTankRadius;
+
+	// Template type ID of the "Tank" type, or kAnyTemplateID if no tank template has been created
+	TUInt32 m_TankTypeID;
+
 	// Entity IDs are provided using a single increasing integer
 	TEntityUID m_NextUID;
 
+	// Seed for the random number generators of entities
+	TUInt64 m_RandomSeed;
+
+
+
+	atomic<int> m_TeamOneScore;
+	atomic<int> m_TeamTwoScore;
+	
+
+	CPatrolPoints m_PatrolPoints;
+
 
 	/////////////////////////////////////
-	// Data for Entity Enumeration
+	// Threading Data
 
-	bool        m_IsEnumerating;
-	TEntityIter m_EnumEntity;
-	string      m_EnumName;
-	string      m_EnumTemplateName;
-	string      m_EnumTemplateType;
+	// Number of entities in each chunk of an update pass, and of a world matrix pass. Pools no
+	// larger than this are updated on the calling thread without involving the workers
+	static const TUInt32 kUpdateChunkSize = 32;
+	static const TUInt32 kWorldMatrixChunkSize = 128;
 
+	// Command sections recorded by the shell collision pass are ordered after those of all the
+	// update passes, using this in place of a pool number
+	static const TUInt32 kCollisionSectionPool = NumEntityPools;
 
-	int m_TeamOneScore = 0;
-	int m_TeamTwoScore = 0;
-	
+	// A section of commands in one of the command buffers
+	struct SCommandSection
+	{
+		TUInt32 order;
+		TUInt32 buffer;
+		TUInt32 section;
+	};
 
-	vector<SPatrolPoints> m_PatrolPoints;
+	// Job system sharing entity updates between threads
+	CJobSystem m_JobSystem;
 
-	
+	// A command buffer for each job system thread, and space used to sort their sections
+	vector<CCommandBuffer*> m_CommandBuffers;
+	vector<SCommandSection> m_CommandSections;
+
+	// Space for each job system thread to list the tanks near a shell during collision
+	vector< vector<CEntity*> > m_CollisionCandidates;
+
+	// While committing commands, new entities are held here until added to the UID maps together
+	bool               m_CommittingCommands;
+	vector<TEntityUID> m_NewUIDs;
+	vector<TUInt32>    m_NewLocations;
+	vector<TUInt32>    m_NewTypeIndexes;
 };
 
 
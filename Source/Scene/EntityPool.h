@@ -0,0 +1,181 @@
+/*******************************************
+	EntityPool.h
+
+	Contiguous storage for entities of a
+	single class
+********************************************/
+
+#pragma once
+
+#include <vector>
+#include <new>
+#include <utility>
+using namespace std;
+
+#include "Defines.h"
+#include "MatrixArena.h"
+
+namespace gen
+{
+
+// An entity pool holds all the entities of one concrete class in large contiguous chunks of
+// memory rather than as individually allocated objects. Entities never move once created so
+// pointers to them remain valid until they are destroyed. Freed slots are kept in a free list
+// and reused by later entities, so steady state creation and destruction does not touch the
+// heap for the entity objects themselves.
+// The pool also holds the node matrices of its entities in a matrix arena, indexed by the same
+// slots, so recycling slots does not touch the heap at all.
+// The live entities are also listed in a packed array so they can be walked linearly. As with
+// the entity manager's UID map, removing an entity moves the last entity into the empty place
+template <class TEntityType>
+class CEntityPool
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+
+	// Constructor - entity storage is allocated in chunks of the given number of entities
+	CEntityPool( TUInt32 chunkSize = 256 )
+	{
+		m_ChunkSize = chunkSize;
+	}
+
+	// Destructor destroys any remaining entities and releases the storage
+	~CEntityPool()
+	{
+		DestroyAll();
+		for (TUInt32 chunk = 0; chunk < m_Chunks.size(); ++chunk)
+		{
+			::operator delete( m_Chunks[chunk] );
+		}
+	}
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CEntityPool( const CEntityPool& );
+	CEntityPool& operator=( const CEntityPool& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Return the number of live entities in the pool
+	TUInt32 Size()
+	{
+		return static_cast<TUInt32>(m_Entities.size());
+	}
+
+	// Return the live entity at the given index in the packed list
+	TEntityType* GetAt( TUInt32 index )
+	{
+		return m_Entities[index];
+	}
+
+	// Return the arena holding the node matrices of the entities
+	CMatrixArena& Matrices()
+	{
+		return m_Matrices;
+	}
+
+	// Allocate storage up front so the given number of entities can be live at once without the
+	// pool allocating any more memory
+	void Reserve( TUInt32 numEntities )
+	{
+		while (m_Chunks.size() * m_ChunkSize < numEntities)
+		{
+			AllocateChunk();
+		}
+	}
+
+	// Construct a new entity in a free slot, passing the given parameters to its constructor
+	// followed by the pool's matrix arena and the slot index. Returns the index of the new entity
+	// in the packed list
+	template <typename... TArgs>
+	TUInt32 Create( TArgs&&... args )
+	{
+		if (m_FreeSlots.empty())
+		{
+			AllocateChunk();
+		}
+		TUInt32 slot = m_FreeSlots.back();
+
+		// Construct entity in place before removing the slot from the free list, in case the
+		// constructor throws
+		void* slotAddress = m_Chunks[slot / m_ChunkSize] + (slot % m_ChunkSize) * sizeof(TEntityType);
+		TEntityType* newEntity = new (slotAddress) TEntityType( forward<TArgs>(args)..., &m_Matrices, slot );
+		m_FreeSlots.pop_back();
+
+		TUInt32 index = static_cast<TUInt32>(m_Entities.size());
+		m_Entities.push_back( newEntity );
+		m_EntitySlots.push_back( slot );
+		return index;
+	}
+
+	// Destroy the entity at the given index in the packed list. If not removing the last entity
+	// then the last entity is moved into the given index - that entity is returned so the
+	// caller can update any references to its index. Returns 0 otherwise
+	TEntityType* DestroyAt( TUInt32 index )
+	{
+		m_Entities[index]->~TEntityType();
+		m_FreeSlots.push_back( m_EntitySlots[index] );
+
+		TEntityType* movedEntity = 0;
+		if (index != m_Entities.size() - 1)
+		{
+			movedEntity = m_Entities.back();
+			m_Entities[index] = movedEntity;
+			m_EntitySlots[index] = m_EntitySlots.back();
+		}
+		m_Entities.pop_back();
+		m_EntitySlots.pop_back();
+		return movedEntity;
+	}
+
+	// Destroy all entities in the pool, the storage is kept for reuse
+	void DestroyAll()
+	{
+		while (m_Entities.size())
+		{
+			DestroyAt( static_cast<TUInt32>(m_Entities.size() - 1) );
+		}
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Allocate a new chunk of entity storage, and matrices for its slots, and add its slots to
+	// the free list
+	void AllocateChunk()
+	{
+		TUInt32 firstSlot = static_cast<TUInt32>(m_Chunks.size()) * m_ChunkSize;
+		m_Chunks.push_back( static_cast<TUInt8*>(::operator new( m_ChunkSize * sizeof(TEntityType) )) );
+		m_Matrices.ReserveSlots( firstSlot + m_ChunkSize );
+
+		// Add slots in reverse so entities are created in memory order
+		for (TUInt32 slot = firstSlot + m_ChunkSize; slot > firstSlot; --slot)
+		{
+			m_FreeSlots.push_back( slot - 1 );
+		}
+	}
+
+	// Number of entities held in each chunk of storage
+	TUInt32 m_ChunkSize;
+
+	// Chunks of storage for entities, and the unused slots within them. Slots are numbered
+	// through the chunks in order
+	vector<TUInt8*> m_Chunks;
+	vector<TUInt32> m_FreeSlots;
+
+	// Relative and absolute node matrices for each slot
+	CMatrixArena m_Matrices;
+
+	// Packed list of the live entities and the slot each is in
+	vector<TEntityType*> m_Entities;
+	vector<TUInt32>      m_EntitySlots;
+};
+
+
+} // namespace gen
@@ -0,0 +1,130 @@
+/*******************************************
+	MatrixArena.h
+
+	Contiguous storage for the node matrices
+	of the entities in an entity pool
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "CMatrix4x4.h"
+
+namespace gen
+{
+
+// A matrix arena holds the relative and absolute node matrices for every slot of an entity pool,
+// as separate contiguous streams, along with the absolute matrices from the previous simulation
+// step for interpolation. Each slot has the same number of matrices in each stream,
+// enough for the entity with the most nodes, so a slot's matrices are found by multiplying its
+// index. Entities refer to their matrices by slot index rather than by pointer, which allows the
+// arena to reallocate its streams when it grows
+class CMatrixArena
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Constructor - the arena starts empty
+	CMatrixArena()
+	{
+		m_NumSlots = 0;
+		m_NodesPerSlot = 0;
+	}
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CMatrixArena( const CMatrixArena& );
+	CMatrixArena& operator=( const CMatrixArena& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Return the number of slots and the number of matrices per slot in each stream
+	TUInt32 NumSlots()
+	{
+		return m_NumSlots;
+	}
+	TUInt32 NodesPerSlot()
+	{
+		return m_NodesPerSlot;
+	}
+
+	// Make room for at least the given number of slots, existing matrices are kept
+	void ReserveSlots( TUInt32 numSlots )
+	{
+		if (numSlots > m_NumSlots)
+		{
+			Layout( numSlots, m_NodesPerSlot );
+		}
+	}
+
+	// Make room for at least the given number of matrices in each slot, existing matrices are
+	// kept at the same node index in their slot
+	void ReserveNodes( TUInt32 numNodes )
+	{
+		if (numNodes > m_NodesPerSlot)
+		{
+			Layout( m_NumSlots, numNodes );
+		}
+	}
+
+	// Return the relative, absolute or previous absolute matrices for the given slot. Only valid
+	// until the arena next grows
+	CMatrix4x4* RelMatrices( TUInt32 slot )
+	{
+		return &m_RelMatrices[slot * m_NodesPerSlot];
+	}
+	CMatrix4x4* Matrices( TUInt32 slot )
+	{
+		return &m_Matrices[slot * m_NodesPerSlot];
+	}
+	CMatrix4x4* PrevMatrices( TUInt32 slot )
+	{
+		return &m_PrevMatrices[slot * m_NodesPerSlot];
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Reallocate the streams for the given number of slots and matrices per slot, copying the
+	// existing matrices to their new places
+	void Layout( TUInt32 numSlots, TUInt32 nodesPerSlot )
+	{
+		vector<CMatrix4x4> relMatrices( numSlots * nodesPerSlot );
+		vector<CMatrix4x4> matrices( numSlots * nodesPerSlot );
+		vector<CMatrix4x4> prevMatrices( numSlots * nodesPerSlot );
+		for (TUInt32 slot = 0; slot < m_NumSlots; ++slot)
+		{
+			for (TUInt32 node = 0; node < m_NodesPerSlot; ++node)
+			{
+				relMatrices[slot * nodesPerSlot + node] = m_RelMatrices[slot * m_NodesPerSlot + node];
+				matrices[slot * nodesPerSlot + node] = m_Matrices[slot * m_NodesPerSlot + node];
+				prevMatrices[slot * nodesPerSlot + node] = m_PrevMatrices[slot * m_NodesPerSlot + node];
+			}
+		}
+		m_RelMatrices.swap( relMatrices );
+		m_Matrices.swap( matrices );
+		m_PrevMatrices.swap( prevMatrices );
+		m_NumSlots = numSlots;
+		m_NodesPerSlot = nodesPerSlot;
+	}
+
+	// Number of slots and number of matrices per slot
+	TUInt32 m_NumSlots;
+	TUInt32 m_NodesPerSlot;
+
+	// The relative, absolute and previous absolute matrix streams
+	vector<CMatrix4x4> m_RelMatrices;
+	vector<CMatrix4x4> m_Matrices;
+	vector<CMatrix4x4> m_PrevMatrices;
+};
+
+
+} // namespace gen
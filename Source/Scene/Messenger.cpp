@@ -4,6 +4,7 @@
 	Entity messenger class implementation
 ********************************************/
 
+#include "Error.h"
 #include "Messenger.h"
 
 namespace gen
@@ -16,38 +17,267 @@ namespace gen
 CMessenger Messenger;
 
 
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Default constructor
+CMessenger::CMessenger()
+{
+	m_NumSent = 0;
+	for (TUInt32 chunk = 0; chunk < kMaxChunks; ++chunk)
+	{
+		m_SentChunks[chunk] = 0;
+	}
+	m_MailboxIndex = new CHashTable<TEntityUID, TUInt32>( 1024, IntegerHash );
+	m_ChannelIndex = new CHashTable<TUInt32, TUInt32>( 16, IntegerHash );
+}
+
+// Destructor frees message storage
+CMessenger::~CMessenger()
+{
+	delete m_ChannelIndex;
+	delete m_MailboxIndex;
+	for (TUInt32 chunk = 0; chunk < kMaxChunks; ++chunk)
+	{
+		delete[] m_SentChunks[chunk].load();
+	}
+}
+
+
 /////////////////////////////////////
 // Message sending/receiving
 
-// Send the given message to a particular UID, does not check if the UID exists
+// Send the given message to a particular UID, does not check if the UID exists. The message
+// can be fetched after the next call to DeliverMessages. Can be called from several threads
 void CMessenger::SendMessage( TEntityUID to, const SMessage& msg )
 {
-	// Simply insert the UID/message pair into the message map. It will be inserted next
-	// to any other pairs with the same UID
-	m_Messages.insert( UIDMsgPair( to, msg ) );
+	QueueMessage( kDirectChannel, to, msg );
+}
+
+// Broadcast the given message to all entities that read broadcast messages. Delivered in the
+// same way as SendMessage
+void CMessenger::BroadcastMessage( const SMessage& msg )
+{
+	QueueMessage( kBroadcastChannel, 0, msg );
+}
+
+// Send the given message to all entities in a team that read team messages. Delivered in the
+// same way as SendMessage
+void CMessenger::SendTeamMessage( TUInt32 team, const SMessage& msg )
+{
+	GEN_ASSERT( team < kBroadcastChannel, "Invalid team number" );
+	QueueMessage( team, 0, msg );
+}
+
+// Add a message to those waiting for delivery, lock-free
+void CMessenger::QueueMessage( TUInt32 channel, TEntityUID to, const SMessage& msg )
+{
+	// Reserve a slot for the message, each sender gets a different slot
+	TUInt32 slot = m_NumSent.fetch_add( 1 );
+	TUInt32 chunk = slot / kChunkSize;
+	GEN_ASSERT( chunk < kMaxChunks, "Too many messages sent in one tick" );
+
+	// Allocate the chunk holding the slot if this is the first time it has been used. If two
+	// senders allocate it at the same time then only one is kept
+	SSentMessage* chunkMessages = m_SentChunks[chunk].load( memory_order_acquire );
+	if (!chunkMessages)
+	{
+		SSentMessage* newChunk = new SSentMessage[kChunkSize];
+		if (m_SentChunks[chunk].compare_exchange_strong( chunkMessages, newChunk, memory_order_acq_rel ))
+		{
+			chunkMessages = newChunk;
+		}
+		else
+		{
+			delete[] newChunk;
+		}
+	}
+
+	SSentMessage& sentMessage = chunkMessages[slot % kChunkSize];
+	sentMessage.channel = channel;
+	sentMessage.to = to;
+	sentMessage.msg = msg;
 }
 
 
 // Fetch the next available message for the given UID, returns the message through the given 
-// pointer. Returns false if there are no messages for this UID
+// pointer. Returns false if there are no messages for this UID. Messages for different UIDs
+// can be fetched on different threads, but each UID's messages must be fetched by one thread
 bool CMessenger::FetchMessage( TEntityUID to, SMessage* msg )
 {
-	// Find the first message for this UID in the message map
-	TMessageIter itMessage = m_Messages.find( to );
-
-	// See if no messages for this UID
-	if (itMessage == m_Messages.end())
+	// Find the mailbox for this UID
+	TUInt32 mailboxIndex = FindMailbox( to );
+	if (mailboxIndex == kNoMailbox)
 	{
 		return false;
 	}
 
-	// Return message, then delete it
-	*msg = itMessage->second;
-	m_Messages.erase( itMessage );
+	// See if all messages have been fetched, otherwise return the next one
+	SMailbox& mailbox = m_Mailboxes[mailboxIndex];
+	if (mailbox.first == mailbox.end)
+	{
+		return false;
+	}
+	*msg = m_Delivered[mailbox.first++];
 
 	return true;
 }
 
 
+// Start reading the messages for the given UID and the broadcast messages
+CMessenger::CMessageReader CMessenger::ReadMessages( TEntityUID to )
+{
+	return CMessageReader( this, to, kDirectChannel );
+}
+
+// Start reading the messages for the given UID, the broadcast messages and the messages for
+// the given team
+CMessenger::CMessageReader CMessenger::ReadMessages( TEntityUID to, TUInt32 team )
+{
+	GEN_ASSERT( team < kBroadcastChannel, "Invalid team number" );
+	return CMessageReader( this, to, team );
+}
+
+
+/////////////////////////////////////
+// Message reader
+
+// Constructor takes copies of the ranges of messages to read, pass kDirectChannel for no team
+CMessenger::CMessageReader::CMessageReader( CMessenger* messenger, TEntityUID to, TUInt32 team )
+{
+	m_Messenger = messenger;
+	m_DirectMailbox = messenger->FindMailbox( to );
+
+	TUInt32 mailboxes[NumReaderSources];
+	mailboxes[Source_Direct] = m_DirectMailbox;
+	mailboxes[Source_Broadcast] = messenger->FindChannelMailbox( kBroadcastChannel );
+	mailboxes[Source_Team] = (team == kDirectChannel) ? kNoMailbox : messenger->FindChannelMailbox( team );
+	for (TUInt32 source = 0; source < NumReaderSources; ++source)
+	{
+		if (mailboxes[source] == kNoMailbox)
+		{
+			m_First[source] = m_End[source] = 0;
+		}
+		else
+		{
+			m_First[source] = messenger->m_Mailboxes[mailboxes[source]].first;
+			m_End[source] = messenger->m_Mailboxes[mailboxes[source]].end;
+		}
+	}
+}
+
+// Return the next message, or 0 if there are no more
+const SMessage* CMessenger::CMessageReader::Next()
+{
+	// Choose the source whose next message was sent first
+	const vector<TUInt32>& slots = m_Messenger->m_DeliveredSlots;
+	TUInt32 nextSource = NumReaderSources;
+	for (TUInt32 source = 0; source < NumReaderSources; ++source)
+	{
+		if (m_First[source] < m_End[source] &&
+		    (nextSource == NumReaderSources || slots[m_First[source]] < slots[m_First[nextSource]]))
+		{
+			nextSource = source;
+		}
+	}
+	if (nextSource == NumReaderSources)
+	{
+		return 0;
+	}
+
+	// Direct messages are removed from the mailbox, channel messages stay for other readers
+	const SMessage* msg = &m_Messenger->m_Delivered[m_First[nextSource]++];
+	if (nextSource == Source_Direct)
+	{
+		m_Messenger->m_Mailboxes[m_DirectMailbox].first = m_First[Source_Direct];
+	}
+	return msg;
+}
+
+
+/////////////////////////////////////
+// Message delivery
+
+// Return the index of the mailbox for the given UID or channel, or kNoMailbox if there were no
+// messages delivered to it this tick. The indexes are not changed until the next delivery so
+// they are safe to look up from several threads
+TUInt32 CMessenger::FindMailbox( TEntityUID to )
+{
+	TUInt32 mailboxIndex;
+	return m_MailboxIndex->LookUpKey( to, &mailboxIndex ) ? mailboxIndex : kNoMailbox;
+}
+
+TUInt32 CMessenger::FindChannelMailbox( TUInt32 channel )
+{
+	TUInt32 mailboxIndex;
+	return m_ChannelIndex->LookUpKey( channel, &mailboxIndex ) ? mailboxIndex : kNoMailbox;
+}
+
+// Deliver all messages sent since the last call, making them available to FetchMessage. Any
+// messages delivered previously but not fetched are discarded. Call once at the start of each
+// tick, from one thread, while no messages are being sent or fetched
+void CMessenger::DeliverMessages()
+{
+	m_MailboxIndex->RemoveAllKeys();
+	m_ChannelIndex->RemoveAllKeys();
+	m_Mailboxes.clear();
+
+	TUInt32 numSent = m_NumSent.load( memory_order_acquire );
+	m_Delivered.resize( numSent );
+	m_DeliveredSlots.resize( numSent );
+	m_SentMailboxes.resize( numSent );
+
+	// Find the mailbox for each message, counting the messages for each UID or channel in its
+	// mailbox
+	for (TUInt32 slot = 0; slot < numSent; ++slot)
+	{
+		const SSentMessage& sentMessage = m_SentChunks[slot / kChunkSize][slot % kChunkSize];
+		TUInt32 mailboxIndex;
+		bool found = (sentMessage.channel == kDirectChannel) ?
+		             m_MailboxIndex->LookUpKey( sentMessage.to, &mailboxIndex ) :
+		             m_ChannelIndex->LookUpKey( sentMessage.channel, &mailboxIndex );
+		if (!found)
+		{
+			mailboxIndex = static_cast<TUInt32>(m_Mailboxes.size());
+			SMailbox newMailbox = { 0, 0 };
+			m_Mailboxes.push_back( newMailbox );
+			if (sentMessage.channel == kDirectChannel)
+			{
+				m_MailboxIndex->SetKeyValue( sentMessage.to, mailboxIndex );
+			}
+			else
+			{
+				m_ChannelIndex->SetKeyValue( sentMessage.channel, mailboxIndex );
+			}
+		}
+		++m_Mailboxes[mailboxIndex].end;
+		m_SentMailboxes[slot] = mailboxIndex;
+	}
+
+	// Give each mailbox a range of the delivered messages, initially empty so the end can be used
+	// to place the messages
+	TUInt32 first = 0;
+	for (TUInt32 mailboxIndex = 0; mailboxIndex < m_Mailboxes.size(); ++mailboxIndex)
+	{
+		TUInt32 numMessages = m_Mailboxes[mailboxIndex].end;
+		m_Mailboxes[mailboxIndex].first = first;
+		m_Mailboxes[mailboxIndex].end = first;
+		first += numMessages;
+	}
+
+	// Copy the messages into their mailboxes, they stay in the order they were sent
+	for (TUInt32 slot = 0; slot < numSent; ++slot)
+	{
+		const SSentMessage& sentMessage = m_SentChunks[slot / kChunkSize][slot % kChunkSize];
+		TUInt32 delivered = m_Mailboxes[m_SentMailboxes[slot]].end++;
+		m_Delivered[delivered] = sentMessage.msg;
+		m_DeliveredSlots[delivered] = slot;
+	}
+
+	// Start collecting the next tick's messages, the chunks are kept for reuse
+	m_NumSent.store( 0, memory_order_release );
+}
+
+
 
 } // namespace gen
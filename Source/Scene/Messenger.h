@@ -6,12 +6,21 @@
 
 #pragma once
 
-#include <map>
+#include <string.h>
+#include <vector>
+#include <atomic>
 using namespace std;
 
 #include "Defines.h"
+#include "CHashTable.h"
 #include "Entity.h"
 
+// Windows.h defines SendMessage as a macro for SendMessageA/W. Remove it so the messenger function
+// has the same name in every build (headless builds do not include Windows.h)
+#ifdef SendMessage
+	#undef SendMessage
+#endif
+
 namespace gen
 {
 
@@ -61,15 +70,21 @@ struct SMessage
 
 
 // Messenger class allows the sending and receipt of messages between entities - addressed by UID
+// Messages are double buffered by tick. Messages sent during one tick are collected together and
+// delivered in bulk at the start of the next tick (DeliverMessages), when they are sorted into a
+// mailbox for each recipient. Sending is lock-free so it can be done from several threads at once
+// Messages can also be broadcast to all entities or multicast to a team. These are stored once in
+// a channel and read in place by every entity that listens to the channel
 class CMessenger
 {
 /////////////////////////////////////
 //	Constructors/Destructors
 public:
 	// Default constructor
-	CMessenger() {}
+	CMessenger();
 
-	// No destructor needed
+	// Destructor frees message storage
+	~CMessenger();
 
 private:
 	// Disallow use of copy constructor and assignment operator (private and not defined)
@@ -84,28 +99,137 @@ public:
 	/////////////////////////////////////
 	// Message sending/receiving
 
-	// Send the given message to a particular UID, does not check if the UID exists
+	// Send the given message to a particular UID, does not check if the UID exists. The message
+	// can be fetched after the next call to DeliverMessages. Can be called from several threads
 	void SendMessage( TEntityUID to, const SMessage& msg );
 
 	// Fetch the next available message for the given UID, returns the message through the given 
-	// pointer. Returns false if there are no messages for this UID
+	// pointer. Returns false if there are no messages for this UID. Messages for different UIDs
+	// can be fetched on different threads, but each UID's messages must be fetched by one thread
 	bool FetchMessage( TEntityUID to, SMessage* msg );
 
+	// Broadcast the given message to all entities that read broadcast messages. Delivered in the
+	// same way as SendMessage
+	void BroadcastMessage( const SMessage& msg );
+
+	// Send the given message to all entities in a team that read team messages. Delivered in the
+	// same way as SendMessage
+	void SendTeamMessage( TUInt32 team, const SMessage& msg );
+
+
+	// A message reader reads the messages for a UID together with the broadcast messages and
+	// optionally those for a team, all in the order they were sent. Messages are returned by
+	// pointer to the messenger's storage, so broadcast and team messages are shared by all their
+	// readers rather than copied to each. Direct messages are removed as they are read, as with
+	// FetchMessage. Readers are only valid until the next delivery, e.g:
+	//     CMessenger::CMessageReader reader = Messenger.ReadMessages( uid, team );
+	//     while (const SMessage* msg = reader.Next()) { ... }
+	class CMessageReader
+	{
+	public:
+		// Return the next message, or 0 if there are no more
+		const SMessage* Next();
+
+	private:
+		friend class CMessenger;
+		CMessageReader( CMessenger* messenger, TEntityUID to, TUInt32 team );
+
+		// The sources of messages for the reader, each is a range of the delivered messages
+		enum EReaderSource
+		{
+			Source_Direct,
+			Source_Broadcast,
+			Source_Team,
+			NumReaderSources
+		};
+
+		CMessenger* m_Messenger;
+		TUInt32     m_DirectMailbox; // Index of mailbox for direct messages, updated as they are read
+		TUInt32     m_First[NumReaderSources];
+		TUInt32     m_End[NumReaderSources];
+	};
+
+	// Start reading the messages for the given UID and the broadcast messages
+	CMessageReader ReadMessages( TEntityUID to );
+
+	// Start reading the messages for the given UID, the broadcast messages and the messages for
+	// the given team
+	CMessageReader ReadMessages( TEntityUID to, TUInt32 team );
+
+	// Deliver all messages sent since the last call, making them available to FetchMessage. Any
+	// messages delivered previously but not fetched are discarded. Call once at the start of each
+	// tick, from one thread, while no messages are being sent or fetched
+	void DeliverMessages();
+
 
 /////////////////////////////////////
 //	Private interface
 private:
 
-	// A multimap has properties similar to a hash map - mapping a key to a value. Here we
-	// have the key as an entity UID and the value as a message for that UID. The stored
-	// key/value pairs in a multimap are sorted by key, which means all the messages for a
-	// particular UID are together. Key look-up is somewhat slower than for a hash map though
-	// Define some types to make usage easier
-	typedef multimap<TEntityUID, SMessage> TMessages;
-	typedef TMessages::iterator TMessageIter;
-    typedef pair<TEntityUID, SMessage> UIDMsgPair; // The type stored by the multimap
+	/////////////////////////////////////
+	// Types
+
+	// Channels for messages, teams use their team number as the channel
+	static const TUInt32 kDirectChannel    = 0xffffffff; // Sent to a single UID
+	static const TUInt32 kBroadcastChannel = 0xfffffffe;
+
+	// Mailbox index used when there is no mailbox
+	static const TUInt32 kNoMailbox = 0xffffffff;
+
+	// A message waiting for delivery, with the channel it was sent on and the UID it is addressed
+	// to if it was sent directly
+	struct SSentMessage
+	{
+		TUInt32    channel;
+		TEntityUID to;
+		SMessage   msg;
+	};
+
+	// The delivered messages for a UID are held together, the mailbox holds the range of them
+	// that have not yet been fetched
+	struct SMailbox
+	{
+		TUInt32 first;
+		TUInt32 end;
+	};
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Add a message to those waiting for delivery, lock-free
+	void QueueMessage( TUInt32 channel, TEntityUID to, const SMessage& msg );
+
+	// Return the index of the mailbox for the given UID or channel, or kNoMailbox if there were no
+	// messages delivered to it this tick
+	TUInt32 FindMailbox( TEntityUID to );
+	TUInt32 FindChannelMailbox( TUInt32 channel );
+
 
-	TMessages m_Messages;
+	/////////////////////////////////////
+	// Sent messages
+
+	// Sent messages are stored in chunks that are allocated when first needed and then kept.
+	// Senders reserve a slot by atomically incrementing the message count, so no locks are used
+	static const TUInt32 kChunkSize = 1024;
+	static const TUInt32 kMaxChunks = 4096;
+
+	atomic<TUInt32>       m_NumSent;
+	atomic<SSentMessage*> m_SentChunks[kMaxChunks];
+
+
+	/////////////////////////////////////
+	// Delivered messages
+
+	// Messages delivered this tick sorted by recipient along with the slot each was sent in (which
+	// gives the order they were sent), a mailbox for each recipient UID or channel, and mappings
+	// from recipient UID and channel to mailbox index
+	vector<SMessage>                 m_Delivered;
+	vector<TUInt32>                  m_DeliveredSlots;
+	vector<TUInt32>                  m_SentMailboxes; // Mailbox of each sent message, used in delivery
+	vector<SMailbox>                 m_Mailboxes;
+	CHashTable<TEntityUID, TUInt32>* m_MailboxIndex;
+	CHashTable<TUInt32, TUInt32>*    m_ChannelIndex;
 };
 
 
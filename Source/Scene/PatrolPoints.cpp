@@ -0,0 +1,362 @@
+/*******************************************
+	PatrolPoints.cpp
+
+	Patrol points for each team, with
+	bounded time point selection
+********************************************/
+
+#include <math.h>
+#include <algorithm>
+#include "PatrolPoints.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Setup
+
+// Add a patrol point for a team, in the given zone and with the given weight for weighted
+// selection. Build must be called after adding points and before selecting them
+void CPatrolPoints::AddPoint( TUInt32 team, const CVector3& position, TUInt32 zone /*= 0*/,
+                              TFloat32 weight /*= 1.0f*/ )
+{
+	if (team >= m_Teams.size())
+	{
+		m_Teams.resize( team + 1 );
+	}
+	m_Teams[team].positions.push_back( position );
+	m_Teams[team].zones.push_back( zone );
+	m_Teams[team].weights.push_back( weight > 0.0f ? weight : 0.0f );
+}
+
+// Sort and index the points added for selection
+void CPatrolPoints::Build()
+{
+	for (TUInt32 teamNum = 0; teamNum < m_Teams.size(); ++teamNum)
+	{
+		STeamPoints& team = m_Teams[teamNum];
+		TUInt32 numPoints = static_cast<TUInt32>(team.positions.size());
+
+		// Sort the points by zone, keeping their order within each zone
+		vector<TUInt32> order( numPoints );
+		for (TUInt32 point = 0; point < numPoints; ++point)
+		{
+			order[point] = point;
+		}
+		stable_sort( order.begin(), order.end(),
+		             [&]( TUInt32 a, TUInt32 b ) { return team.zones[a] < team.zones[b]; } );
+		vector<CVector3> positions( numPoints );
+		vector<TUInt32>  zones( numPoints );
+		vector<TFloat32> weights( numPoints );
+		for (TUInt32 point = 0; point < numPoints; ++point)
+		{
+			positions[point] = team.positions[order[point]];
+			zones[point] = team.zones[order[point]];
+			weights[point] = team.weights[order[point]];
+		}
+		team.positions.swap( positions );
+		team.zones.swap( zones );
+		team.weights.swap( weights );
+
+		// Record the range of each zone
+		team.zoneRanges.clear();
+		for (TUInt32 point = 0; point < numPoints; ++point)
+		{
+			if (point == 0 || team.zones[point] != team.zones[point - 1])
+			{
+				SRange range = { team.zones[point], point, 0 };
+				team.zoneRanges.push_back( range );
+			}
+			++team.zoneRanges.back().count;
+		}
+
+		BuildAliasTable( team );
+		BuildGrid( team );
+	}
+}
+
+// Remove all points
+void CPatrolPoints::Clear()
+{
+	m_Teams.clear();
+}
+
+
+/////////////////////////////////////
+// Selection
+
+// Select a point using the current policy, returning its position through the given pointer.
+// The tank's position, random number generator and visit record are used as the policy needs
+bool CPatrolPoints::SelectPoint( TUInt32 team, const CVector3& position, CRandom& random,
+                                 CPatrolVisits& visits, CVector3* point )
+{
+	TUInt32 index;
+	bool found = false;
+	switch (m_Policy)
+	{
+		case Patrol_Random:           found = RandomPoint( team, random, &index );  break;
+		case Patrol_Weighted:         found = WeightedPoint( team, random, &index );  break;
+		case Patrol_NearestUnvisited: found = NearestUnvisitedPoint( team, position, visits, &index );  break;
+	}
+	if (found)
+	{
+		*point = GetPoint( team, index );
+	}
+	return found;
+}
+
+// Select any of the team's points, each equally likely
+bool CPatrolPoints::RandomPoint( TUInt32 team, CRandom& random, TUInt32* point )
+{
+	TUInt32 numPoints = NumPoints( team );
+	if (numPoints == 0)
+	{
+		return false;
+	}
+	*point = random.Random( 0, numPoints - 1 );
+	return true;
+}
+
+// Select any of the team's points in the given zone, each equally likely
+bool CPatrolPoints::RandomPointInZone( TUInt32 team, TUInt32 zone, CRandom& random, TUInt32* point )
+{
+	if (team >= m_Teams.size())
+	{
+		return false;
+	}
+
+	// Teams have few zones, so they are searched directly
+	vector<SRange>& zoneRanges = m_Teams[team].zoneRanges;
+	for (TUInt32 range = 0; range < zoneRanges.size(); ++range)
+	{
+		if (zoneRanges[range].id == zone)
+		{
+			*point = zoneRanges[range].first + random.Random( 0, zoneRanges[range].count - 1 );
+			return true;
+		}
+	}
+	return false;
+}
+
+// Select any of the team's points, in proportion to their weights
+bool CPatrolPoints::WeightedPoint( TUInt32 team, CRandom& random, TUInt32* point )
+{
+	TUInt32 numPoints = NumPoints( team );
+	if (numPoints == 0)
+	{
+		return false;
+	}
+	STeamPoints& teamPoints = m_Teams[team];
+	TUInt32 index = random.Random( 0, numPoints - 1 );
+	*point = (random.Random( 0.0f, 1.0f ) < teamPoints.aliasProbabilities[index]) ?
+	         index : teamPoints.aliases[index];
+	return true;
+}
+
+// Select the point nearest to the given position that is not marked in the visit record, and
+// mark it visited. If all points are visited, the record is reset first
+bool CPatrolPoints::NearestUnvisitedPoint( TUInt32 team, const CVector3& position,
+                                           CPatrolVisits& visits, TUInt32* point )
+{
+	TUInt32 numPoints = NumPoints( team );
+	if (numPoints == 0)
+	{
+		return false;
+	}
+	if (visits.NumVisited() >= numPoints)
+	{
+		visits.Reset();
+	}
+	STeamPoints& teamPoints = m_Teams[team];
+
+	// Search rings of cells outwards from the position's cell. Points in ring r or beyond are at
+	// least (r - 1) cells away, so the search stops once a point has been found closer than that
+	TInt32 gridSize = static_cast<TInt32>(teamPoints.gridSize);
+	TInt32 centreX = GridCoord( teamPoints, position.x, teamPoints.gridMin.x );
+	TInt32 centreZ = GridCoord( teamPoints, position.z, teamPoints.gridMin.z );
+	TUInt32 nearest = numPoints;
+	TFloat32 nearestDistSq = 0.0f;
+	for (TInt32 ring = 0; ring < gridSize; ++ring)
+	{
+		if (nearest < numPoints && ring > 1)
+		{
+			TFloat32 ringDist = (ring - 1) * teamPoints.cellSize;
+			if (nearestDistSq <= ringDist * ringDist)
+			{
+				break;
+			}
+		}
+
+		// Visit the whole of the top and bottom rows of the ring, and only the ends of the rows
+		// between
+		for (TInt32 dz = -ring; dz <= ring; ++dz)
+		{
+			TInt32 cellZ = centreZ + dz;
+			if (cellZ < 0 || cellZ >= gridSize)
+			{
+				continue;
+			}
+			TInt32 step = (dz == -ring || dz == ring) ? 1 : 2 * ring;
+			for (TInt32 dx = -ring; dx <= ring; dx += step)
+			{
+				TInt32 cellX = centreX + dx;
+				if (cellX < 0 || cellX >= gridSize)
+				{
+					continue;
+				}
+				TUInt32 cell = cellZ * gridSize + cellX;
+				for (TUInt32 cellPoint = teamPoints.cellStarts[cell];
+				     cellPoint < teamPoints.cellStarts[cell + 1]; ++cellPoint)
+				{
+					TUInt32 index = teamPoints.cellPoints[cellPoint];
+					if (visits.IsVisited( index ))
+					{
+						continue;
+					}
+					TFloat32 x = teamPoints.positions[index].x - position.x;
+					TFloat32 z = teamPoints.positions[index].z - position.z;
+					TFloat32 distSq = x * x + z * z;
+					if (nearest == numPoints || distSq < nearestDistSq)
+					{
+						nearest = index;
+						nearestDistSq = distSq;
+					}
+				}
+			}
+		}
+	}
+
+	visits.Visit( nearest, numPoints );
+	*point = nearest;
+	return true;
+}
+
+
+/////////////////////////////////////
+// Private functions
+
+// Build the alias table for one team (Vose's method). Each point is given a probability and an
+// alias, such that choosing a point uniformly then keeping it with its probability (or else
+// taking its alias) selects points in proportion to their weights
+void CPatrolPoints::BuildAliasTable( STeamPoints& team )
+{
+	TUInt32 numPoints = static_cast<TUInt32>(team.positions.size());
+	team.aliasProbabilities.assign( numPoints, 1.0f );
+	team.aliases.resize( numPoints );
+	for (TUInt32 point = 0; point < numPoints; ++point)
+	{
+		team.aliases[point] = point;
+	}
+
+	TFloat32 totalWeight = 0.0f;
+	for (TUInt32 point = 0; point < numPoints; ++point)
+	{
+		totalWeight += team.weights[point];
+	}
+	if (totalWeight <= 0.0f)
+	{
+		// No weights, all points equally likely
+		return;
+	}
+
+	// Scale weights so the average is 1, then pair each point below 1 with one above
+	vector<TFloat32> scaled( numPoints );
+	vector<TUInt32> small, large;
+	for (TUInt32 point = 0; point < numPoints; ++point)
+	{
+		scaled[point] = team.weights[point] * numPoints / totalWeight;
+		if (scaled[point] < 1.0f)
+		{
+			small.push_back( point );
+		}
+		else
+		{
+			large.push_back( point );
+		}
+	}
+	while (!small.empty() && !large.empty())
+	{
+		TUInt32 less = small.back();
+		small.pop_back();
+		TUInt32 more = large.back();
+
+		team.aliasProbabilities[less] = scaled[less];
+		team.aliases[less] = more;
+		scaled[more] -= 1.0f - scaled[less];
+		if (scaled[more] < 1.0f)
+		{
+			large.pop_back();
+			small.push_back( more );
+		}
+	}
+
+	// Any remaining points (only left by rounding errors) are kept whenever chosen
+	for (TUInt32 point = 0; point < small.size(); ++point)
+	{
+		team.aliasProbabilities[small[point]] = 1.0f;
+	}
+	for (TUInt32 point = 0; point < large.size(); ++point)
+	{
+		team.aliasProbabilities[large[point]] = 1.0f;
+	}
+}
+
+// Build the grid of cells for one team. The grid is square and covers the points' bounds, with
+// about two points per cell
+void CPatrolPoints::BuildGrid( STeamPoints& team )
+{
+	TUInt32 numPoints = static_cast<TUInt32>(team.positions.size());
+	team.gridSize = static_cast<TUInt32>(ceil( sqrt( numPoints * 0.5f ) ));
+	if (team.gridSize == 0)
+	{
+		team.gridSize = 1;
+	}
+
+	CVector3 gridMax;
+	team.gridMin = gridMax = numPoints > 0 ? team.positions[0] : CVector3::kOrigin;
+	for (TUInt32 point = 1; point < numPoints; ++point)
+	{
+		team.gridMin.x = Min( team.gridMin.x, team.positions[point].x );
+		team.gridMin.z = Min( team.gridMin.z, team.positions[point].z );
+		gridMax.x = Max( gridMax.x, team.positions[point].x );
+		gridMax.z = Max( gridMax.z, team.positions[point].z );
+	}
+	team.cellSize = Max( gridMax.x - team.gridMin.x, gridMax.z - team.gridMin.z ) / team.gridSize;
+	if (team.cellSize <= 0.0f)
+	{
+		team.cellSize = 1.0f;
+	}
+
+	// Count the points in each cell, then convert the counts to start indexes and place the points
+	TUInt32 numCells = team.gridSize * team.gridSize;
+	vector<TUInt32> pointCells( numPoints );
+	team.cellStarts.assign( numCells + 1, 0 );
+	for (TUInt32 point = 0; point < numPoints; ++point)
+	{
+		TUInt32 cellX = GridCoord( team, team.positions[point].x, team.gridMin.x );
+		TUInt32 cellZ = GridCoord( team, team.positions[point].z, team.gridMin.z );
+		pointCells[point] = cellZ * team.gridSize + cellX;
+		++team.cellStarts[pointCells[point] + 1];
+	}
+	for (TUInt32 cell = 0; cell < numCells; ++cell)
+	{
+		team.cellStarts[cell + 1] += team.cellStarts[cell];
+	}
+	vector<TUInt32> cellEnds( team.cellStarts.begin(), team.cellStarts.end() - 1 );
+	team.cellPoints.resize( numPoints );
+	for (TUInt32 point = 0; point < numPoints; ++point)
+	{
+		team.cellPoints[cellEnds[pointCells[point]]++] = point;
+	}
+}
+
+// Return the grid cell coordinate containing the given world coordinate, clamped to the grid
+TInt32 CPatrolPoints::GridCoord( STeamPoints& team, TFloat32 coord, TFloat32 gridMin )
+{
+	TInt32 cell = static_cast<TInt32>(floor( (coord - gridMin) / team.cellSize ));
+	TInt32 lastCell = static_cast<TInt32>(team.gridSize) - 1;
+	return cell < 0 ? 0 : (cell > lastCell ? lastCell : cell);
+}
+
+
+} // namespace gen
@@ -0,0 +1,231 @@
+/*******************************************
+	PatrolPoints.h
+
+	Patrol points for each team, with
+	bounded time point selection
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CRandom.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+//	Public types
+
+// Ways of choosing the next patrol point
+enum EPatrolPolicy
+{
+	Patrol_Random,           // Any of the team's points, equally likely
+	Patrol_Weighted,         // Any of the team's points, in proportion to their weights
+	Patrol_NearestUnvisited, // The nearest point the tank has not yet visited
+};
+
+
+// Record of the patrol points one tank has visited, used by the nearest unvisited policy. Once
+// all of the team's points are visited the record starts again
+class CPatrolVisits
+{
+public:
+	// Constructor - no points visited
+	CPatrolVisits()
+	{
+		m_NumVisited = 0;
+	}
+
+	// Return true if the point with the given index has been visited
+	bool IsVisited( TUInt32 point )
+	{
+		return point < m_Visited.size() && m_Visited[point];
+	}
+
+	// Mark the point with the given index as visited, pass the number of points the team has
+	void Visit( TUInt32 point, TUInt32 numPoints )
+	{
+		if (m_Visited.size() != numPoints)
+		{
+			m_Visited.assign( numPoints, false );
+			m_NumVisited = 0;
+		}
+		if (!m_Visited[point])
+		{
+			m_Visited[point] = true;
+			++m_NumVisited;
+		}
+	}
+
+	// Return the number of points visited
+	TUInt32 NumVisited()
+	{
+		return m_NumVisited;
+	}
+
+	// Forget all visited points
+	void Reset()
+	{
+		m_Visited.assign( m_Visited.size(), false );
+		m_NumVisited = 0;
+	}
+
+private:
+	vector<bool> m_Visited;
+	TUInt32      m_NumVisited;
+};
+
+
+// The patrol points hold the points for each team in contiguous arrays, sorted by zone so each
+// zone's points are also contiguous. Points are added while loading the level and indexed by
+// Build, after which any selection takes bounded time however many points there are:
+// - Random and zone selection take constant time
+// - Weighted selection takes constant time using an alias table
+// - Nearest unvisited selection searches outwards through a grid of the team's points,
+//   visiting only the cells near the tank unless most nearby points have been visited
+// Selection does not change the patrol points, so tanks may select on any thread
+class CPatrolPoints
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Constructor - no points, random selection
+	CPatrolPoints()
+	{
+		m_Policy = Patrol_Random;
+	}
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CPatrolPoints( const CPatrolPoints& );
+	CPatrolPoints& operator=( const CPatrolPoints& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Setup
+
+	// Add a patrol point for a team, in the given zone and with the given weight for weighted
+	// selection. Build must be called after adding points and before selecting them
+	void AddPoint( TUInt32 team, const CVector3& position, TUInt32 zone = 0, TFloat32 weight = 1.0f );
+
+	// Sort and index the points added for selection
+	void Build();
+
+	// Remove all points
+	void Clear();
+
+	// Set or get the policy used by SelectPoint
+	void SetPolicy( EPatrolPolicy policy )
+	{
+		m_Policy = policy;
+	}
+	EPatrolPolicy GetPolicy()
+	{
+		return m_Policy;
+	}
+
+
+	/////////////////////////////////////
+	// Point access
+
+	// Return the number of points a team has
+	TUInt32 NumPoints( TUInt32 team )
+	{
+		return team < m_Teams.size() ? static_cast<TUInt32>(m_Teams[team].positions.size()) : 0;
+	}
+
+	// Return the position of a team's point with the given index (0 to NumPoints - 1)
+	const CVector3& GetPoint( TUInt32 team, TUInt32 point )
+	{
+		return m_Teams[team].positions[point];
+	}
+
+
+	/////////////////////////////////////
+	// Selection
+	// Each function returns false if the team (or zone) has no points, otherwise returns the
+	// index of the selected point through the given pointer
+
+	// Select a point using the current policy, returning its position through the given pointer.
+	// The tank's position, random number generator and visit record are used as the policy needs
+	bool SelectPoint( TUInt32 team, const CVector3& position, CRandom& random,
+	                  CPatrolVisits& visits, CVector3* point );
+
+	// Select any of the team's points, each equally likely
+	bool RandomPoint( TUInt32 team, CRandom& random, TUInt32* point );
+
+	// Select any of the team's points in the given zone, each equally likely
+	bool RandomPointInZone( TUInt32 team, TUInt32 zone, CRandom& random, TUInt32* point );
+
+	// Select any of the team's points, in proportion to their weights
+	bool WeightedPoint( TUInt32 team, CRandom& random, TUInt32* point );
+
+	// Select the point nearest to the given position that is not marked in the visit record, and
+	// mark it visited. If all points are visited, the record is reset first
+	bool NearestUnvisitedPoint( TUInt32 team, const CVector3& position, CPatrolVisits& visits,
+	                            TUInt32* point );
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// A range of points in a team's arrays
+	struct SRange
+	{
+		TUInt32 id;    // Zone number (unused for grid cells)
+		TUInt32 first;
+		TUInt32 count;
+	};
+
+	// The points of one team and their indexes
+	struct STeamPoints
+	{
+		// Point data, sorted by zone
+		vector<CVector3> positions;
+		vector<TUInt32>  zones;
+		vector<TFloat32> weights;
+
+		// Range of points in each zone
+		vector<SRange> zoneRanges;
+
+		// Alias table for weighted selection - a point is chosen uniformly, then kept with the
+		// given probability or else replaced by its alias
+		vector<TFloat32> aliasProbabilities;
+		vector<TUInt32>  aliases;
+
+		// Grid of cells over the points' bounds, with the indexes of the points in each cell held
+		// contiguously. Cell (x, z) holds cellPoints[cellStarts[i]] to cellPoints[cellStarts[i+1]],
+		// where i = z * gridSize + x
+		CVector3         gridMin;
+		TFloat32         cellSize;
+		TUInt32          gridSize;
+		vector<TUInt32>  cellStarts;
+		vector<TUInt32>  cellPoints;
+	};
+
+	// Build the alias table and grid for one team
+	void BuildAliasTable( STeamPoints& team );
+	void BuildGrid( STeamPoints& team );
+
+	// Return the grid cell coordinate containing the given world coordinate, clamped to the grid
+	TInt32 GridCoord( STeamPoints& team, TFloat32 coord, TFloat32 gridMin );
+
+
+	// Points for each team, indexed by team number
+	vector<STeamPoints> m_Teams;
+
+	// Policy used by SelectPoint
+	EPatrolPolicy m_Policy;
+};
+
+
+} // namespace gen
@@ -17,8 +17,6 @@ namespace gen
 //    CVector3 targetPos = EntityManager.GetEntity( targetUID )->GetMatrix().Position();
 extern CEntityManager EntityManager;
 
-// Messenger class for sending messages to and between entities
-extern CMessenger Messenger;
 
 // Helper function made available from TankAssignment.cpp - gets UID of tank A (team 0) or B (team 1).
 // Will be needed to implement the required shell behaviour in the Update function below
@@ -43,14 +41,17 @@ CShellEntity::CShellEntity
 	const string&    name /*=""*/,
 	const CVector3&  position /*= CVector3::kOrigin*/, 
 	const CVector3&  rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
-	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
-	
-) : CEntity( entityTemplate, UID, name, position, rotation, scale )
+	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/,
+	CMatrixArena*    matrixArena /*= 0*/,
+	TUInt32          matrixSlot /*= 0*/
+) : CEntity( entityTemplate, UID, name, position, rotation, scale, matrixArena, matrixSlot )
 {
 	// Initialise any shell data you add
 	m_Target = target; // Sets the target of the shell to move to
 	m_Timer = 3.0f; // Lifetime timer
 	m_ParentEntity = ParentEntity; // Sets the parent entity
+	m_Team = kNoTeam; // No team if the parent was destroyed before the shell was created
+	m_PrevPosition = position;
 
 	if (m_ParentEntity != nullptr)
 	{
@@ -64,30 +65,12 @@ CShellEntity::CShellEntity
 // Return false if the entity is to be destroyed
 bool CShellEntity::Update( TFloat32 updateTime )
 {
+	m_PrevPosition = GetPosition();
 	Matrix().MoveLocalZ(10 * updateTime); // Moves the shell
 	Matrix().FaceTarget(m_Target, Matrix().YAxis()); // Sets the shell to face direction
 
-	// Loops through checking the nearest tank and causing damage if in range
-	CEntity* entity;
-	EntityManager.BeginEnumEntities("", "", "Tank");
-	while (entity = EntityManager.EnumEntity())
-	{
-		CTankEntity* TEntity = static_cast<CTankEntity*>(entity);
-		if (TEntity != nullptr && m_Team != TEntity->GetTeam())
-		{
-			if (Distance(Position(), TEntity->Position()) < 5.0f)
-			{
-				// Tells the tank its been hit
-				SMessage msg;
-				msg.type = Msg_Hit;
-				msg.from = GetUID();
-
-				Messenger.SendMessageA(TEntity->GetUID(), msg);
-				return false;
-			}
-		}
-	}
-	EntityManager.EndEnumEntities();
+	// Hits on enemy tanks are found by the entity manager for all shells together, along the
+	// path each shell moved in this update
 
 	// When timer runs out destroys itself
 	if (m_Timer < 0.0f)
@@ -48,7 +48,9 @@ public:
 		const string& name = "",
 		const CVector3& position = CVector3::kOrigin,
 		const CVector3& rotation = CVector3(0.0f, 0.0f, 0.0f),
-		const CVector3& scale = CVector3(1.0f, 1.0f, 1.0f)
+		const CVector3& scale = CVector3(1.0f, 1.0f, 1.0f),
+		CMatrixArena* matrixArena = 0,
+		TUInt32 matrixSlot = 0
 	);
 
 	// No destructor needed
@@ -65,6 +67,23 @@ public:
 	// Return false if the entity is to be destroyed
 	// Keep as a virtual function in case of further derivation
 	virtual bool Update( TFloat32 updateTime );
+
+
+	/////////////////////////////////////
+	// Collision
+
+	// Return the position of the shell before its latest update. Collision is tested along the
+	// path from here to its current position
+	const CVector3& GetPrevPosition()
+	{
+		return m_PrevPosition;
+	}
+
+	// Return the team of the tank that fired the shell (kNoTeam if none)
+	TUInt32 GetTeam()
+	{
+		return m_Team;
+	}
 	
 /////////////////////////////////////
 //	Private interface
@@ -77,6 +96,7 @@ private:
 	TFloat32 m_Timer;
 
 	CVector3 m_Target;
+	CVector3 m_PrevPosition;
 
 	TUInt32 m_Team;
 
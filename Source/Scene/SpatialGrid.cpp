@@ -0,0 +1,292 @@
+/*******************************************
+	SpatialGrid.cpp
+
+	Uniform grid spatial index for fast
+	proximity queries between entities
+********************************************/
+
+#include <math.h>
+#include "SpatialGrid.h"
+
+namespace gen
+{
+
+// Cell coordinates are clamped to this range, so distant positions and huge query radii can be
+// converted to integers safely. Entities beyond it share the edge cells, which only costs some
+// extra distance tests
+const TFloat32 kfMaxCellCoord = 1048576.0f;
+
+
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Constructor takes the width of a grid cell and the number of buckets (a power of 2)
+CSpatialGrid::CSpatialGrid( TFloat32 cellSize /*= 10.0f*/, TUInt32 numBuckets /*= 1024*/ )
+{
+	m_CellSize = cellSize;
+	m_InvCellSize = 1.0f / cellSize;
+
+	m_NumBuckets = numBuckets;
+	m_Buckets = new TBucket[m_NumBuckets];
+	m_EntityBuckets = new CHashTable<TEntityUID, TUInt32>( 2048, IntegerHash );
+}
+
+// Destructor
+CSpatialGrid::~CSpatialGrid()
+{
+	delete m_EntityBuckets;
+	delete[] m_Buckets;
+}
+
+
+/////////////////////////////////////
+// Entity tracking
+
+// Add an entity to the grid at its current position, with the team it belongs to (or kNoTeam)
+void CSpatialGrid::AddEntity( CEntity* entity, TUInt32 team /*= kNoTeam*/ )
+{
+	SGridEntity gridEntity;
+	gridEntity.entity = entity;
+	gridEntity.position = entity->GetPosition();
+	gridEntity.cellX = CellCoord( gridEntity.position.x );
+	gridEntity.cellZ = CellCoord( gridEntity.position.z );
+	gridEntity.templateTypeID = entity->Template()->GetTypeID();
+	gridEntity.team = team;
+
+	TUInt32 bucket = CellBucket( gridEntity.cellX, gridEntity.cellZ );
+	m_Buckets[bucket].push_back( gridEntity );
+	m_EntityBuckets->SetKeyValue( entity->GetUID(), bucket );
+}
+
+// Update the grid for an entity that may have moved, changing cell if necessary
+void CSpatialGrid::MoveEntity( CEntity* entity )
+{
+	TUInt32 bucket;
+	if (!m_EntityBuckets->LookUpKey( entity->GetUID(), &bucket ))
+	{
+		return;
+	}
+	TUInt32 index = FindInBucket( bucket, entity );
+	SGridEntity& gridEntity = m_Buckets[bucket][index];
+
+	// Usually the entity remains in the same cell, so only the position needs updating
+	gridEntity.position = entity->GetPosition();
+	TInt32 cellX = CellCoord( gridEntity.position.x );
+	TInt32 cellZ = CellCoord( gridEntity.position.z );
+	if (cellX == gridEntity.cellX && cellZ == gridEntity.cellZ)
+	{
+		return;
+	}
+	gridEntity.cellX = cellX;
+	gridEntity.cellZ = cellZ;
+
+	// Changed cell, move to a different bucket if necessary
+	TUInt32 newBucket = CellBucket( cellX, cellZ );
+	if (newBucket != bucket)
+	{
+		m_Buckets[newBucket].push_back( gridEntity );
+		m_Buckets[bucket][index] = m_Buckets[bucket].back();
+		m_Buckets[bucket].pop_back();
+		m_EntityBuckets->SetKeyValue( entity->GetUID(), newBucket );
+	}
+}
+
+// Remove the given entity from the grid
+void CSpatialGrid::RemoveEntity( CEntity* entity )
+{
+	TUInt32 bucket;
+	if (!m_EntityBuckets->LookUpKey( entity->GetUID(), &bucket ))
+	{
+		return;
+	}
+
+	// Order in a bucket is unimportant so fill the gap with the last entity
+	TUInt32 index = FindInBucket( bucket, entity );
+	m_Buckets[bucket][index] = m_Buckets[bucket].back();
+	m_Buckets[bucket].pop_back();
+	m_EntityBuckets->RemoveKey( entity->GetUID() );
+}
+
+// Remove all entities from the grid
+void CSpatialGrid::RemoveAllEntities()
+{
+	for (TUInt32 bucket = 0; bucket < m_NumBuckets; ++bucket)
+	{
+		m_Buckets[bucket].clear();
+	}
+	m_EntityBuckets->RemoveAllKeys();
+}
+
+
+/////////////////////////////////////
+// Queries
+
+// Return the nearest entity to a point within the given radius that matches the template type
+// ID (kAnyTemplateID matches any type) and team filter. Returns 0 if no entity matches.
+// Optionally returns the entity's position held in the grid through the given pointer
+CEntity* CSpatialGrid::FindNearest
+(
+	const CVector3& point,
+	TFloat32        radius,
+	TUInt32         templateTypeID /*= kAnyTemplateID*/,
+	ETeamFilter     teamFilter /*= Team_Any*/,
+	TUInt32         team /*= kNoTeam*/,
+	CVector3*       position /*= 0*/
+)
+{
+	const SGridEntity* nearestEntity = 0;
+	TFloat32 nearestDistanceSquared = radius * radius;
+	auto visitor = [&]( const SGridEntity& gridEntity )
+	{
+		// Each match shrinks the radius to the nearest distance so far
+		if (Matches( gridEntity, point, nearestDistanceSquared, templateTypeID, teamFilter, team ))
+		{
+			nearestEntity = &gridEntity;
+			nearestDistanceSquared = DistanceSquared( point, gridEntity.position );
+		}
+	};
+	VisitCells( point, radius, visitor );
+
+	if (!nearestEntity)
+	{
+		return 0;
+	}
+	if (position)
+	{
+		*position = nearestEntity->position;
+	}
+	return nearestEntity->entity;
+}
+
+// Add all entities within a radius of a point that match the template type ID and team filter
+// to the given vector. Returns the number of entities found
+TUInt32 CSpatialGrid::FindInRadius
+(
+	const CVector3&   point,
+	TFloat32          radius,
+	vector<CEntity*>& results,
+	TUInt32           templateTypeID /*= kAnyTemplateID*/,
+	ETeamFilter       teamFilter /*= Team_Any*/,
+	TUInt32           team /*= kNoTeam*/
+)
+{
+	TUInt32 numFound = 0;
+	TFloat32 radiusSquared = radius * radius;
+	auto visitor = [&]( const SGridEntity& gridEntity )
+	{
+		if (Matches( gridEntity, point, radiusSquared, templateTypeID, teamFilter, team ))
+		{
+			results.push_back( gridEntity.entity );
+			++numFound;
+		}
+	};
+	VisitCells( point, radius, visitor );
+	return numFound;
+}
+
+
+/////////////////////////////////////
+// Support functions
+
+// Return the cell coordinate containing the given world coordinate
+TInt32 CSpatialGrid::CellCoord( TFloat32 worldCoord )
+{
+	// Comparisons written so that NaN is also clamped
+	TFloat32 cell = floorf( worldCoord * m_InvCellSize );
+	if (!(cell > -kfMaxCellCoord)) return static_cast<TInt32>(-kfMaxCellCoord);
+	if (!(cell <  kfMaxCellCoord)) return static_cast<TInt32>(kfMaxCellCoord);
+	return static_cast<TInt32>(cell);
+}
+
+// Return the bucket index for the given cell
+TUInt32 CSpatialGrid::CellBucket( TInt32 cellX, TInt32 cellZ )
+{
+	// Multiply each coordinate by a large prime and combine
+	TUInt32 hash = (static_cast<TUInt32>(cellX) * 73856093u) ^ (static_cast<TUInt32>(cellZ) * 19349663u);
+	return hash & (m_NumBuckets - 1);
+}
+
+// Return the position of the given entity in its bucket
+TUInt32 CSpatialGrid::FindInBucket( TUInt32 bucket, CEntity* entity )
+{
+	TUInt32 index = 0;
+	while (m_Buckets[bucket][index].entity != entity)
+	{
+		++index;
+	}
+	return index;
+}
+
+// Test if a grid entity matches query filters. Pass the distance squared within which entities
+// will match
+bool CSpatialGrid::Matches
+(
+	const SGridEntity& gridEntity,
+	const CVector3&    point,
+	TFloat32           radiusSquared,
+	TUInt32            templateTypeID,
+	ETeamFilter        teamFilter,
+	TUInt32            team
+)
+{
+	if (DistanceSquared( point, gridEntity.position ) >= radiusSquared)
+	{
+		return false;
+	}
+	if (teamFilter != Team_Any && (gridEntity.team == kNoTeam ||
+	                               (teamFilter == Team_Same) != (gridEntity.team == team)))
+	{
+		return false;
+	}
+	return templateTypeID == kAnyTemplateID || gridEntity.templateTypeID == templateTypeID;
+}
+
+// Call the given function for every grid entity in the cells overlapping a query circle
+template <class TVisitor>
+void CSpatialGrid::VisitCells( const CVector3& point, TFloat32 radius, TVisitor& visitor )
+{
+	// A negative radius contains nothing
+	if (!(radius >= 0.0f))
+	{
+		return;
+	}
+
+	TInt32 minX = CellCoord( point.x - radius );
+	TInt32 maxX = CellCoord( point.x + radius );
+	TInt32 minZ = CellCoord( point.z - radius );
+	TInt32 maxZ = CellCoord( point.z + radius );
+
+	// If the query covers more cells than there are buckets then visit every bucket once instead.
+	// Cell coordinates are clamped, but the count of cells still needs 64 bits
+	TUInt64 numCells = static_cast<TUInt64>(maxX - minX + 1) * static_cast<TUInt64>(maxZ - minZ + 1);
+	if (numCells >= m_NumBuckets)
+	{
+		for (TUInt32 bucket = 0; bucket < m_NumBuckets; ++bucket)
+		{
+			for (TUInt32 index = 0; index < m_Buckets[bucket].size(); ++index)
+			{
+				visitor( m_Buckets[bucket][index] );
+			}
+		}
+		return;
+	}
+
+	for (TInt32 cellZ = minZ; cellZ <= maxZ; ++cellZ)
+	{
+		for (TInt32 cellX = minX; cellX <= maxX; ++cellX)
+		{
+			// Other cells can share this bucket, only visit entities in the current cell
+			TBucket& bucket = m_Buckets[CellBucket( cellX, cellZ )];
+			for (TUInt32 index = 0; index < bucket.size(); ++index)
+			{
+				if (bucket[index].cellX == cellX && bucket[index].cellZ == cellZ)
+				{
+					visitor( bucket[index] );
+				}
+			}
+		}
+	}
+}
+
+
+} // namespace gen
@@ -0,0 +1,157 @@
+/*******************************************
+	SpatialGrid.h
+
+	Uniform grid spatial index for fast
+	proximity queries between entities
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CHashTable.h"
+#include "Entity.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+//	Public types
+
+// Team value for entities that do not belong to a team
+const TUInt32 kNoTeam = 0xffffffff;
+
+// Team filtering for spatial queries - entities without a team only pass Team_Any
+enum ETeamFilter
+{
+	Team_Any,   // Any entity
+	Team_Same,  // Entities on the given team
+	Team_Other, // Entities on a team other than the given team
+};
+
+
+// The spatial grid divides the world's XZ plane into square cells and holds the entities in each
+// cell, so proximity queries only need to visit the few cells that overlap the query radius
+// rather than every entity. Cells are hashed into a fixed number of buckets, so the world has no
+// size limit and the grid uses no memory for empty space. Entities from different cells that
+// share a bucket are told apart by storing their cell coordinates with them.
+// Entities are not tracked automatically, the owner must call MoveEntity after an entity moves
+class CSpatialGrid
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Constructor takes the width of a grid cell and the number of buckets (a power of 2)
+	CSpatialGrid( TFloat32 cellSize = 10.0f, TUInt32 numBuckets = 1024 );
+
+	// Destructor
+	~CSpatialGrid();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CSpatialGrid( const CSpatialGrid& );
+	CSpatialGrid& operator=( const CSpatialGrid& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Entity tracking
+
+	// Add an entity to the grid at its current position, with the team it belongs to (or kNoTeam)
+	void AddEntity( CEntity* entity, TUInt32 team = kNoTeam );
+
+	// Update the grid for an entity that may have moved, changing cell if necessary
+	void MoveEntity( CEntity* entity );
+
+	// Remove the given entity from the grid
+	void RemoveEntity( CEntity* entity );
+
+	// Remove all entities from the grid
+	void RemoveAllEntities();
+
+
+	/////////////////////////////////////
+	// Queries
+
+	// Return the nearest entity to a point within the given radius that matches the template type
+	// ID (kAnyTemplateID matches any type) and team filter. Returns 0 if no entity matches.
+	// Optionally returns the entity's position held in the grid through the given pointer
+	CEntity* FindNearest( const CVector3& point, TFloat32 radius,
+	                      TUInt32 templateTypeID = kAnyTemplateID,
+	                      ETeamFilter teamFilter = Team_Any, TUInt32 team = kNoTeam,
+	                      CVector3* position = 0 );
+
+	// Add all entities within a radius of a point that match the template type ID and team filter
+	// to the given vector. Returns the number of entities found
+	TUInt32 FindInRadius( const CVector3& point, TFloat32 radius, vector<CEntity*>& results,
+	                      TUInt32 templateTypeID = kAnyTemplateID, ETeamFilter teamFilter = Team_Any,
+	                      TUInt32 team = kNoTeam );
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	/////////////////////////////////////
+	// Types
+
+	// An entity held in the grid. The position is a copy taken when the entity was last added
+	// or moved, and the type and team are copied too, so queries do not need to visit the entity
+	struct SGridEntity
+	{
+		CEntity* entity;
+		CVector3 position;
+		TInt32   cellX;
+		TInt32   cellZ;
+		TUInt32  templateTypeID;
+		TUInt32  team;
+	};
+
+	typedef vector<SGridEntity> TBucket;
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Return the cell coordinate containing the given world coordinate
+	TInt32 CellCoord( TFloat32 worldCoord );
+
+	// Return the bucket index for the given cell
+	TUInt32 CellBucket( TInt32 cellX, TInt32 cellZ );
+
+	// Return the position of the given entity in its bucket
+	TUInt32 FindInBucket( TUInt32 bucket, CEntity* entity );
+
+	// Test if a grid entity matches query filters. Pass the distance squared within which
+	// entities will match
+	bool Matches( const SGridEntity& gridEntity, const CVector3& point, TFloat32 radiusSquared,
+	              TUInt32 templateTypeID, ETeamFilter teamFilter, TUInt32 team );
+
+	// Call the given function for every grid entity in the cells overlapping a query circle
+	template <class TVisitor>
+	void VisitCells( const CVector3& point, TFloat32 radius, TVisitor& visitor );
+
+
+	/////////////////////////////////////
+	// Data
+
+	// Width of each grid cell, and its reciprocal
+	TFloat32 m_CellSize;
+	TFloat32 m_InvCellSize;
+
+	// Buckets of entities indexed by cell hash, number of buckets is a power of 2
+	TBucket* m_Buckets;
+	TUInt32  m_NumBuckets;
+
+	// Mapping from entity UID to the bucket currently holding that entity
+	CHashTable<TEntityUID, TUInt32>* m_EntityBuckets;
+};
+
+
+} // namespace gen
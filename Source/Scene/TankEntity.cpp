@@ -12,7 +12,8 @@
 // - Tanks have three parts: the root, the body and the turret. Each part has its own matrix, which
 //   can be accessed with the Matrix function - root: Matrix(), body: Matrix(1), turret: Matrix(2)
 //   However, the body and turret matrix are relative to the root's matrix - so to get the actual 
-//   world matrix of the body, for example, we must multiply: Matrix(1) * Matrix()
+//   world matrix of the body, for example, we must multiply: Matrix(1) * Matrix(). The entity
+//   manager does this for every node once per update, the results are available from WorldMatrix
 // - Vector facing work similar to the car tag lab will be needed for the turret->enemy facing 
 //   requirements for the Patrol and Aim states
 // - The CMatrix4x4 function DecomposeAffineEuler allows you to extract the x,y & z rotations
@@ -39,7 +40,8 @@ namespace gen
 //    CVector3 targetPos = EntityManager.GetEntity( targetUID )->GetMatrix().Position();
 extern CEntityManager EntityManager;
 
-// Messenger class for sending messages to and between entities
+// Messenger class for reading messages sent to entities. Messages are sent through the entity
+// manager's command buffers during updates
 extern CMessenger Messenger;
 
 // Helper function made available from TankAssignment.cpp - gets UID of tank A (team 0) or B (team 1).
@@ -64,8 +66,11 @@ CTankEntity::CTankEntity
 	const string& name /*=""*/,
 	const CVector3& position /*= CVector3::kOrigin*/,
 	const CVector3& rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
-	const CVector3& scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
-) : CEntity(tankTemplate, UID, name, position, rotation, scale)
+	const CVector3& scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/,
+	CMatrixArena*   matrixArena /*= 0*/,
+	TUInt32         matrixSlot /*= 0*/
+) : CEntity(tankTemplate, UID, name, position, rotation, scale, matrixArena, matrixSlot),
+    m_Random(EntityManager.GetRandomSeed(), UID)
 {
 	m_TankTemplate = tankTemplate;
 
@@ -79,8 +84,12 @@ CTankEntity::CTankEntity
 	m_Timer = 0.0f;
 	m_AimTimer = 1.0f;
 
+	// Look up the template types used in entity queries once, rather than comparing strings
+	m_TankTypeID = EntityManager.TemplateTypeID("Tank");
+	m_AmmoBoxTypeID = EntityManager.TemplateTypeID("AmmoBox");
+
 	// Creates the chase cam thats used for this tank
-	m_ChaseCam = new CCamera({ Position().x, Position().y + 3.0f, Position().z });
+	m_ChaseCam = new CCamera({ GetPosition().x, GetPosition().y + 3.0f, GetPosition().z });
 	m_ChaseCam->SetNearFarClip(1.0f, 20000.0f);
 }
 
@@ -91,51 +100,18 @@ CTankEntity::CTankEntity
 bool CTankEntity::Update( TFloat32 updateTime )
 {
 
-	CMatrix4x4 tankMatrix = Matrix(1) * Matrix(); // Returns the tank matrix
+	const CMatrix4x4& tankMatrix = WorldMatrix(1); // Returns the tank matrix
 	CVector3 facingVector = tankMatrix.ZAxis(); // Used for getting the facing vector
 	facingVector.Normalise();
 
-	m_ChaseCam->Position() = Position() - facingVector * 15.0f + tankMatrix.YAxis() * 3.0f; // Sets the position of the chase cam behind the tank  
+	m_ChaseCam->Position() = GetPosition() - facingVector * 15.0f + tankMatrix.YAxis() * 3.0f; // Sets the position of the chase cam behind the tank  
 	m_ChaseCam->Matrix().FaceTarget(tankMatrix.Position()); // Sets the camera to always face forwards with the tank
 
-	// Fetch any messages
-	SMessage msg;
-	while (Messenger.FetchMessage( GetUID(), &msg ))
+	// Fetch any messages, including those broadcast or sent to the tank's team
+	CMessenger::CMessageReader messages = Messenger.ReadMessages( GetUID(), m_Team );
+	while (const SMessage* msg = messages.Next())
 	{
-		// Set state variables based on received messages
-		switch (msg.type)
-		{
-			case Msg_Start:
-				m_State = EState::Patrol;
-				break;
-			case Msg_Stop:
-				m_State = EState::InActive;
-				break;
-			case Msg_Inactive:
-				m_State = EState::InActive;
-				break;
-			case Msg_Patrol:
-				m_State = EState::Patrol;
-				break;
-			case Msg_Aim:
-				m_State = EState::Aim;
-				break;
-			case Msg_Evade:
-				m_State = EState::Evade;
-				break;
-			case Msg_Hit:
-				Hit();
-				break;
-			case MSg_FindAmmo:
-				m_IsMoving = false;
-				m_State = EState::FindAmmo;
-				break;
-			case Msg_Help:
-				m_State = EState::Help;
-			case Msg_Death:
-				Death(updateTime);
-				break;
-		}
+		HandleMessage(*msg, updateTime);
 	}
 	// Runs functions and set variables based on the current state
 	if (m_State == EState::InActive)
@@ -175,6 +151,45 @@ bool CTankEntity::Update( TFloat32 updateTime )
 	return true; // Don't destroy the entity
 }
 
+void CTankEntity::HandleMessage(const SMessage& msg, float frameTime)
+{
+	// Set state variables based on received messages
+	switch (msg.type)
+	{
+		case Msg_Start:
+			m_State = EState::Patrol;
+			break;
+		case Msg_Stop:
+			m_State = EState::InActive;
+			break;
+		case Msg_Inactive:
+			m_State = EState::InActive;
+			break;
+		case Msg_Patrol:
+			m_State = EState::Patrol;
+			break;
+		case Msg_Aim:
+			m_State = EState::Aim;
+			break;
+		case Msg_Evade:
+			m_State = EState::Evade;
+			break;
+		case Msg_Hit:
+			Hit();
+			break;
+		case MSg_FindAmmo:
+			m_IsMoving = false;
+			m_State = EState::FindAmmo;
+			break;
+		case Msg_Help:
+			m_State = EState::Help;
+			break;
+		case Msg_Death:
+			Death(frameTime);
+			break;
+	}
+}
+
 void CTankEntity::Patrol(float frameTime)
 {
 	if (!m_IsMoving) // when not moving set the target and set vmoving to true
@@ -186,43 +201,33 @@ void CTankEntity::Patrol(float frameTime)
 	{
 		Matrix(2).RotateLocalY(m_TankTemplate->GetTurretTurnSpeed() * frameTime); // Rotates the turrent when when partrolling
 
-		CMatrix4x4 turretMatrix = Matrix(2) * Matrix(); // Gets the turrents matrix
+		const CMatrix4x4& turretMatrix = WorldMatrix(2); // Gets the turrents matrix (as of the end of the last update)
 
 		CVector3 facingVector = turretMatrix.ZAxis(); 
 		facingVector.Normalise();
-		CVector3 endPos = Position() + facingVector * 30.0f; // Raycast for the tank from the turrents facing vector
+		CVector3 endPos = GetPosition() + facingVector * 30.0f; // Raycast for the tank from the turrents facing vector
 
-		// Loops through all the entities that have the tank template
-		CEntity* entity;
-		EntityManager.BeginEnumEntities("", "", "Tank");
-		while (entity = EntityManager.EnumEntity())
+		// Finds the nearest opponents tank within the raycast, along with the position that the
+		// enemy is at (the enemy may be updating on another thread so its matrix isn't used)
+		CEntity* entity = EntityManager.FindNearestEntity(endPos, 25.0f, m_TankTypeID, Team_Other, m_Team, &m_EnemyTarget);
+		if (entity != nullptr)
 		{
-			CTankEntity* TEntity = static_cast<CTankEntity*>(entity); // Casts the entity to the tank object to get access to its functions
-			if (TEntity != nullptr && m_Team != TEntity->GetTeam()) // Checks if the object is a tank and checks if its an opponents tank
-			{
-				if (Distance(endPos, TEntity->Position()) < 25.0f) // Checks if the enemy tank is within the raycast
-				{
-					// Sends an aim message to its self
-					SMessage msg;
-					msg.type = Msg_Aim; 
-					msg.from = GetUID();
-
-					m_EnemyTarget = TEntity->Position(); // Sets the position that the enemy is at
+			// Sends an aim message to its self
+			SMessage msg;
+			msg.type = Msg_Aim; 
+			msg.from = GetUID();
 
-					Messenger.SendMessageA(GetUID(), msg);
-				}
-			}
+			EntityManager.Commands().SendMessage(GetUID(), msg);
 		}
-		EntityManager.EndEnumEntities();
 
 		// Normalise the Z and X axis
 		Matrix().ZAxis().Normalise();
 		Matrix().XAxis().Normalise();
-		CVector3 target = m_Target - Position(); // Sets the target used for rotating 
+		CVector3 target = m_Target - GetPosition(); // Sets the target used for rotating 
 		target.Normalise(); 
 
-		float productX = Dot(Matrix().XAxis(), target); // gets the dot product of x used for checking if it needs to turn left or right
-		float productZ = Dot(Matrix().ZAxis(), target); // Product used for getting the angle
+		float productX = Dot(GetMatrix().XAxis(), target); // gets the dot product of x used for checking if it needs to turn left or right
+		float productZ = Dot(GetMatrix().ZAxis(), target); // Product used for getting the angle
 		float angle = acos(productZ); // getting the angle used for turning speed 
 
 		float turnSpeed = ToRadians(m_TankTemplate->GetTurnSpeed());
@@ -237,7 +242,7 @@ void CTankEntity::Patrol(float frameTime)
 			Matrix().RotateY(-Min(turnSpeed, angle));
 		}
 
-		if (Distance(Position(), m_Target) > 2.0f) // Increases the speed if not in range
+		if (Distance(GetPosition(), m_Target) > 2.0f) // Increases the speed if not in range
 		{
 			m_Speed += m_TankTemplate->GetAcceleration() * frameTime;
 			if (m_Speed > m_TankTemplate->GetMaxSpeed())
@@ -277,7 +282,7 @@ void CTankEntity::Aim(float frameTime)
 		{
 			if (!m_Fired) // Shots the shell when the timer has ran out
 			{
-				EntityManager.CreateShell("Shell Type 1", m_EnemyTarget, this, "", { Position().x, 1.8f, Position().z });
+				EntityManager.Commands().CreateShell("Shell Type 1", m_EnemyTarget, this, "", { GetPosition().x, 1.8f, GetPosition().z });
 				m_ShellsShot++;
 				m_ShellsAmmo--;
 				m_AimTimer = 1.0f; // Resets the timer
@@ -286,7 +291,7 @@ void CTankEntity::Aim(float frameTime)
 				msg.type = Msg_Evade;
 				msg.from = SystemUID;
 
-				Messenger.SendMessageA(GetUID(), msg);
+				EntityManager.Commands().SendMessage(GetUID(), msg);
 			}
 		}
 		else
@@ -300,7 +305,7 @@ void CTankEntity::Aim(float frameTime)
 		SMessage msg;
 		msg.type = MSg_FindAmmo;
 		msg.from = SystemUID;
-		Messenger.SendMessageA(GetUID(), msg);
+		EntityManager.Commands().SendMessage(GetUID(), msg);
 	}
 }
 
@@ -320,16 +325,16 @@ void CTankEntity::Evade(float frameTime)
 		SMessage msg;
 		msg.type = MSg_FindAmmo;
 		msg.from = SystemUID;
-		Messenger.SendMessageA(GetUID(), msg);
+		EntityManager.Commands().SendMessage(GetUID(), msg);
 	}
 
 	Matrix().ZAxis().Normalise();
 	Matrix().XAxis().Normalise();
-	CVector3 target = m_Target - Position();
+	CVector3 target = m_Target - GetPosition();
 	target.Normalise();
 
-	float productX = Dot(Matrix().XAxis(), target);
-	float productZ = Dot(Matrix().ZAxis(), target);
+	float productX = Dot(GetMatrix().XAxis(), target);
+	float productZ = Dot(GetMatrix().ZAxis(), target);
 	float angle = acos(productZ);
 
 	float turnSpeed = ToRadians(m_TankTemplate->GetTurnSpeed());
@@ -343,7 +348,7 @@ void CTankEntity::Evade(float frameTime)
 		Matrix().RotateY(-Min(turnSpeed, angle));
 	}
 
-	if (Distance(Position(), m_Target) > 2.0f)
+	if (Distance(GetPosition(), m_Target) > 2.0f)
 	{
 		m_Speed += m_TankTemplate->GetAcceleration() * frameTime;
 		if (m_Speed > m_TankTemplate->GetMaxSpeed())
@@ -383,43 +388,19 @@ void CTankEntity::Hit()
 	SMessage msg;
 	msg.type = Msg_Help;
 	msg.from = SystemUID;
-
-	CEntity* entityLoop;
-	EntityManager.BeginEnumEntities("", "", "Tank");
-	while (entityLoop = EntityManager.EnumEntity())
-	{
-		CTankEntity* TEntity = static_cast<CTankEntity*>(entityLoop);
-		if (TEntity != nullptr && TEntity->GetTeam() == m_Team)
-		{
-			Messenger.SendMessageA(TEntity->GetUID(), msg);
-		}
-	}
-	EntityManager.EndEnumEntities();
-
-	
+	EntityManager.Commands().SendTeamMessage(m_Team, msg);
 }
 
 void CTankEntity::FindAmmo(float frameTime)
 {
 	// Finds the nearest ammo
-	CEntity* entity;
-	CEntity* entityLoop;
-	CVector3 nearestAmmoPos = CVector3(Random(-30.0f, 30.0f), Position().y, Random(-30.0f, 30.0f));
-	EntityManager.BeginEnumEntities("", "", "AmmoBox");
-	float nearest = 20.0f; 
-	while (entityLoop = EntityManager.EnumEntity())
+	CVector3 nearestAmmoPos = CVector3(m_Random.Random(-30.0f, 30.0f), GetPosition().y, m_Random.Random(-30.0f, 30.0f));
+	CVector3 ammoPos;
+	CEntity* entity = EntityManager.FindNearestEntity(GetPosition(), 20.0f, m_AmmoBoxTypeID, Team_Any, kNoTeam, &ammoPos);
+	if (entity != nullptr)
 	{
-		CAmmoBoxEntity* AEntity = static_cast<CAmmoBoxEntity*>(entityLoop);
-		if (AEntity != nullptr)
-		{
-			if (Distance(Position(), AEntity->Position()) < nearest)
-			{
-				nearestAmmoPos = AEntity->Position();
-				entity = entityLoop;
-			}
-		}
+		nearestAmmoPos = ammoPos;
 	}
-	EntityManager.EndEnumEntities();
 
 	if (!m_IsMoving)
 	{
@@ -432,11 +413,11 @@ void CTankEntity::FindAmmo(float frameTime)
 
 		Matrix().ZAxis().Normalise();
 		Matrix().XAxis().Normalise();
-		CVector3 target = m_NearestAmmoTarget - Position();
+		CVector3 target = m_NearestAmmoTarget - GetPosition();
 		target.Normalise();
 
-		float productX = Dot(Matrix().XAxis(), target);
-		float productZ = Dot(Matrix().ZAxis(), target);
+		float productX = Dot(GetMatrix().XAxis(), target);
+		float productZ = Dot(GetMatrix().ZAxis(), target);
 		float angle = acos(productZ);
 
 		float turnSpeed = ToRadians(m_TankTemplate->GetTurnSpeed());
@@ -450,7 +431,7 @@ void CTankEntity::FindAmmo(float frameTime)
 			Matrix().RotateY(-Min(turnSpeed, angle));
 		}
 
-		if (Distance(Position(), m_NearestAmmoTarget) > 2.0f)
+		if (Distance(GetPosition(), m_NearestAmmoTarget) > 2.0f)
 		{
 			m_Speed += m_TankTemplate->GetAcceleration() * frameTime;
 			if (m_Speed > m_TankTemplate->GetMaxSpeed())
@@ -471,12 +452,12 @@ void CTankEntity::FindAmmo(float frameTime)
 					{
 						m_ShellsAmmo = 10; // Set ammo
 						entity = nullptr; // resets entity
-						nearestAmmoPos = CVector3(Random(-30.0f, 30.0f), Position().y, Random(-30.0f, 30.0f)); // resets ammo 
+						nearestAmmoPos = CVector3(m_Random.Random(-30.0f, 30.0f), GetPosition().y, m_Random.Random(-30.0f, 30.0f)); // resets ammo 
 						// Sends message to the ammo box letting it know to destroy its self
 						SMessage msg1;
 						msg1.type = Msg_CollectedAmmo;
 						msg1.from = GetUID();
-						Messenger.SendMessageA(AEntity->GetUID(), msg1);
+						EntityManager.Commands().SendMessage(AEntity->GetUID(), msg1);
 						
 					}
 				}
@@ -485,7 +466,7 @@ void CTankEntity::FindAmmo(float frameTime)
 				SMessage msg;
 				msg.type = Msg_Patrol;
 				msg.from = SystemUID;
-				Messenger.SendMessageA(GetUID(), msg);
+				EntityManager.Commands().SendMessage(GetUID(), msg);
 		}
 	}
 	
@@ -500,34 +481,24 @@ void CTankEntity::Help(float frameTime)
 		SMessage msg;
 		msg.type = Msg_Patrol;
 		msg.from = SystemUID;
-		Messenger.SendMessageA(GetUID(), msg);
+		EntityManager.Commands().SendMessage(GetUID(), msg);
 	}
 	else
 	{
 		m_HelpTimer -= frameTime;
 
-		CEntity* entityLoop;
-		CVector3 NearestTankPos = CVector3(Random(-30.0f, 30.0f), Position().y, Random(-30.0f, 30.0f));
-		EntityManager.BeginEnumEntities("", "", "Tank");
-		float nearest = 20.0f;
-		while (entityLoop = EntityManager.EnumEntity())
+		// if an enemy is found nearby reset timer and go to aim state starting ememy target
+		CVector3 enemyPos;
+		CEntity* entity = EntityManager.FindNearestEntity(GetPosition(), 20.0f, m_TankTypeID, Team_Other, m_Team, &enemyPos);
+		if (entity != nullptr)
 		{
-			CTankEntity* AEntity = static_cast<CTankEntity*>(entityLoop);
-			if (AEntity != nullptr)
-			{
-				// if found reset timer and go to aim state starting ememy target
-				if (Distance(Position(), AEntity->Position()) < nearest)
-				{
-					m_EnemyTarget = entityLoop->Position();
-					m_HelpTimer = m_HelpTimerMax;
-					SMessage msg;
-					msg.type = Msg_Aim;
-					msg.from = SystemUID;
-					Messenger.SendMessageA(GetUID(), msg);
-				}
-			}
+			m_EnemyTarget = enemyPos;
+			m_HelpTimer = m_HelpTimerMax;
+			SMessage msg;
+			msg.type = Msg_Aim;
+			msg.from = SystemUID;
+			EntityManager.Commands().SendMessage(GetUID(), msg);
 		}
-		EntityManager.EndEnumEntities();
 
 		
 	}
@@ -537,7 +508,7 @@ void CTankEntity::SetRandomTarget()
 {
 	if (!m_EvadeStart)
 	{
-		m_Target = CVector3(Random(-40.0f, 40.0f), Position().y, Random(-40.0f, 40.0f)); 
+		m_Target = CVector3(m_Random.Random(-40.0f, 40.0f), GetPosition().y, m_Random.Random(-40.0f, 40.0f)); 
 	}
 }
 
@@ -571,7 +542,10 @@ bool CTankEntity::Death(float frameTime)
 
 CVector3 CTankEntity::SelectWaypoint()
 {
-	return EntityManager.GetPatrolPoints(m_Team).PatrolPoints; // Gets a patrol point from the entity manager
+	// Gets a patrol point from the entity manager, stays at the current target if the team has none
+	CVector3 point = m_Target;
+	EntityManager.PatrolPoints().SelectPoint(m_Team, GetPosition(), m_Random, m_PatrolVisits, &point);
+	return point;
 }
 
 
@@ -11,7 +11,10 @@ using namespace std;
 
 #include "Defines.h"
 #include "CVector3.h"
+#include "CRandom.h"
 #include "Entity.h"
+#include "Messenger.h"
+#include "PatrolPoints.h"
 
 namespace gen
 {
@@ -33,10 +36,10 @@ public:
 	// turn speed and passes the other parameters to construct the base class
 	CTankTemplate
 	(
-		const string& type, const string& name, const string& meshFilename,
+		const string& type, const string& name, CMesh* mesh,
 		TFloat32 maxSpeed, TFloat32 acceleration, TFloat32 turnSpeed,
 		TFloat32 turretTurnSpeed, TUInt32 maxHP, TUInt32 shellDamage
-	) : CEntityTemplate( type, name, meshFilename )
+	) : CEntityTemplate( type, name, mesh )
 	{
 		// Set tank template values
 		m_MaxSpeed = maxSpeed;
@@ -131,7 +134,9 @@ public:
 		const string&   name = "",
 		const CVector3& position = CVector3::kOrigin, 
 		const CVector3& rotation = CVector3( 0.0f, 0.0f, 0.0f ),
-		const CVector3& scale = CVector3( 1.0f, 1.0f, 1.0f )
+		const CVector3& scale = CVector3( 1.0f, 1.0f, 1.0f ),
+		CMatrixArena*   matrixArena = 0,
+		TUInt32         matrixSlot = 0
 	);
 
 	// No destructor needed
@@ -216,6 +221,9 @@ private:
 	/////////////////////////////////////
 	// Functions
 
+	// Set state variables based on a received message
+	void HandleMessage(const SMessage& msg, float frameTime);
+
 	void Patrol(float frameTime);
 	void Aim(float frameTime);
 	void Evade(float frameTime);
@@ -253,6 +261,10 @@ private:
 
 	const TFloat32 m_HelpTimerMax = 3.0f;
 
+	// Random number generator for this tank's decisions, seeded from the entity manager's seed
+	// and the tank's UID. Declared before the data it initialises
+	CRandom m_Random;
+
 	// Tank data
 	TUInt32  m_Team;  // Team number for tank (to know who the enemy is)
 	TUInt32  m_ShellsShot = 0;  
@@ -275,13 +287,20 @@ private:
 	bool m_Fired = false;
 	bool m_IsSelected = false;
 
-	CVector3 m_PtOne = { Random(-30, 30), Position().y, Random(-30, 30) };
-	CVector3 m_PtTwo = { Random(-30, 30), Position().y, Random(-30, 30) };
+	CVector3 m_PtOne = { m_Random.Random(-30, 30), GetPosition().y, m_Random.Random(-30, 30) };
+	CVector3 m_PtTwo = { m_Random.Random(-30, 30), GetPosition().y, m_Random.Random(-30, 30) };
 	CVector3 m_Target = m_PtOne;
 	CVector3 m_EnemyTarget;
 
 	CVector3 m_NearestAmmoTarget;
 
+	// Patrol points visited, for the nearest unvisited patrol policy
+	CPatrolVisits m_PatrolVisits;
+
+	// Interned template type IDs for entity queries
+	TUInt32 m_TankTypeID;
+	TUInt32 m_AmmoBoxTypeID;
+
 	bool test = false;
 
 	CCamera* m_ChaseCam;
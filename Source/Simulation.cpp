@@ -0,0 +1,259 @@
+/*******************************************
+	Simulation.cpp
+
+	Scene simulation (entities, AI and game
+	rules) - shared by the windowed and
+	headless applications, no DirectX
+********************************************/
+
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CRandom.h"
+#include "EntityManager.h"
+#include "Messenger.h"
+#include "ParseLevel.h"
+#include "Simulation.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+
+const float ammoMaxSpawnTime = 30.0f;
+const float ammoMinSpawnTime = 20.0f;
+
+// Score needed by a team to win the game
+const int WinningScore = 3;
+
+// Fixed time step for the simulation when driven by frame times, and the most steps that are
+// run for a single frame
+const float SimulationStepTime = 1.0f / 60.0f;
+const TUInt32 MaxStepsPerFrame = 5;
+
+// Number of random trees created
+const int NumTrees = 100;
+
+// Random number streams for the parts of the simulation that use random numbers. Entities use
+// their UID as their stream, so these are numbered above the range of UIDs
+const TUInt64 LevelRandomStream   = 0x100000000ull;
+const TUInt64 SceneryRandomStream = LevelRandomStream + 1;
+const TUInt64 AmmoRandomStream    = LevelRandomStream + 2;
+
+
+//-----------------------------------------------------------------------------
+// Global game/scene variables
+//-----------------------------------------------------------------------------
+
+// Messenger class for sending messages to and between entities
+extern CMessenger Messenger;
+
+// Random number generators for level loading, scenery and ammo spawning
+CRandom LevelRandom;
+CRandom SceneryRandom;
+CRandom AmmoRandom;
+
+// Entity manager
+CEntityManager EntityManager;
+CParseLevel LevelParser(&EntityManager, &LevelRandom);
+
+// Tank UIDs
+TEntityUID TankA;
+TEntityUID TankB;
+
+float ammoSpawnTimer = ammoMaxSpawnTime;
+
+bool gameOver = false;
+string winningTeam = "";
+
+// Frame time not yet simulated, always less than one step after StepSimulation
+float stepAccumulator = 0.0f;
+
+
+//-----------------------------------------------------------------------------
+// Simulation management
+//-----------------------------------------------------------------------------
+
+// Load the level and create the scenery, tanks and other entities, and start the threads used
+// to update entities. Pass the seed for all random numbers used by the simulation - the same
+// seed and inputs give the same results, whatever the number of threads - and the total number
+// of update threads, or 0 for one per hardware thread. Returns false on failure
+bool SimulationSetup( const string& levelFile, TUInt64 seed, TUInt32 numThreads /*= 0*/ )
+{
+	LevelRandom.Seed( seed, LevelRandomStream );
+	SceneryRandom.Seed( seed, SceneryRandomStream );
+	AmmoRandom.Seed( seed, AmmoRandomStream );
+	EntityManager.SetRandomSeed( seed );
+	stepAccumulator = 0.0f;
+	ammoSpawnTimer = ammoMaxSpawnTime;
+	gameOver = false;
+	winningTeam = "";
+
+	// Start the update threads first, they are also used to load the level's meshes in parallel
+	EntityManager.StartThreads( numThreads );
+
+	//////////////////////////////////////////
+	// Create scenery templates and entities
+	if (!LevelParser.ParseFile(levelFile))
+	{
+		return false;
+	}
+
+	// Some random trees, the random positions and angles are generated together
+	TFloat32 treeX[NumTrees];
+	TFloat32 treeZ[NumTrees];
+	TFloat32 treeAngle[NumTrees];
+	SceneryRandom.Random( -200.0f, 30.0f, treeX, NumTrees );
+	SceneryRandom.Random( 40.0f, 150.0f, treeZ, NumTrees );
+	SceneryRandom.Random( 0.0f, 2.0f * kfPi, treeAngle, NumTrees );
+	for (int tree = 0; tree < NumTrees; ++tree)
+	{
+		EntityManager.CreateEntity( "Tree", "Tree", CVector3(treeX[tree], 0.0f, treeZ[tree]),
+			                        CVector3(0.0f, treeAngle[tree], 0.0f) );
+	}
+
+	return true;
+}
+
+
+// Destroy all entities and templates and stop the update threads
+void SimulationShutdown()
+{
+	EntityManager.StopThreads();
+	EntityManager.DestroyAllEntities();
+	EntityManager.DestroyAllTemplates();
+	EntityManager.PatrolPoints().Clear();
+}
+
+
+//-----------------------------------------------------------------------------
+// Game Helper functions
+//-----------------------------------------------------------------------------
+
+// Get UID of tank A (team 0) or B (team 1)
+TEntityUID GetTankUID(int team)
+{
+	return (team == 0) ? TankA : TankB;
+}
+
+// Returns true once a team has reached the winning score
+bool IsGameOver()
+{
+	return gameOver;
+}
+
+// Name of the winning team ("One" or "Two"), empty if game not over
+const string& GetWinningTeam()
+{
+	return winningTeam;
+}
+
+
+//-----------------------------------------------------------------------------
+// Simulation update
+//-----------------------------------------------------------------------------
+
+// Update all entities and game rules by the given time step
+void UpdateSimulation( float updateTime )
+{
+	// Make the messages sent last tick available to the entities
+	Messenger.DeliverMessages();
+
+	// Call all entity update functions
+	EntityManager.UpdateAllEntities(updateTime);
+	SpawnAmmoBox(updateTime); // Call the spawn functions
+
+	// Sets the game over state depending on what team has won
+	if (EntityManager.GetTeamOneScore() >= WinningScore)
+	{
+		SetTanksInactive();
+		winningTeam = "One";
+		gameOver = true;
+		DestroyLoserTanks(1);
+	}
+	else if (EntityManager.GetTeamTwoScore() >= WinningScore)
+	{
+		SetTanksInactive();
+		winningTeam = "Two";
+		gameOver = true;
+		DestroyLoserTanks(0);
+	}
+}
+
+// Advance the simulation by the given frame time in fixed steps, carrying any remaining time over
+// to the next frame. Simulation results do not depend on the frame rate. If a frame is too
+// slow for the maximum number of steps to catch up, the extra time is dropped (the simulation
+// runs slower than real time) rather than making the next frame slower still. Returns the
+// number of steps run
+TUInt32 StepSimulation( float frameTime )
+{
+	stepAccumulator += frameTime;
+	TUInt32 numSteps = 0;
+	while (stepAccumulator >= SimulationStepTime)
+	{
+		if (numSteps == MaxStepsPerFrame)
+		{
+			stepAccumulator = 0.0f;
+			break;
+		}
+		UpdateSimulation( SimulationStepTime );
+		stepAccumulator -= SimulationStepTime;
+		++numSteps;
+	}
+	return numSteps;
+}
+
+// Return how far the time simulated by StepSimulation has passed the latest step, as a
+// fraction of a step (0 to 1). Used to render entities between their previous and latest
+// positions
+float SimulationInterpolation()
+{
+	return stepAccumulator / SimulationStepTime;
+}
+
+// Send the start message to all tanks
+void StartTanks()
+{
+	SMessage msg;
+	msg.type = Msg_Start;
+	msg.from = SystemUID;
+	Messenger.BroadcastMessage(msg);
+}
+
+void SpawnAmmoBox(float updateTime)
+{
+	// Spawns the ammo box every couple seconds between min time and max time at random position
+	if (ammoSpawnTimer < 0.0f)
+	{
+		EntityManager.CreateAmmoBox("AmmoBox", "AmmoBox", CVector3(AmmoRandom.Random(-30.0f, 30.0f), 30.0f, AmmoRandom.Random(-30.0f, 30.0f)));
+		ammoSpawnTimer = AmmoRandom.Random(ammoMinSpawnTime, ammoMaxSpawnTime);
+	}
+	else
+	{
+		ammoSpawnTimer -= updateTime;
+	}
+}
+
+void SetTanksInactive()
+{
+	// Sets all the tanks to inactive
+	SMessage msg;
+	msg.type = Msg_Inactive;
+	msg.from = SystemUID;
+	Messenger.BroadcastMessage(msg);
+}
+
+void DestroyLoserTanks(int team)
+{
+	// Destroy all loser tanks if they exist
+	SMessage msg;
+	msg.type = Msg_Death;
+	msg.from = SystemUID;
+	Messenger.SendTeamMessage(team, msg);
+}
+
+} // namespace gen
@@ -0,0 +1,65 @@
+/*******************************************
+	Simulation.h
+
+	Scene simulation (entities, AI and game
+	rules) - shared by the windowed and
+	headless applications, no DirectX
+********************************************/
+
+#pragma once
+
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+///////////////////////////////
+// Simulation management
+
+// Load the level and create the scenery, tanks and other entities, and start the threads used
+// to update entities. Pass the seed for all random numbers used by the simulation - the same
+// seed and inputs give the same results, whatever the number of threads - and the total number
+// of update threads, or 0 for one per hardware thread. Returns false on failure
+bool SimulationSetup( const string& levelFile, TUInt64 seed, TUInt32 numThreads = 0 );
+
+// Destroy all entities and templates and stop the update threads
+void SimulationShutdown();
+
+///////////////////////////////
+// Simulation update
+
+// Update all entities and game rules by the given time step
+void UpdateSimulation( float updateTime );
+
+// Advance the simulation by the given frame time in fixed steps, carrying any remaining time over
+// to the next frame. A limited number of steps are run for one frame, any time beyond that is
+// dropped. Returns the number of steps run
+TUInt32 StepSimulation( float frameTime );
+
+// Return how far the time simulated by StepSimulation has passed the latest step, as a
+// fraction of a step (0 to 1). Used to render entities between their previous and latest
+// positions
+float SimulationInterpolation();
+
+// Send the start message to all tanks
+void StartTanks();
+
+void SpawnAmmoBox(float updateTime);
+
+void SetTanksInactive();
+
+void DestroyLoserTanks(int team);
+
+///////////////////////////////
+// Game state
+
+// Returns true once a team has reached the winning score
+bool IsGameOver();
+
+// Name of the winning team ("One" or "Two"), empty if game not over
+const string& GetWinningTeam();
+
+} // namespace gen
@@ -4,8 +4,10 @@
 	Shell scene and game functions
 ********************************************/
 
+#include <time.h>
 #include <sstream>
 #include <string>
+#include <vector>
 using namespace std;
 
 #include <d3d10.h>
@@ -18,7 +20,7 @@ using namespace std;
 #include "EntityManager.h"
 #include "Messenger.h"
 #include "TankAssignment.h"
-#include "ParseLevel.h"
+#include "Simulation.h"
 
 namespace gen
 {
@@ -58,19 +60,14 @@ extern TUInt32 MouseY;
 // Messenger class for sending messages to and between entities
 extern CMessenger Messenger;
 
+// Entity manager from Simulation.cpp
+extern CEntityManager EntityManager;
+
 
 //-----------------------------------------------------------------------------
 // Global game/scene variables
 //-----------------------------------------------------------------------------
 
-// Entity manager
-CEntityManager EntityManager;
-CParseLevel LevelParser(&EntityManager);
-
-// Tank UIDs
-TEntityUID TankA;
-TEntityUID TankB;
-
 // Other scene elements
 const int NumLights = 2;
 CLight*  Lights[NumLights];
@@ -85,22 +82,21 @@ int NumUpdateTimes = 0;
 float AverageUpdateTime = -1.0f; // Invalid value at first
 
 bool ShowText = false;
-bool gameOver = false;
-
-const float ammoMaxSpawnTime = 30.0f;
-const float ammoMinSpawnTime = 20.0f;
-float ammoSpawnTimer = ammoMaxSpawnTime;
-
-int teamOneScore = 0;
-int teamTwoScore = 0;
-
-string winningTeam = "";
 
 vector<CTankEntity*> TankArray;
 int tankCounter = 0;
 
 CTankEntity* NearestEntity = 0;
 CTankEntity* SelectedEntity = 0;
+
+// Entities being given text labels, with their world positions and pixel coordinates. Kept
+// between frames so the arrays are only reallocated when the number of entities grows
+vector<CEntity*> LabelEntities;
+vector<CVector3> LabelWorldPts;
+vector<TInt32>   LabelX;
+vector<TInt32>   LabelY;
+vector<TUInt32>  LabelVisible;
+
 //-----------------------------------------------------------------------------
 // Scene management
 //-----------------------------------------------------------------------------
@@ -113,20 +109,13 @@ bool SceneSetup()
 	InitialiseMethods();
 	InitInput();
 
-	srand(time(NULL));
 	//////////////////////////////////////////
 	// Create scenery templates and entities
-	LevelParser.ParseFile("Scene.xml");
-
-	for (int tree = 0; tree < 100; ++tree)
+	// A different battle each time the game is run
+	if (!SimulationSetup("Scene.xml", time(NULL)))
 	{
-		
-		// Some random trees
-		EntityManager.CreateEntity( "Tree", "Tree",
-			                        CVector3(Random(-200.0f, 30.0f), 0.0f, Random(40.0f, 150.0f)),
-			                        CVector3(0.0f, Random(0.0f, 2.0f * kfPi), 0.0f) );
+		return false;
 	}
-	
 
 	/////////////////////////////
 	// Camera / light setup
@@ -167,19 +156,7 @@ void SceneShutdown()
 
 	TankArray.clear();
 	// Destroy all entities
-	EntityManager.DestroyAllEntities();
-	EntityManager.DestroyAllTemplates();
-}
-
-
-//-----------------------------------------------------------------------------
-// Game Helper functions
-//-----------------------------------------------------------------------------
-
-// Get UID of tank A (team 0) or B (team 1)
-TEntityUID GetTankUID(int team)
-{
-	return (team == 0) ? TankA : TankB;
+	SimulationShutdown();
 }
 
 
@@ -216,8 +193,8 @@ void RenderScene( float updateTime )
 	SetAmbientLight(AmbientLight);
 	SetLights(&Lights[0]);
 
-	// Render entities and draw on-screen text
-	EntityManager.RenderAllEntities();
+	// Render entities, interpolated between the latest two simulation steps, and draw on-screen text
+	EntityManager.RenderAllEntities( SimulationInterpolation() );
 	RenderSceneText( updateTime );
 
     // Present the backbuffer contents to the display
@@ -241,6 +218,31 @@ void RenderText( const string& text, int X, int Y, float r, float g, float b, bo
 	}
 }
 
+// Find the pixel coordinates of all entities of the given template type, filling the label
+// arrays. All the entity positions are projected in one batch. Returns the number of entities
+// that are not behind the camera, their indices are at the start of LabelVisible
+TUInt32 ProjectEntities( const string& templateType )
+{
+	LabelEntities.clear();
+	LabelWorldPts.clear();
+	for (CEntity* entity : EntityManager.QueryEntities( templateType ))
+	{
+		LabelEntities.push_back( entity );
+		LabelWorldPts.push_back( entity->GetPosition() );
+	}
+	if (LabelEntities.empty())
+	{
+		return 0;
+	}
+
+	TUInt32 numLabels = static_cast<TUInt32>(LabelEntities.size());
+	LabelX.resize( numLabels );
+	LabelY.resize( numLabels );
+	LabelVisible.resize( numLabels );
+	return MainCamera->PixelsFromWorldPts( &LabelWorldPts[0], numLabels, ViewportWidth, ViewportHeight,
+	                                       &LabelX[0], &LabelY[0], &LabelVisible[0] );
+}
+
 // Render on-screen text each frame
 void RenderSceneText( float updateTime )
 {
@@ -271,94 +273,75 @@ void RenderSceneText( float updateTime )
 	outText.str("");
 	
 	// Displays game over text
-	if (gameOver)
+	if (IsGameOver())
 	{
-		outText << "Team " << winningTeam << " Wins!";
+		outText << "Team " << GetWinningTeam() << " Wins!";
 		RenderText(outText.str(), 500, 500, 0.0f, 0.0f, 0.0f);
 		RenderText(outText.str(), 498, 498, 1.0f, 1.0f, 0.0f);
 		outText.str("");
 	}
 	
 	// Displays text for the tanks
-	CEntity* entity;
-	int x, y;
-	EntityManager.BeginEnumEntities("", "", "Tank");
-	while (entity = EntityManager.EnumEntity())
+	TUInt32 numVisible = ProjectEntities( "Tank" );
+	for (TUInt32 visible = 0; visible < numVisible; ++visible)
 	{
-		CTankEntity* TEntity = static_cast<CTankEntity*>(entity);
+		TUInt32 label = LabelVisible[visible];
+		CTankEntity* TEntity = static_cast<CTankEntity*>(LabelEntities[label]);
+		TInt32 x = LabelX[label];
+		TInt32 y = LabelY[label];
 
-		if (TEntity != nullptr)
+		outText << TEntity->GetName();
+
+		if (ShowText)
 		{
+			outText << "\n" << TEntity->GetState()		<< "\nHP: " << TEntity->GetHealth() 
+					<< "\nShot: " << TEntity->GetShellsShot() << "\nAmmo: " << TEntity->GetShellsAmmo();
 
-			if (MainCamera->PixelFromWorldPt(TEntity->Position(), ViewportWidth, ViewportHeight, &x, &y))
-			{
-				
-				outText << TEntity->GetName();
-
-				if (ShowText)
-				{
-					outText << "\n" << TEntity->GetState()		<< "\nHP: " << TEntity->GetHealth() 
-							<< "\nShot: " << TEntity->GetShellsShot() << "\nAmmo: " << TEntity->GetShellsAmmo();
-
-				}
-				if (TEntity == NearestEntity)
-				{
-					RenderText(outText.str(), x, y, 0.5f, 0.5f, 0.0f, true);
-					RenderText(outText.str(), x - 2, y - 2, 1.0f, 0.0f, 0.0f, true);
-					outText.str("");
-				}
-				else
-				{
-					RenderText(outText.str(), x, y, 0.0f, 0.0f, 0.0f, true);
-					RenderText(outText.str(), x - 2, y - 2, 1.0f, 1.0f, 0.0f, true);
-					outText.str("");
-				}
-			}
 		}
-	}
-	EntityManager.EndEnumEntities();
-
-	// Displays text for the ammo boxes
-	EntityManager.BeginEnumEntities("", "", "AmmoBox");
-	while (entity = EntityManager.EnumEntity())
-	{
-		CAmmoBoxEntity* AEntity = static_cast<CAmmoBoxEntity*>(entity);
-		if (AEntity != nullptr && MainCamera->PixelFromWorldPt(AEntity->Position(), ViewportWidth, ViewportHeight, &x, &y))
+		if (TEntity == NearestEntity)
+		{
+			RenderText(outText.str(), x, y, 0.5f, 0.5f, 0.0f, true);
+			RenderText(outText.str(), x - 2, y - 2, 1.0f, 0.0f, 0.0f, true);
+			outText.str("");
+		}
+		else
 		{
-			outText << "Ammo Box";
-			RenderText(outText.str(), x, y - 40, 0.0f, 0.0f, 0.0f, true);
-			RenderText(outText.str(), x - 2, y - 42, 1.0f, 1.0f, 0.0f, true);
+			RenderText(outText.str(), x, y, 0.0f, 0.0f, 0.0f, true);
+			RenderText(outText.str(), x - 2, y - 2, 1.0f, 1.0f, 0.0f, true);
 			outText.str("");
 		}
 	}
-	EntityManager.EndEnumEntities();
 
-	// Mouse picking for selecting the nearest tank
+	// Mouse picking for selecting the nearest tank, reusing the tank pixel coordinates from above
 	NearestEntity = 0;
-	TInt32 X, Y;
 	float nearestDistance = 50.0f;
-	EntityManager.BeginEnumEntities("", "", "Tank");
-	while (entity = EntityManager.EnumEntity())
+	CVector2 MousePixel = { (float)MouseX, (float)MouseY };
+	for (TUInt32 visible = 0; visible < numVisible; ++visible)
 	{
-		CTankEntity* TEntity = static_cast<CTankEntity*>(entity);
-		if (TEntity != nullptr)
-		{
+		TUInt32 label = LabelVisible[visible];
+		CVector2 entityPixel = { (float)LabelX[label], (float)LabelY[label] };
 
-			if (MainCamera->PixelFromWorldPt(entity->Position(), ViewportWidth, ViewportHeight, &X, &Y))
-			{
-				CVector2 MousePixel = { (float)MouseX, (float)MouseY };
-				CVector2 entityPixel = { (float)X,(float)Y };
-
-				float pixelDistance = Distance(MousePixel, entityPixel);
-				if (pixelDistance < nearestDistance)
-				{
-					NearestEntity = TEntity;
-					nearestDistance = pixelDistance;
-				}
-			}
+		float pixelDistance = Distance(MousePixel, entityPixel);
+		if (pixelDistance < nearestDistance)
+		{
+			NearestEntity = static_cast<CTankEntity*>(LabelEntities[label]);
+			nearestDistance = pixelDistance;
 		}
 	}
-	EntityManager.EndEnumEntities();
+
+	// Displays text for the ammo boxes
+	numVisible = ProjectEntities( "AmmoBox" );
+	for (TUInt32 visible = 0; visible < numVisible; ++visible)
+	{
+		TUInt32 label = LabelVisible[visible];
+		TInt32 x = LabelX[label];
+		TInt32 y = LabelY[label];
+
+		outText << "Ammo Box";
+		RenderText(outText.str(), x, y - 40, 0.0f, 0.0f, 0.0f, true);
+		RenderText(outText.str(), x - 2, y - 42, 1.0f, 1.0f, 0.0f, true);
+		outText.str("");
+	}
 
 }
 
@@ -366,9 +349,8 @@ void RenderSceneText( float updateTime )
 // Update the scene between rendering
 void UpdateScene(float updateTime)
 {
-	// Call all entity update functions
-	EntityManager.UpdateAllEntities(updateTime);
-	SpawnAmmoBox(updateTime); // Call the spawn functions
+	// Update all entities and game rules in fixed steps, independent of the frame rate
+	StepSimulation(updateTime);
 
 	// Show or hide the text for the tanks
 	if (KeyHit(Key_0))
@@ -379,21 +361,7 @@ void UpdateScene(float updateTime)
 	// Starts the game
 	if (KeyHit(Key_1))
 	{
-		SMessage msg;
-		msg.type = Msg_Start;
-		msg.from = SystemUID;
-
-		CEntity* entity;
-		EntityManager.BeginEnumEntities("", "", "Tank");
-		while (entity = EntityManager.EnumEntity())
-		{
-			CTankEntity* TEntity = static_cast<CTankEntity*>(entity);
-
-			if (TEntity != nullptr)
-			{
-				Messenger.SendMessageA(TEntity->GetUID(), msg);
-			}
-		}
+		StartTanks();
 	}
 
 	// Deactives the tanks
@@ -403,10 +371,8 @@ void UpdateScene(float updateTime)
 	}
 
 	// Creates an array of all the tanks for going through the chase cams
-	CEntity* entity;
-	EntityManager.BeginEnumEntities("", "", "Tank");
 	TankArray.clear();
-	while (entity = EntityManager.EnumEntity())
+	for (CEntity* entity : EntityManager.QueryEntities("Tank"))
 	{
 		CTankEntity* TEntity = static_cast<CTankEntity*>(entity);
 
@@ -448,31 +414,13 @@ void UpdateScene(float updateTime)
 		MainCamera = LoopCamera; // Resets the main camera
 	}
 
-	// Sets the game over text depending on what team has won
-	if (EntityManager.GetTeamOneScore() >= 3.0f)
-	{
-		
-		SetTanksInactive();
-		winningTeam = "One";
-		gameOver = true;
-		DestroyLoserTanks(1);
-	}
-	else if (EntityManager.GetTeamTwoScore() >= 3.0f)
-	{
-		SetTanksInactive();
-		winningTeam = "Two";
-		gameOver = false;
-		DestroyLoserTanks(0);
-	}
-
-	
 	// Set the tank to an evade state when selected
 	if (KeyHit(Mouse_LButton) && NearestEntity != nullptr)
 	{
 		SMessage msg;
 		msg.type = Msg_Evade;
 		msg.from = SystemUID;
-		Messenger.SendMessageA(NearestEntity->GetUID(), msg);
+		Messenger.SendMessage(NearestEntity->GetUID(), msg);
 	}
 	
 	// Doesn't work correctly some missing code
@@ -486,7 +434,7 @@ void UpdateScene(float updateTime)
 
 			CVector3 rayDirection = mousePoint - MainCamera->Position();
 
-			SelectedEntity->SetTarget({ mousePoint.x, SelectedEntity->Position().y, mousePoint.z});
+			SelectedEntity->SetTarget({ mousePoint.x, SelectedEntity->GetPosition().y, mousePoint.z});
 			SelectedEntity->SetSelected(false);
 		}
 		if(NearestEntity != nullptr)
@@ -506,59 +454,4 @@ void UpdateScene(float updateTime)
 		CameraMoveSpeed * updateTime, CameraRotSpeed * updateTime);
 }
 
-void SpawnAmmoBox(float updateTime)
-{
-	// Spawns the ammo box every couple seconds between min time and max time at random position
-	if (ammoSpawnTimer < 0.0f)
-	{
-		EntityManager.CreateAmmoBox("AmmoBox", "AmmoBox", CVector3(Random(-30.0f, 30.0f), 30.0f, Random(-30.0f, 30.0f)));
-		ammoSpawnTimer = Random(ammoMinSpawnTime, ammoMaxSpawnTime);
-	}
-	else
-	{
-		ammoSpawnTimer -= updateTime;
-	}
-}
-
-void SetTanksInactive()
-{
-	// Sets all the tanks to inactive
-	SMessage msg;
-	msg.type = Msg_Inactive;
-	msg.from = SystemUID;
-
-	CEntity* entity;
-	EntityManager.BeginEnumEntities("", "", "Tank");
-	while (entity = EntityManager.EnumEntity())
-	{
-		CTankEntity* TEntity = static_cast<CTankEntity*>(entity);
-
-		if (TEntity != nullptr)
-		{
-			Messenger.SendMessageA(TEntity->GetUID(), msg);
-		}
-	}
-	EntityManager.EndEnumEntities();
-}
-
-void DestroyLoserTanks(int team)
-{
-	// Destroy all loser tanks if they exist
-	SMessage msg;
-	msg.type = Msg_Death;
-	msg.from = SystemUID;
-
-	CEntity* entity;
-	EntityManager.BeginEnumEntities("", "", "Tank");
-	while (entity = EntityManager.EnumEntity())
-	{
-		CTankEntity* TEntity = static_cast<CTankEntity*>(entity);
-
-		if (TEntity != nullptr && TEntity->GetTeam() == team)
-		{
-			Messenger.SendMessageA(TEntity->GetUID(), msg);
-		}
-	}
-}
-
 } // namespace gen
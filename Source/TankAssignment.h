@@ -30,10 +30,4 @@ void RenderSceneText( float updateTime );
 // Update the scene between rendering
 void UpdateScene( float updateTime );
 
-void SpawnAmmoBox(float updateTime);
-
-void SetTanksInactive();
-
-void DestroyLoserTanks(int team);
-
 } // namespace gen
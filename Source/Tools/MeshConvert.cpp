@@ -0,0 +1,166 @@
+/*******************************************
+	MeshConvert.cpp
+
+	Offline mesh converter - imports X-Files
+	and writes the binary mesh cache beside
+	each one (see MeshCache.h), so the game
+	can load meshes without parsing X-Files
+
+	Standalone console program, build from
+	this file, Source/Render/CImportXFile.cpp,
+	CImportXFileText.cpp, CXFileTokenizer.cpp,
+	MeshCache.cpp and RenderMethod.cpp, the
+	Source/Scene Camera.cpp and Light.cpp,
+	Source/UI/Input.cpp, the Source/Math
+	sources and the Source/Common sources
+	except GNUDefines.cpp. Link with the
+	DirectX 9 and 10 libraries as for the game.
+	Can also be built with GEN_HEADLESS
+	defined, using GNUDefines.cpp in place of
+	MSDefines.cpp and CTimer.cpp - then only
+	text X-Files can be converted
+
+	Usage:
+	  MeshConvert <file.x> [<file.x> ...]
+	Run again whenever an X-File changes - the
+	game ignores caches older than their
+	X-File
+********************************************/
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#ifndef GEN_HEADLESS
+#include <d3d10.h>
+#endif
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CImportXFile.h"
+#include "MeshCache.h"
+#include "RenderMethod.h"
+
+namespace gen
+{
+
+#ifndef GEN_HEADLESS
+// The render method code is shared with the game, which expects a device. Only the render method
+// information functions are used here, which do not need it
+ID3D10Device* g_pd3dDevice = 0;
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Conversion
+//-----------------------------------------------------------------------------
+
+// Import an X-File and write its binary cache, returns true on success. Sub-meshes are prepared
+// exactly as CMesh::Load does - split by material, with tangents for render methods that use them
+bool ConvertMesh( const string& fileName )
+{
+	CImportXFile importFile;
+	if (!importFile.IsXFile( fileName ) || importFile.ImportFile( fileName ) != kSuccess)
+	{
+		cerr << "Error importing " << fileName << endl;
+		return false;
+	}
+
+	TUInt32 numNodes = importFile.GetNumNodes();
+	vector<SMeshNode> nodes( numNodes );
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		importFile.GetNode( node, &nodes[node] );
+	}
+
+	TUInt32 numMaterials = importFile.GetNumMaterials();
+	vector<SMeshMaterial> materials( numMaterials );
+	for (TUInt32 material = 0; material < numMaterials; ++material)
+	{
+		importFile.GetMaterial( material, &materials[material] );
+	}
+
+	// Sub-mesh data is allocated by the import class, released after writing
+	TUInt32 numSubMeshes = importFile.GetNumSubMeshes();
+	vector<SSubMesh> subMeshes( numSubMeshes );
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		bool needTangents = RenderMethodUsesTangents( importFile.GetSubMeshRenderMethod( subMesh ) );
+		if (importFile.GetSubMesh( subMesh, &subMeshes[subMesh], needTangents ) != kSuccess)
+		{
+			cerr << "Error importing " << fileName << endl;
+			for (TUInt32 created = 0; created < subMesh; ++created)
+			{
+				delete[] subMeshes[created].vertices;
+				delete[] subMeshes[created].faces;
+			}
+			return false;
+		}
+	}
+
+	// Calculate bounds as CMesh::PreProcess, rejecting the same meshes
+	bool valid = (numNodes > 0 && numSubMeshes > 0);
+	CVector3 minBounds, maxBounds;
+	TFloat32 boundingRadius = 0.0f;
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes && valid; ++subMesh)
+	{
+		if (subMeshes[subMesh].numVertices == 0)
+		{
+			valid = false;
+			break;
+		}
+		if (subMesh == 0)
+		{
+			TFloat32* firstVertex = reinterpret_cast<TFloat32*>(subMeshes[0].vertices);
+			minBounds = maxBounds = CVector3( firstVertex );
+			boundingRadius = minBounds.Length();
+		}
+		ExpandBounds( subMeshes[subMesh].vertices, subMeshes[subMesh].vertexSize,
+		              subMeshes[subMesh].numVertices, &minBounds, &maxBounds, &boundingRadius );
+	}
+
+	string cacheFileName = MeshCacheFileName( fileName );
+	bool saved = valid && SaveMeshCache( cacheFileName, &nodes[0], numNodes,
+	                                     numMaterials > 0 ? &materials[0] : 0, numMaterials,
+	                                     &subMeshes[0], numSubMeshes, minBounds, maxBounds, boundingRadius );
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		delete[] subMeshes[subMesh].vertices;
+		delete[] subMeshes[subMesh].faces;
+	}
+	if (!saved)
+	{
+		cerr << "Error writing " << cacheFileName << endl;
+		return false;
+	}
+	cout << fileName << " -> " << cacheFileName << endl;
+	return true;
+}
+
+
+} // namespace gen
+
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+int main( int argc, char* argv[] )
+{
+	if (argc < 2)
+	{
+		cerr << "Usage: MeshConvert <file.x> [<file.x> ...]" << endl;
+		return 1;
+	}
+
+	int numFailed = 0;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (!gen::ConvertMesh( argv[arg] ))
+		{
+			++numFailed;
+		}
+	}
+	return numFailed > 0 ? 1 : 0;
+}